@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+
+namespace MrcInspector
+{
+
+/**
+ * @brief Heap buffer whose address is aligned to the given boundary, 
+ * as required for O_DIRECT transfers
+ */
+class AlignedBuffer
+{
+public:
+    AlignedBuffer() = default;
+    AlignedBuffer(size_t size, size_t alignment)
+        : m_data(allocate(size, alignment))
+        , m_size(m_data ? size : 0)
+    {
+    }
+
+    AlignedBuffer(AlignedBuffer&& other) = default;
+    AlignedBuffer& operator=(AlignedBuffer&& other) = default;
+
+    std::byte* data()
+    {
+        return m_data.get();
+    }
+
+    const std::byte* data() const
+    {
+        return m_data.get();
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    struct Deleter
+    {
+        void operator()(std::byte* ptr) const
+        {
+            std::free(ptr);
+        }
+    };
+
+    std::unique_ptr<std::byte, Deleter> m_data;
+    size_t                              m_size = 0;
+
+    static std::byte* allocate(size_t size, size_t alignment)
+    {
+        //aligned_alloc requires the size to be a multiple of the alignment
+        const auto alignedSize = (size + alignment - 1) / alignment * alignment;
+        return static_cast<std::byte*>(std::aligned_alloc(alignment, alignedSize));
+    }
+};
+
+}
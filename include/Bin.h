@@ -0,0 +1,59 @@
+#pragma once
+
+#include "MainHeader.h"
+#include "Statistics.h"
+
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/**
+ * @brief Returns the mode of the binned data. Real modes are binned 
+ * into float32 and complex modes into complex float32
+ */
+Mode getBinnedMode(Mode mode);
+
+/**
+ * @brief Returns the header of the volume binned by the given factor.
+ * Its statistics need to be updated after binning the data
+ */
+MainHeader makeBinnedHeader(const MainHeader& header, size_t factor);
+
+/**
+ * @brief Averages factor x factor x factor blocks of the data block, reading 
+ * it section by section and writing each binned section as soon as it is 
+ * completed. Blocks on the edges are averaged over the voxels they contain.
+ * At most a section and a binned section are held in memory.
+ * Returns the number of bytes written
+ */
+size_t binData( std::istream& is, 
+                const MainHeader& header, 
+                size_t factor,
+                std::ostream& os, 
+                size_t threadCount,
+                Statistics& statistics );
+
+/**
+ * @brief Called with the index of the level and each binned section once
+ * it is completed. Returns false to stop binning
+ */
+using BinnedSectionCallback = std::function<bool(size_t level, const DataBlock& binned)>;
+
+/**
+ * @brief Bins the data block by several factors in a single pass, reading
+ * it section by section. Each source section is accumulated into every
+ * level, so a binned section is held in memory per level. Statistics are
+ * accumulated per level. Returns the number of sections read
+ */
+size_t binDataLevels(   std::istream& is, 
+                        const MainHeader& header, 
+                        const std::vector<size_t>& factors,
+                        size_t threadCount,
+                        const BinnedSectionCallback& callback,
+                        std::vector<Statistics>& statistics );
+
+}
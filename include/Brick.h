@@ -0,0 +1,81 @@
+#pragma once
+
+#include "MainHeader.h"
+#include "Region.h"
+#include "FileStamp.h"
+
+#include <array>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace MrcInspector
+{
+
+/**
+ * Brick cache layout. Integers of the header are little endian:
+ *  - Header: "MRCB" magic, version (u32), brick size (u32), mode (u32),
+ *    dimensions (3 x u32), byte order stamp (as in MRC), size (u64) and
+ *    modification time (i64, ns) of the source file, zero padded to 4KiB
+ *  - Bricks: cubes of brick size^3 voxels in native byte order, ordered
+ *    x-fastest, then y, then z. Bricks on the edges are zero padded
+ */
+
+constexpr size_t DEFAULT_BRICK_SIZE = 32;
+constexpr size_t BRICK_CACHE_HEADER_SIZE = 4096;
+
+struct BrickCache
+{
+    size_t                      brickSize;      ///< Voxels along each side of a brick
+    Mode                        mode;           ///< Mode of the voxels
+    std::array<size_t, 3>       dimensions;     ///< Dimensions of the volume (x, y, z)
+    FileStamp                   source;         ///< Stamp of the file the cache was built from
+};
+
+/**
+ * @brief Returns the path of the brick cache of the given file
+ */
+std::string getBrickCachePath(const char* path);
+
+/**
+ * @brief Builds the brick cache from the data block read from the stream,
+ * one slab of brickSize sections at a time. The bricks of each slab are
+ * assembled in parallel. Holds a slab and its bricks in memory.
+ * Returns the amount of bytes of the data block read, 0 on error
+ */
+size_t buildBrickCache( std::istream& is,
+                        const MainHeader& header,
+                        size_t brickSize,
+                        const FileStamp& source,
+                        std::ostream& os,
+                        size_t threadCount );
+
+/**
+ * @brief Reads the header of a brick cache. False if it is not a brick cache
+ * or it was built on a machine of a different byte order
+ */
+bool readBrickCacheHeader(std::istream& is, BrickCache& cache);
+
+/**
+ * @brief Returns true if the cache matches the header and stamp of the source file
+ */
+bool isBrickCacheValid(const BrickCache& cache, const MainHeader& header, const FileStamp& source);
+
+/**
+ * @brief Reads a region from the brick cache, touching only the bricks it
+ * intersects. Bricks that are contiguous along x are read at once. Values
+ * are typed as those of the file the cache was built from, given its header.
+ * Returns the amount of bytes of the region read, 0 on error
+ */
+size_t readBrickRegion(std::istream& is, const BrickCache& cache, const MainHeader& header, const Region& region, DataBlock& data);
+
+/**
+ * @brief Reads a region of the file, from its brick cache if it is up to date
+ * and from the stream otherwise, which must be at the start of the data block.
+ * Regions made of whole sections are always read from the stream, where they
+ * are contiguous.
+ * Returns the amount of bytes of the region read, 0 on error
+ */
+size_t readCachedRegion(const char* path, std::istream& is, const MainHeader& header, const Region& region, DataBlock& data);
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "DataTypes.h"
+#include "Endianess.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+namespace MrcInspector
+{
+
+template<typename T>
+inline void swapEndianess(T& value)
+{
+    static_assert(std::is_scalar<T>::value, "Type must be a scalar type");
+
+    //Swap its endianess in place (reverse bytes)
+    auto* first = reinterpret_cast<std::byte*>(&value);
+    auto* last = first + sizeof(T);
+    std::reverse(first, last);
+}
+
+template<typename T>
+inline void swapEndianess(std::complex<T>& value)
+{
+    //Swap the endianess for each of the components
+    swapEndianess(reinterpret_cast<T*>(&value)[0]);
+    swapEndianess(reinterpret_cast<T*>(&value)[1]);
+}
+
+inline void swapEndianess(half_float::half& value)
+{
+    swapEndianess(reinterpret_cast<uint16&>(value));
+}
+
+template<typename T>
+inline void makeBigEndian(T& value)
+{
+    #if BYTE_ORDER == LITTLE_ENDIAN
+        swapEndianess(value);
+    #else
+        (void)value; //No-op
+    #endif
+}
+
+template<typename T>
+inline void makeLittleEndian(T& value)
+{
+    #if BYTE_ORDER == BIG_ENDIAN
+        swapEndianess(value);
+    #else
+        (void)value; //No-op
+    #endif
+}
+
+template<typename T>
+using MakeEndianFunc = void (*)(T&);
+
+template<typename T>
+inline MakeEndianFunc<T> getMakeEndianFunc(Endianess endianess)
+{
+    switch (endianess)
+    {
+    case Endianess::be: return makeBigEndian<T>;
+    case Endianess::le: return makeLittleEndian<T>;
+    default:            return nullptr;
+    }
+}
+
+/**
+ * @brief Reverses the bytes of each of the count words of the given width.
+ * Written as a plain loop over fixed widths so that the compiler can vectorize it
+ */
+inline void swapEndianess(std::byte* data, size_t count, size_t width)
+{
+    switch (width)
+    {
+    case 2:
+        for(size_t i = 0; i < count; ++i)
+        {
+            std::swap(data[2*i+0], data[2*i+1]);
+        }
+        break;
+    case 4:
+        for(size_t i = 0; i < count; ++i)
+        {
+            std::swap(data[4*i+0], data[4*i+3]);
+            std::swap(data[4*i+1], data[4*i+2]);
+        }
+        break;
+    case 8:
+        for(size_t i = 0; i < count; ++i)
+        {
+            std::reverse(data + 8*i, data + 8*(i+1));
+        }
+        break;
+    default:
+        break; //Nothing to swap
+    }
+}
+
+/**
+ * @brief Returns true if data stored with the given endianess needs
+ * to be swapped in order to match the native endianess
+ */
+constexpr bool needsSwap(Endianess endianess)
+{
+    #if BYTE_ORDER == LITTLE_ENDIAN
+        return endianess == Endianess::be;
+    #else
+        return endianess == Endianess::le;
+    #endif
+}
+
+/**
+ * @brief Returns the byte order stamp of the files written by this machine
+ */
+constexpr Endianess getNativeEndianess()
+{
+    #if BYTE_ORDER == LITTLE_ENDIAN
+        return Endianess::le_le_le_le;
+    #else
+        return Endianess::be_be_be_be;
+    #endif
+}
+
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "MainHeader.h"
+#include "FileStamp.h"
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/**
+ * Catalog layout. All integers are little endian:
+ *  - Header: "MRCI" magic, version (u32), row count (u64), column count (u32), reserved (u32)
+ *  - Column directory: name (16B, zero padded), type (u32), reserved (u32)
+ *    and offset (u64) of each column
+ *  - Paths: offsets of each path in the blob (u64, row count + 1), then the blob
+ *  - Columns: row count values of the width of their type
+ *
+ * Columns can be read on their own, so queries only touch the columns they use
+ */
+
+enum class CatalogType : uint32
+{
+    u32,        ///< Unsigned 32bit integer
+    f32,        ///< 32bit floating point
+    u64,        ///< Unsigned 64bit integer
+    i64,        ///< Signed 64bit integer
+};
+
+struct CatalogField
+{
+    std::string_view            name;           ///< Name of the column
+    CatalogType                 type;           ///< Type of its values
+};
+
+struct CatalogColumn
+{
+    CatalogType                 type;           ///< Type of the values
+    std::vector<std::byte>      values;         ///< Values of each row
+};
+
+struct Catalog
+{
+    std::vector<std::string>    paths;          ///< Path of each row
+    std::vector<CatalogColumn>  columns;        ///< A column per catalog field, in the same order
+};
+
+enum class CatalogOperator
+{
+    equal,
+    notEqual,
+    less,
+    lessEqual,
+    greater,
+    greaterEqual,
+};
+
+struct CatalogCondition
+{
+    size_t                      field;          ///< Index of the field
+    CatalogOperator             op;             ///< Comparison
+    float64                     value;          ///< Value compared against
+};
+
+/**
+ * @brief Returns the fields stored for each file: its size and
+ * modification time, its voxel size and the numeric header fields
+ */
+const std::vector<CatalogField>& getCatalogFields();
+
+/**
+ * @brief Returns the index of the field with the given name.
+ * The amount of fields if it does not exist
+ */
+size_t findCatalogField(std::string_view name);
+
+/**
+ * @brief Parses a condition such as "mode=12", "size>1e9" or "voxel<=1.1"
+ */
+bool parseCatalogCondition(std::string_view str, CatalogCondition& condition);
+
+/**
+ * @brief Returns true if the path looks like an MRC file, compressed or not
+ */
+bool isCatalogPath(std::string_view path);
+
+/**
+ * @brief Scans the given files and directories (recursively) and updates the
+ * catalog. Files whose size and modification time did not change keep their
+ * row; the headers of the rest are read in parallel, without their data.
+ * Files that are gone are dropped. Returns the amount of headers read
+ */
+size_t refreshCatalog(Catalog& catalog, const std::vector<std::string>& paths, size_t threadCount);
+
+/**
+ * @brief Writes the catalog. Returns the amount of bytes written, 0 on error
+ */
+size_t writeCatalog(std::ostream& os, const Catalog& catalog);
+
+/**
+ * @brief Reads the paths and the requested columns (all of them if empty)
+ * from the catalog. Columns that were not requested are left empty.
+ * Returns false if the catalog is not valid, i.e. its counts, path offsets
+ * or columns do not fit in the file
+ */
+bool readCatalog(std::istream& is, Catalog& catalog, const std::vector<size_t>& fields = {});
+
+/**
+ * @brief Returns the rows that meet all the conditions. Each condition is
+ * evaluated over its whole column at once
+ */
+std::vector<size_t> queryCatalog(const Catalog& catalog, const std::vector<CatalogCondition>& conditions);
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "MainHeader.h"
+#include "FileRead.h"
+
+#include <istream>
+
+namespace MrcInspector
+{
+
+struct Checksum
+{
+    uint64                      header;         ///< Hash of the main header
+    uint64                      extHeader;      ///< Hash of the extended header
+    uint64                      data;           ///< Hash of the data block
+    uint64                      total;          ///< Combination of the above
+    size_t                      dataSize;       ///< Bytes of the data block that were hashed
+    bool                        complete;       ///< False if the extended header or data block is truncated
+};
+
+/**
+ * @brief Size of each of the chunks of the data block that are hashed 
+ * independently. The chunk hashes are then combined as a binary tree, so
+ * the result does not depend on the thread count
+ */
+constexpr size_t CHECKSUM_CHUNK_SIZE = 1 << 20;
+
+/**
+ * @brief Hashes the header, extended header and data block read from the stream.
+ * If normalize is set, the header and data block are hashed as if they were
+ * stored in little endian, so that the BE and LE copies of a file compare equal.
+ * The unused areas and labels of the header, whose contents writers do not 
+ * agree on, are then hashed as zeros. Returns the amount of bytes read from
+ * the stream, 0 if the header could not be read or is corrupt (see validateHeader)
+ */
+size_t computeChecksum(std::istream& is, Checksum& checksum, bool normalize, size_t threadCount);
+
+/**
+ * @brief As above, but the data block is read from the file at the given path
+ * with the given file reader (see readDataChunks). The stream must be that 
+ * file, uncompressed. Packed modes are still read from the stream
+ */
+size_t computeChecksum(std::istream& is, const char* path, const FileReadOptions& options, Checksum& checksum, bool normalize);
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string_view>
+
+namespace MrcInspector
+{
+
+enum class Compression
+{
+    none,
+    gzip,
+    bzip2,
+    zstd,
+    seekable,   ///< Container of independently compressed sections. See Seekable.h
+};
+
+constexpr std::string_view toString(Compression x)
+{
+    switch (x)
+    {
+    case Compression::none:     return "none";
+    case Compression::gzip:     return "gzip";
+    case Compression::bzip2:    return "bzip2";
+    case Compression::zstd:     return "zstd";
+    case Compression::seekable: return "seekable";
+    default:                    return "";
+    }
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "MainHeader.h"
+#include "Statistics.h"
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace MrcInspector
+{
+
+enum class Rounding
+{
+    nearest,    ///< Round half away from zero
+    floor,      ///< Round towards -inf
+    ceil,       ///< Round towards +inf
+    truncate,   ///< Round towards zero
+};
+
+struct ConversionOptions
+{
+    Mode                        mode;           ///< Target mode
+    float64                     scale;          ///< Values are mapped as value*scale + offset
+    float64                     offset;         ///< Values are mapped as value*scale + offset
+    bool                        clamp;          ///< Clamp the mapped values to [clampMin, clampMax]
+    float64                     clampMin;       ///< Lower bound when clamping
+    float64                     clampMax;       ///< Upper bound when clamping
+    Rounding                    rounding;       ///< Rounding applied for integer target modes
+    size_t                      threadCount;    ///< Number of worker threads
+};
+
+/**
+ * @brief Sets the scale and offset so that the header's [min, max] range
+ * is mapped to the representable range of the target mode. Floating 
+ * point targets are left unscaled. Returns false if the range of an integer
+ * target can not be fitted, as min and max are not finite or equal
+ */
+bool fitConversionRange(const MainHeader& header, ConversionOptions& options);
+
+/**
+ * @brief Returns the header of the converted file, which is written in native
+ * byte order. IMOD's unsigned bytes converted to mode 0 keep being unsigned,
+ * other mode 0 targets are flagged as signed. The unused areas are cleared. Its statistics need to be updated 
+ * after converting the data
+ */
+MainHeader makeConvertedHeader(const MainHeader& header, const ConversionOptions& options);
+
+/**
+ * @brief Returns the extended header of the converted file. Agard extended
+ * headers, made of 32bit words, are re-encoded in native byte order. Other
+ * layouts are either text or stored in a fixed byte order and are kept as is
+ */
+std::string makeConvertedExtendedHeader(const MainHeader& header, const std::string& extHeader);
+
+/**
+ * @brief Converts the data block section by section, writing it to the 
+ * output stream. Integer and float16 targets always saturate to their range,
+ * which is the unsigned one for IMOD's unsigned bytes converted to mode 0. Complex 
+ * values are converted to real ones by their modulus. The statistics of 
+ * the written values are accumulated while converting.
+ * Returns the number of bytes written
+ */
+size_t convertData( std::istream& is, 
+                    const MainHeader& header, 
+                    std::ostream& os, 
+                    const ConversionOptions& options,
+                    Statistics& statistics );
+
+}
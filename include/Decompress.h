@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Compression.h"
+
+#include <istream>
+#include <memory>
+#include <streambuf>
+
+namespace MrcInspector
+{
+
+/**
+ * @brief Returns true if support for the given compression was built in
+ */
+bool isCompressionSupported(Compression compression);
+
+/**
+ * @brief Creates a stream buffer that decompresses the source stream on 
+ * demand, so that only what is read gets decompressed. Independent frames of
+ * bounded size (BGZF-style gzip members, zstd frames up to 16 MiB) are 
+ * decompressed in batches in parallel; anything else is streamed through a
+ * bounded window. Returns nullptr if the compression is not supported
+ */
+std::unique_ptr<std::streambuf> makeDecompressStreambuf(std::istream& source, Compression compression, size_t threadCount);
+
+/**
+ * @brief Opens a file for reading, transparently decompressing it if its
+ * magic bytes show it is compressed. Decompressed streams can not seek,
+ * except for seekable containers. Returns nullptr if the compression is 
+ * not supported or the file can not be decompressed
+ */
+std::unique_ptr<std::istream> openInputFile(const char* path, size_t threadCount, Compression& compression);
+
+}
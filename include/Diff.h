@@ -0,0 +1,65 @@
+#pragma once
+
+#include "MainHeader.h"
+
+#include <array>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace MrcInspector
+{
+
+struct HeaderDifference
+{
+    std::string                 field;          ///< Name of the field
+    std::string                 lhs;            ///< Value on the first file
+    std::string                 rhs;            ///< Value on the second file
+};
+
+struct Mismatch
+{
+    std::array<size_t, 3>       position;       ///< Column, row and section of the voxel
+    cfloat128                   lhs;            ///< Value on the first file
+    cfloat128                   rhs;            ///< Value on the second file
+};
+
+struct DiffOptions
+{
+    float64                     absTolerance;   ///< Absolute tolerance
+    float64                     relTolerance;   ///< Tolerance relative to the value on the second file
+    size_t                      maxMismatches;  ///< Number of mismatches to be reported
+    size_t                      threadCount;    ///< Number of worker threads
+    bool                        equalNan;       ///< Whether NaNs at the same voxel are equal
+};
+
+struct DataDifference
+{
+    size_t                      count;          ///< Number of voxels compared
+    size_t                      mismatchCount;  ///< Number of voxels out of tolerance
+    float64                     maxError;       ///< Maximum absolute error
+    float64                     rmsError;       ///< RMS of the absolute error
+    std::vector<Mismatch>       mismatches;     ///< First mismatches in storage order
+};
+
+/**
+ * @brief Compares the headers field by field, appending the fields that differ
+ */
+void diffMainHeader(const MainHeader& lhs, const MainHeader& rhs, std::vector<HeaderDifference>& differences);
+
+/**
+ * @brief Compares the data blocks voxel by voxel, reading both streams section by
+ * section in lockstep. A voxel mismatches unless |lhs - rhs| <= abs + rel*|rhs|,
+ * so a NaN on either side mismatches unless both are NaN and equalNan is set.
+ * Equal infinities match.
+ * Both streams must be positioned at the beginning of the data block. 
+ * Returns the number of voxels compared, 0 if the dimensions do not match
+ */
+size_t diffData(std::istream& lhsIs, 
+                const MainHeader& lhsHeader, 
+                std::istream& rhsIs, 
+                const MainHeader& rhsHeader, 
+                const DiffOptions& options, 
+                DataDifference& difference );
+
+}
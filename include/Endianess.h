@@ -59,11 +59,26 @@ constexpr Endianess getComplexEndianess(Endianess end)
     return getNibble<7>(end);
 }
 
+constexpr bool isValidEndianess(Endianess end)
+{
+    return end == Endianess::be || end == Endianess::le;
+}
+
+/**
+ * @brief Returns true if the byte order of every data type is given by the stamp
+ */
+constexpr bool isValidByteOrder(Endianess end)
+{
+    return  isValidEndianess(getCharEndianess(end)) && isValidEndianess(getIntEndianess(end)) &&
+            isValidEndianess(getFloatEndianess(end)) && isValidEndianess(getComplexEndianess(end));
+}
+
 constexpr Endianess getModeEndianess(Endianess end, Mode mode)
 {
     switch (mode)
     {
     case Mode::sint8:
+    case Mode::packed4:
         return getCharEndianess(end);
     case Mode::sint16:
     case Mode::uint16:
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "MainHeader.h"
+
+#include <cstddef>
+#include <functional>
+
+namespace MrcInspector
+{
+
+enum class ReadBackend
+{
+    stream,     ///< std::istream, a single read of the whole block
+    pread,      ///< Sequential chunked pread
+    uring,      ///< Asynchronous io_uring with many chunks in flight
+    parallel,   ///< Concurrent pread of disjoint chunks from several threads
+};
+
+struct FileReadOptions
+{
+    ReadBackend                 backend;        ///< Mechanism used for reading
+    size_t                      chunkSize;      ///< Size of each read request in bytes
+    size_t                      queueDepth;     ///< Number of requests in flight (uring)
+    bool                        direct;         ///< Bypass the page cache (O_DIRECT)
+    size_t                      threadCount;    ///< Number of reading threads (parallel)
+};
+
+/**
+ * @brief Called for each completed chunk, which may be modified in place. 
+ * Offset is relative to the start of the data block. With the parallel 
+ * backend it is called concurrently from the reading threads
+ */
+using ChunkCallback = std::function<void(std::byte* data, size_t offset, size_t size)>;
+
+/**
+ * @brief Reads the data block of the file at the given path, splitting 
+ * it in chunks. The endianess of each chunk is matched as soon as it 
+ * completes, while the rest of the chunks are still being read. If the
+ * uring backend is not available, pread is used instead.
+ * When direct is set, the file is opened with O_DIRECT for any of the backends
+ * (stream behaves as pread). Reads are aligned as the file system requires:
+ * the aligned windows of the destination are read in place when its address
+ * allows it, and the unaligned head and tail through small aligned buffers.
+ * If the file system does not support it, chunks are read normally and 
+ * dropped from the page cache with posix_fadvise.
+ * Packed modes are not supported, as chunks are read in place.
+ * Returns the amount of contiguous bytes read from the start of the block
+ */
+size_t readDataFile(const char* path, 
+                    const MainHeader& header, 
+                    DataBlock& data, 
+                    const FileReadOptions& options,
+                    const ChunkCallback& callback = {} );
+
+/**
+ * @brief Reads the data block as readDataFile does, but through a few chunk-sized
+ * buffers that are handed to the callback and reused, so the block is never held 
+ * in memory. Chunks are handed as stored, without matching their endianess, in 
+ * order of completion. All of them but the last one are chunkSize long, rounded 
+ * up to whole values and, with O_DIRECT, to the alignment of the file system, 
+ * which is a power of two. The stream backend behaves as pread.
+ * Packed modes are not supported. Returns the amount of contiguous bytes read
+ * from the start of the block
+ */
+size_t readDataChunks(  const char* path, 
+                        const MainHeader& header, 
+                        const FileReadOptions& options,
+                        const ChunkCallback& callback );
+
+}
\ No newline at end of file
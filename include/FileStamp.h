@@ -0,0 +1,20 @@
+#pragma once
+
+#include "DataTypes.h"
+
+namespace MrcInspector
+{
+
+struct FileStamp
+{
+    uint64                      size;           ///< Size of the file in bytes
+    int64                       modificationTime; ///< Last modification [ns since the epoch]
+};
+
+/**
+ * @brief Gets the size and modification time of a file. False if it does not exist.
+ * Used for telling whether a sidecar is up to date with the file it was built from
+ */
+bool getFileStamp(const char* path, FileStamp& stamp);
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "MainHeader.h"
+#include "Statistics.h"
+
+#include <functional>
+#include <vector>
+
+namespace MrcInspector
+{
+
+struct FollowState
+{
+    MainHeader                  header;         ///< Header as of the last update
+    size_t                      sectionCount;   ///< Sections consumed so far
+    Statistics                  statistics;     ///< Statistics of the consumed sections
+    std::vector<uint64>         chunkHashes;    ///< Hashes of the complete checksum chunks consumed
+    std::vector<std::byte>      pending;        ///< Bytes of the incomplete checksum chunk
+};
+
+struct FollowOptions
+{
+    int                         idleTimeout;    ///< Stop after this many ms without changes, never if negative
+    size_t                      threadCount;    ///< Threads computing the statistics of new sections
+};
+
+/**
+ * @brief Called for each new section, in order, with its index and statistics
+ */
+using FollowCallback = std::function<void(size_t section, const Statistics& statistics)>;
+
+FollowState makeFollowState();
+
+/**
+ * @brief Re-reads the header of the open file and consumes the sections that
+ * were completed since the last update, as told by the size of the file. The
+ * section count of the header is not relied on, as writers often update it
+ * last. Sections already consumed are never read again. Returns false if the
+ * header can not be decoded or the layout of the sections changed
+ */
+bool updateFollowState(int fd, FollowState& state, size_t threadCount, const FollowCallback& callback);
+
+/**
+ * @brief Returns the hash of the consumed part of the data block, which
+ * matches the data hash of computeChecksum once the file is complete
+ */
+uint64 getFollowDataHash(const FollowState& state);
+
+/**
+ * @brief Consumes the file as it grows, waking up on inotify events rather
+ * than polling. Returns when the file is deleted or moved, or after the idle
+ * timeout. False if it can not be watched or updateFollowState fails
+ */
+bool followFile(const char* path, const FollowOptions& options, FollowState& state, const FollowCallback& callback);
+
+}
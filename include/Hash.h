@@ -0,0 +1,30 @@
+#pragma once
+
+#include "DataTypes.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/**
+ * @brief Fast non-cryptographic 64bit hash in the spirit of xxHash3.
+ * The input is processed as 64B stripes over 8 independent lanes, so that
+ * the inner loop is vectorized by the compiler. It is self-contained and
+ * its values are not compatible with the reference XXH3 implementation.
+ */
+uint64 hash64(const std::byte* data, size_t size, uint64 seed = 0);
+
+/**
+ * @brief Combines two hashes. The operation is not commutative
+ */
+uint64 combineHash64(uint64 left, uint64 right);
+
+/**
+ * @brief Reduces a sequence of hashes pairwise as a binary tree.
+ * The result only depends on the sequence, not on how it was computed
+ */
+uint64 combineHash64Tree(std::vector<uint64> hashes);
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "MainHeader.h"
+#include "FileStamp.h"
+#include "Statistics.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace MrcInspector
+{
+
+struct HeaderCacheEntry
+{
+    FileStamp                   stamp;          ///< Stamp of the file when it was parsed
+    MainHeader                  header;         ///< Decoded main header
+    std::string                 extHeader;      ///< Extended header
+    std::optional<Statistics>   statistics;     ///< Statistics of the data block, once computed
+};
+
+/**
+ * @brief Thread safe LRU cache of parsed headers, keyed by path. Entries
+ * are only returned while the size and modification time of the file
+ * match, so edited files are parsed again
+ */
+class HeaderCache
+{
+public:
+    explicit HeaderCache(size_t capacity);
+
+    /**
+     * @brief Returns the entry of the file, parsing its headers if they
+     * are not cached or the file changed. nullptr if they can not be read
+     */
+    std::shared_ptr<const HeaderCacheEntry> get(const std::string& path);
+
+    /**
+     * @brief Stores the statistics of a file in its entry
+     */
+    void setStatistics(const std::string& path, const FileStamp& stamp, const Statistics& statistics);
+
+    size_t getHitCount() const;
+    size_t getMissCount() const;
+
+private:
+    using List = std::list<std::pair<std::string, std::shared_ptr<const HeaderCacheEntry>>>;
+
+    size_t                      m_capacity;
+    size_t                      m_hitCount = 0;
+    size_t                      m_missCount = 0;
+    List                        m_entries;      ///< Most recently used first
+    std::unordered_map<std::string, List::iterator> m_index;
+    mutable std::mutex          m_mutex;
+
+    void insert(const std::string& path, std::shared_ptr<const HeaderCacheEntry> entry);
+};
+
+}
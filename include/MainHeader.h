@@ -6,6 +6,7 @@
 #include "ExtendedHeaderType.h"
 #include "Endianess.h"
 
+#include <algorithm>
 #include <array>
 
 namespace MrcInspector
@@ -25,9 +26,22 @@ struct MainHeader
     float32                     avg;            ///< Average density value
     uint32                      ispg;           ///< Space group number
     uint32                      extHeaderLen;   ///< Size of the extended header in bytes
+    uint16                      creatorId;      ///< Creator ID, 0 in current files
+    std::array<uint8, 6>        extra0;         ///< Unused
     ExtendedHeaderType          extHeaderType;  ///< Type of the extended header
     uint32                      version;        ///< Version of the MRC file
-    std::array<uint32, 23>      padding;        ///< Padding for extra data
+    std::array<uint8, 16>       extra1;         ///< Unused
+    uint16                      nInt;           ///< Integers per section of an Agard extended header, bytes per section of a SerialEM one
+    uint16                      nReal;          ///< Floats per section of an Agard extended header, content flags of a SerialEM one
+    std::array<uint8, 20>       extra2;         ///< Unused
+    uint32                      imodStamp;      ///< IMOD_STAMP if written by IMOD, which then sets imodFlags
+    uint32                      imodFlags;      ///< IMOD_FLAG_* bits
+    uint16                      dataType;       ///< IMOD data type (mono, tilt, tilts, lina, lins)
+    uint16                      lens;           ///< IMOD lens number
+    std::array<uint16, 2>       dataCounts;     ///< IMOD nd1 and nd2, meaning depends on dataType
+    std::array<uint16, 2>       dataValues;     ///< IMOD vd1 and vd2 (x100), meaning depends on dataType
+    std::array<float32, 3>      originalTilt;   ///< Original tilt angles (x, y, z) [deg]
+    std::array<float32, 3>      currentTilt;    ///< Current tilt angles (x, y, z) [deg]
     std::array<float32, 3>      origin;         ///< Phase origin [A]
     std::array<char, 4>         map;            ///< String 'MAP'
     Endianess                   byteOrder;      ///< Endianess of the data
@@ -38,4 +52,227 @@ struct MainHeader
 
 static_assert(sizeof(MainHeader) == 1024, "Size of the header file does not match the expected size (1024B)");
 
+constexpr uint32 IMOD_STAMP = 1146047817;          ///< "IMOD" read as a little endian integer
+constexpr uint32 IMOD_FLAG_SIGNED_BYTES = 1 << 0;  ///< Mode 0 values are signed
+constexpr uint32 IMOD_FLAG_4BIT_BYTES = 1 << 4;    ///< Mode 0 bytes hold two 4bit values, the first in the low nibble
+
+/**
+ * @brief Applies an integer function to an enum field through a copy,
+ * as accessing the enum through an integer reference breaks strict aliasing
+ */
+template<typename IntFunc, typename T>
+void transformEnum(IntFunc&& intFunc, T& value)
+{
+    auto integer = static_cast<uint32>(value);
+    intFunc(integer);
+    value = static_cast<T>(integer);
+}
+
+/**
+ * @brief Applies a 32bit integer function to a 16bit field. A byte swap moves
+ * the value to the upper half and anything else leaves it in the lower one,
+ * so merging both halves gives the result either way
+ */
+template<typename IntFunc>
+void transformShort(IntFunc&& intFunc, uint16& value)
+{
+    uint32 integer = value;
+    intFunc(integer);
+    value = static_cast<uint16>((integer >> 16) | (integer & 0xFFFF));
+}
+
+/**
+ * @brief Applies the given functions to every multi-byte integer and floating
+ * point field of the header. Used for matching the endianess of the fields.
+ * byteOrder and extHeaderType are not included, as they are always stored as BE
+ */
+template<typename IntFunc, typename FltFunc>
+void transformMainHeader(MainHeader& header, IntFunc&& intFunc, FltFunc&& fltFunc)
+{
+    //Integers
+    intFunc(header.dimensions[0]);
+    intFunc(header.dimensions[1]);
+    intFunc(header.dimensions[2]);
+    transformEnum(intFunc, header.mode);
+    intFunc(header.start[0]);
+    intFunc(header.start[1]);
+    intFunc(header.start[2]);
+    intFunc(header.sampling[0]);
+    intFunc(header.sampling[1]);
+    intFunc(header.sampling[2]);
+    transformEnum(intFunc, header.axisMapping[0]);
+    transformEnum(intFunc, header.axisMapping[1]);
+    transformEnum(intFunc, header.axisMapping[2]);
+    intFunc(header.ispg);
+    intFunc(header.extHeaderLen);
+    transformShort(intFunc, header.creatorId);
+    intFunc(header.version);
+    transformShort(intFunc, header.nInt);
+    transformShort(intFunc, header.nReal);
+    intFunc(header.imodStamp);
+    intFunc(header.imodFlags);
+    transformShort(intFunc, header.dataType);
+    transformShort(intFunc, header.lens);
+    transformShort(intFunc, header.dataCounts[0]);
+    transformShort(intFunc, header.dataCounts[1]);
+    transformShort(intFunc, header.dataValues[0]);
+    transformShort(intFunc, header.dataValues[1]);
+    intFunc(header.nLabels);
+
+    //Floats
+    fltFunc(header.cellDimensions[0]);
+    fltFunc(header.cellDimensions[1]);
+    fltFunc(header.cellDimensions[2]);
+    fltFunc(header.cellAngles[0]);
+    fltFunc(header.cellAngles[1]);
+    fltFunc(header.cellAngles[2]);
+    fltFunc(header.min);
+    fltFunc(header.max);
+    fltFunc(header.avg);
+    fltFunc(header.originalTilt[0]);
+    fltFunc(header.originalTilt[1]);
+    fltFunc(header.originalTilt[2]);
+    fltFunc(header.currentTilt[0]);
+    fltFunc(header.currentTilt[1]);
+    fltFunc(header.currentTilt[2]);
+    fltFunc(header.origin[0]);
+    fltFunc(header.origin[1]);
+    fltFunc(header.origin[2]);
+    fltFunc(header.rms);
+}
+
+/**
+ * @brief Returns true if the mode 0 values of the file are unsigned. IMOD
+ * writes them so unless it flags them as signed. Without its stamp they are
+ * signed, as MRC2014 defines them
+ */
+inline bool hasUnsignedBytes(const MainHeader& header)
+{
+    return  header.mode == Mode::sint8 && 
+            header.imodStamp == IMOD_STAMP && 
+            (header.imodFlags & IMOD_FLAG_SIGNED_BYTES) == 0;
+}
+
+/**
+ * @brief Returns true if the header is IMOD's way of storing 4bit data: mode 0
+ * with IMOD_FLAG_4BIT_BYTES set and the columns counting bytes, i.e. half of 
+ * the values of each row
+ */
+inline bool hasImod4BitBytes(const MainHeader& header)
+{
+    return  header.mode == Mode::sint8 && 
+            header.imodStamp == IMOD_STAMP && 
+            (header.imodFlags & IMOD_FLAG_4BIT_BYTES) != 0;
+}
+
+/**
+ * @brief Turns IMOD's 4bit mode 0 header (see hasImod4BitBytes) into the
+ * equivalent mode 101 one, so that it is read by the packed kernels. The 
+ * flag is cleared, as it does not apply to mode 101
+ */
+inline void convertImod4BitBytes(MainHeader& header)
+{
+    if(hasImod4BitBytes(header))
+    {
+        header.mode = Mode::packed4;
+        header.dimensions[0] *= 2;
+        header.imodFlags &= ~IMOD_FLAG_4BIT_BYTES;
+    }
+}
+
+/**
+ * @brief Zeroes the unused bytes and the labels past nLabels. Their contents
+ * are left as stored, in an unknown byte order, so they are meaningless once
+ * the decoded header is written or compared
+ */
+inline void clearUnusedFields(MainHeader& header)
+{
+    header.extra0.fill(0);
+    header.extra1.fill(0);
+    header.extra2.fill(0);
+    for(size_t i = std::min<size_t>(header.nLabels, header.labels.size()); i < header.labels.size(); ++i)
+    {
+        header.labels[i].fill(0);
+    }
+}
+
+/**
+ * @brief Drops the extended header, clearing the fields that describe its
+ * records, for headers of derived files whose sections do not match the source
+ */
+inline void clearExtendedHeader(MainHeader& header)
+{
+    header.extHeaderLen = 0;
+    header.extHeaderType = static_cast<ExtendedHeaderType>(0);
+    header.nInt = 0;
+    header.nReal = 0;
+}
+
+/**
+ * @brief Makes the data block hold a vector of the type the values of the
+ * file are read as. Returns false if the mode is not known
+ */
+inline bool emplaceDataBlock(DataBlock& data, const MainHeader& header)
+{
+    if(hasUnsignedBytes(header))
+    {
+        data.emplace<std::vector<uint8>>();
+        return true;
+    }
+    return emplaceDataBlock(data, header.mode);
+}
+
+/**
+ * @brief Returns the number of voxels of a single section
+ */
+inline size_t getSectionElementCount(const MainHeader& header)
+{
+    return  static_cast<size_t>(header.dimensions[0]) * 
+            static_cast<size_t>(header.dimensions[1]) ;
+}
+
+/**
+ * @brief Returns the size of a single row in the file in bytes. Rows of packed
+ * modes are padded to a whole byte. 0 if the mode is unknown
+ */
+inline size_t getRowSize(const MainHeader& header)
+{
+    const auto nColumns = static_cast<size_t>(header.dimensions[0]);
+    return isPackedMode(header.mode) ? (nColumns + 1) / 2 : nColumns * getModeSize(header.mode);
+}
+
+/**
+ * @brief Returns the size of a single section in the file in bytes. 0 if the mode is unknown
+ */
+inline size_t getSectionSize(const MainHeader& header)
+{
+    return getRowSize(header) * static_cast<size_t>(header.dimensions[1]);
+}
+
+/**
+ * @brief Returns the number of voxels of the volume
+ */
+inline size_t getElementCount(const MainHeader& header)
+{
+    return  static_cast<size_t>(header.dimensions[0]) * 
+            static_cast<size_t>(header.dimensions[1]) * 
+            static_cast<size_t>(header.dimensions[2]) ;
+}
+
+/**
+ * @brief Returns the size of the data block in the file in bytes. 0 if the mode is unknown
+ */
+inline size_t getDataSize(const MainHeader& header)
+{
+    return getSectionSize(header) * static_cast<size_t>(header.dimensions[2]);
+}
+
+/**
+ * @brief Returns the offset of the data block from the beginning of the file
+ */
+inline size_t getDataOffset(const MainHeader& header)
+{
+    return sizeof(MainHeader) + header.extHeaderLen;
+}
+
 }
\ No newline at end of file
@@ -13,6 +13,7 @@ enum class Mode : Word {
     cfloat32    = 4,    ///< 2x 32bit IEEE-754 as a cartesian complex representation
     uint16      = 6,    ///< 16bit unsigned integers
     float16     = 12,   ///< 16bit IEEE-754
+    packed4     = 101,  ///< 4bit unsigned integers packed two per byte, low nibble first. Rows start on a byte
 };
 
 template<typename T>
@@ -73,8 +74,72 @@ constexpr std::string_view toString(Mode x)
     case Mode::cfloat32:return "complex float32";
     case Mode::uint16:  return "unsigned int16";
     case Mode::float16: return "float16";
+    case Mode::packed4: return "packed uint4";
     default:            return "";
     }
 }
 
+/**
+ * @brief Returns true if several voxels of the mode share a byte in the file
+ */
+constexpr bool isPackedMode(Mode x)
+{
+    return x == Mode::packed4;
+}
+
+/**
+ * @brief Returns the size in bytes of a single voxel of the given mode once
+ * read. Packed modes take less in the file (see getRowSize). 0 if not known
+ */
+constexpr size_t getModeSize(Mode x)
+{
+    switch (x)
+    {
+    case Mode::sint8:   return sizeof(int8);
+    case Mode::sint16:  return sizeof(int16);
+    case Mode::float32: return sizeof(float32);
+    case Mode::cint16:  return sizeof(cint32);
+    case Mode::cfloat32:return sizeof(cfloat64);
+    case Mode::uint16:  return sizeof(uint16);
+    case Mode::float16: return sizeof(float16);
+    case Mode::packed4: return sizeof(uint8);
+    default:            return 0;
+    }
+}
+
+/**
+ * @brief Returns the size in bytes of each of the words whose endianess
+ * needs to be matched. For complex modes this is the size of a component
+ */
+constexpr size_t getModeWordSize(Mode x)
+{
+    switch (x)
+    {
+    case Mode::cint16:  return sizeof(int16);
+    case Mode::cfloat32:return sizeof(float32);
+    default:            return getModeSize(x);
+    }
+}
+
+/**
+ * @brief Makes the data block hold a vector of the type corresponding to 
+ * the given mode. Returns false if the mode is not known
+ */
+inline bool emplaceDataBlock(DataBlock& data, Mode x)
+{
+    switch (x)
+    {
+    case Mode::sint8:   data.emplace<std::vector<int8>>(); break;
+    case Mode::sint16:  data.emplace<std::vector<int16>>(); break;
+    case Mode::float32: data.emplace<std::vector<float32>>(); break;
+    case Mode::cint16:  data.emplace<std::vector<cint32>>(); break;
+    case Mode::cfloat32:data.emplace<std::vector<cfloat64>>(); break;
+    case Mode::uint16:  data.emplace<std::vector<uint16>>(); break;
+    case Mode::float16: data.emplace<std::vector<float16>>(); break;
+    case Mode::packed4: data.emplace<std::vector<uint8>>(); break;
+    default:            return false;
+    }
+    return true;
+}
+
 }
\ No newline at end of file
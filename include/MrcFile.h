@@ -0,0 +1,121 @@
+#pragma once
+
+#include "MainHeader.h"
+#include "Compression.h"
+#include "Region.h"
+#include "Statistics.h"
+#include "Parallel.h"
+#include "Validate.h"
+
+#include <array>
+#include <istream>
+#include <memory>
+#include <string>
+
+namespace MrcInspector
+{
+
+/**
+ * @brief Typed read-only view of a data block as a volume, indexed as (x, y, z)
+ * with x running fastest. Empty when the block does not hold values of type T
+ */
+template<typename T>
+struct VolumeView
+{
+    const T*                    data;           ///< First value, nullptr if empty
+    std::array<size_t, 3>       dimensions;     ///< Values along x, y and z
+
+    bool empty() const
+    {
+        return data == nullptr;
+    }
+
+    const T& operator()(size_t x, size_t y, size_t z) const
+    {
+        return data[(z*dimensions[1] + y)*dimensions[0] + x];
+    }
+};
+
+/**
+ * @brief Returns a view of the block with the given dimensions. Empty if the
+ * block does not hold values of type T or has fewer values than the dimensions
+ */
+template<typename T>
+VolumeView<T> makeVolumeView(const DataBlock& data, const std::array<size_t, 3>& dimensions)
+{
+    const auto* values = std::get_if<std::vector<T>>(&data);
+    const auto count = dimensions[0] * dimensions[1] * dimensions[2];
+    if(!values || values->size() < count)
+    {
+        return VolumeView<T>{nullptr, dimensions};
+    }
+    return VolumeView<T>{values->data(), dimensions};
+}
+
+/**
+ * @brief An MRC file opened for in-process use. Its headers are decoded once on
+ * open and its data is read on demand, in the native byte order. Compressed files
+ * are decompressed transparently; those that can not seek are read through or
+ * opened again when an earlier part is requested. Not thread safe
+ */
+class MrcFile
+{
+public:
+    /**
+     * @brief Opens the file and reads its headers. False if it can not be
+     * decompressed or its header is corrupt, in which case nothing past the
+     * main header is read
+     */
+    bool open(const std::string& path, size_t threadCount = getDefaultThreadCount());
+
+    bool isOpen() const;
+    const std::string& getPath() const;
+    const MainHeader& getHeader() const;
+    const std::string& getExtendedHeader() const;
+    Compression getCompression() const;
+    Validity getValidity() const;
+
+    /**
+     * @brief Reads the whole data block. Returns the amount of bytes read
+     */
+    size_t readData(DataBlock& data);
+
+    /**
+     * @brief Reads count sections starting at the first one. Returns the amount of bytes read
+     */
+    size_t readSections(size_t first, size_t count, DataBlock& data);
+
+    /**
+     * @brief Reads a region, from the brick cache of the file if it is up to
+     * date. Returns the amount of bytes read, 0 if the region is out of bounds
+     */
+    size_t readRegion(const Region& region, DataBlock& data);
+
+    /**
+     * @brief Computes the statistics of the data block a few sections at a
+     * time. False if it can not be read whole
+     */
+    bool computeStatistics(Statistics& statistics);
+
+    /**
+     * @brief Computes the statistics of the data block with the given file 
+     * reader (see readDataChunks). Compressed files and packed modes, which
+     * it can not read, are read from the stream. False if it can not be 
+     * read whole
+     */
+    bool computeStatistics(Statistics& statistics, const FileReadOptions& options);
+
+private:
+    std::string                 m_path;
+    size_t                      m_threadCount = 1;
+    Compression                 m_compression = Compression::none;
+    MainHeader                  m_header = {};
+    Validity                    m_validity = Validity::corrupt;
+    std::string                 m_extHeader;
+    std::unique_ptr<std::istream> m_stream;
+    size_t                      m_position = 0; ///< Offset of the stream from the start of the file, if known
+
+    bool seekSection(size_t section);
+};
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "MainHeader.h"
+
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/**
+ * @brief Returns the NumPy dtype descriptor of the given mode in the native
+ * byte order (e.g. "<f4"). Empty if not known
+ */
+std::string_view getNpyDescriptor(Mode mode);
+
+/**
+ * @brief Returns the descriptor of the values of the file once read, which
+ * are unsigned for IMOD's unsigned bytes (see hasUnsignedBytes)
+ */
+std::string_view getNpyDescriptor(const MainHeader& header);
+
+/**
+ * @brief Writes the header of a NPY (version 1.0) file. The shape is given
+ * from the slowest to the fastest axis, (sections, rows, columns) for 
+ * volumes. The values are then written in the native byte order with writeData
+ */
+size_t writeNpyHeader(std::ostream& os, Mode mode, const std::vector<size_t>& shape);
+size_t writeNpyHeader(std::ostream& os, const MainHeader& header, const std::vector<size_t>& shape);
+size_t writeNpyHeader(std::ostream& os, std::string_view descriptor, const std::vector<size_t>& shape);
+
+/**
+ * @brief Returns true if the path has a .npy extension
+ */
+bool isNpyPath(std::string_view path);
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "DataTypes.h"
+
+#include <type_traits>
+
+namespace MrcInspector
+{
+
+template<typename T>
+struct IsComplex : std::false_type
+{
+};
+
+template<typename T>
+struct IsComplex<std::complex<T>> : std::true_type
+{
+};
+
+template<typename T>
+constexpr bool isComplex = IsComplex<T>::value;
+
+/**
+ * @brief Returns the scalar type of a voxel type. For complex
+ * values, this is the type of its components
+ */
+template<typename T>
+struct ScalarType
+{
+    using type = T;
+};
+
+template<typename T>
+struct ScalarType<std::complex<T>>
+{
+    using type = T;
+};
+
+/**
+ * @brief Converts a voxel value into a 64bit float. Complex values are
+ * converted to their modulus
+ */
+template<typename T>
+inline float64 toFloat64(const T& value)
+{
+    if constexpr (isComplex<T>)
+    {
+        return std::abs(cfloat128(
+            static_cast<float64>(value.real()), 
+            static_cast<float64>(value.imag())
+        ));
+    }
+    else
+    {
+        return static_cast<float64>(value);
+    }
+}
+
+/**
+ * @brief Converts a voxel value into a 128bit complex. Real values have
+ * a null imaginary part
+ */
+template<typename T>
+inline cfloat128 toComplex128(const T& value)
+{
+    if constexpr (isComplex<T>)
+    {
+        return cfloat128(
+            static_cast<float64>(value.real()), 
+            static_cast<float64>(value.imag())
+        );
+    }
+    else
+    {
+        return cfloat128(static_cast<float64>(value), 0.0);
+    }
+}
+
+}
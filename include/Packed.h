@@ -0,0 +1,67 @@
+#pragma once
+
+#include "MainHeader.h"
+
+#include <cstddef>
+
+namespace MrcInspector
+{
+
+/**
+ * @brief Expands count 4bit values, packed two per byte with the first one in
+ * the low nibble, into a byte each. Values are taken starting at the given
+ * nibble of src. Written as a plain loop over whole bytes so that the compiler
+ * can vectorize it
+ */
+inline void unpackNibbles(const uint8* src, size_t first, size_t count, uint8* dst)
+{
+    src += first / 2;
+    if((first & 1) && count > 0)
+    {
+        *(dst++) = *(src++) >> 4;
+        --count;
+    }
+
+    const auto pairs = count / 2;
+    for(size_t i = 0; i < pairs; ++i)
+    {
+        dst[2*i+0] = src[i] & 0x0F;
+        dst[2*i+1] = src[i] >> 4;
+    }
+    if(count & 1)
+    {
+        dst[2*pairs] = src[pairs] & 0x0F;
+    }
+}
+
+/**
+ * @brief Packs count values of 4bit two per byte, the first one in the low
+ * nibble. An odd count leaves the high nibble of the last byte empty
+ */
+inline void packNibbles(const uint8* src, size_t count, uint8* dst)
+{
+    const auto pairs = count / 2;
+    for(size_t i = 0; i < pairs; ++i)
+    {
+        dst[i] = (src[2*i+0] & 0x0F) | (src[2*i+1] << 4);
+    }
+    if(count & 1)
+    {
+        dst[pairs] = src[2*pairs] & 0x0F;
+    }
+}
+
+/**
+ * @brief Expands nRows rows of a packed mode, each of them starting on a byte
+ * boundary, into nColumns values per row
+ */
+inline void unpackRows(const uint8* src, size_t nColumns, size_t nRows, uint8* dst)
+{
+    const auto rowSize = (nColumns + 1) / 2;
+    for(size_t r = 0; r < nRows; ++r)
+    {
+        unpackNibbles(src + r*rowSize, 0, nColumns, dst + r*nColumns);
+    }
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/**
+ * @brief Returns the number of threads to be used when the user
+ * does not specify it
+ */
+inline size_t getDefaultThreadCount()
+{
+    return std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+/**
+ * @brief Calls func(i) for every i in [0, count) using up to threadCount threads.
+ * Indices are handed out dynamically, so the order of the calls is not defined.
+ * The calling thread also takes part in the work
+ */
+template<typename F>
+void parallelFor(size_t count, size_t threadCount, F&& func)
+{
+    threadCount = std::min(threadCount, count);
+    if(threadCount <= 1)
+    {
+        for(size_t i = 0; i < count; ++i)
+        {
+            func(i);
+        }
+    }
+    else
+    {
+        std::atomic<size_t> next = 0;
+        const auto worker = [&next, count, &func] ()
+        {
+            for(size_t i = next++; i < count; i = next++)
+            {
+                func(i);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount - 1);
+        for(size_t i = 1; i < threadCount; ++i)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for(auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+}
+
+}
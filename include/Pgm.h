@@ -0,0 +1,23 @@
+#pragma once
+
+#include "DataTypes.h"
+
+#include <ostream>
+#include <string_view>
+
+namespace MrcInspector
+{
+
+/**
+ * @brief Writes a 2D image as a binary 8bit PGM (P5) file. The values 
+ * are linearly mapped from their [min, max] range to [0, 255]. Rows 
+ * are written in storage order
+ */
+size_t writePgm(std::ostream& os, const float32* data, size_t width, size_t height);
+
+/**
+ * @brief Returns true if the path has a .pgm extension
+ */
+bool isPgmPath(std::string_view path);
+
+}
@@ -1,6 +1,12 @@
 #pragma once
 
 #include "MainHeader.h"
+#include "Checksum.h"
+#include "Diff.h"
+#include "Statistics.h"
+#include "Follow.h"
+#include "Watch.h"
+#include "Validate.h"
 
 #include <ostream>
 #include <string>
@@ -11,5 +17,15 @@ namespace MrcInspector
 
 void printHeader(std::ostream& os, const MainHeader& header);
 void printData(std::ostream& os, const MainHeader& header, const DataBlock& data);
+void printHeaders(std::ostream& os, const MainHeader& header, const std::string& extHeader);
+void printAll(std::ostream& os, const MainHeader& header, const std::string& extHeader, const DataBlock& data);
+void printChecksum(std::ostream& os, const Checksum& checksum);
+void printStatistics(std::ostream& os, const Statistics& statistics);
+void printSectionStatistics(std::ostream& os, size_t section, const Statistics& statistics);
+void printFollowState(std::ostream& os, const FollowState& state);
+void printValidation(std::ostream& os, Validity validity, const std::vector<const ValidationRule*>& issues);
+void printInspection(std::ostream& os, const Inspection& inspection);
+void printHeaderDifferences(std::ostream& os, const std::vector<HeaderDifference>& differences);
+void printDataDifference(std::ostream& os, const DataDifference& difference);
 
 }
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "MainHeader.h"
+
+#include <istream>
+#include <vector>
+
+namespace MrcInspector
+{
+
+enum class ProjectionType
+{
+    sum,
+    mean,
+    max,
+};
+
+struct ProjectionOptions
+{
+    AxisMapping                 axis;           ///< Axis along which the volume is projected
+    ProjectionType              type;           ///< Reduction applied along the axis
+    size_t                      threadCount;    ///< Number of worker threads
+};
+
+/**
+ * @brief Returns the dimensions (columns, rows) of the projection. The X
+ * projection has (rows, sections), the Y projection (columns, sections)
+ * and the Z projection (columns, rows)
+ */
+std::array<size_t, 2> getProjectionDimensions(const MainHeader& header, AxisMapping axis);
+
+/**
+ * @brief Returns the header of the projection as a single section float32 volume
+ */
+MainHeader makeProjectionHeader(const MainHeader& header, const ProjectionOptions& options);
+
+/**
+ * @brief Projects the volume along one of its storage axes while reading 
+ * it section by section. Complex values are projected by their modulus.
+ * Only a section and the projection are held in memory.
+ * Returns the number of sections read
+ */
+size_t projectData( std::istream& is, 
+                    const MainHeader& header, 
+                    const ProjectionOptions& options,
+                    std::vector<float32>& projection );
+
+}
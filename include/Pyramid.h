@@ -0,0 +1,92 @@
+#pragma once
+
+#include "MainHeader.h"
+#include "FileStamp.h"
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/**
+ * Pyramid sidecar layout. Integers of the header are little endian:
+ *  - Header: "MRCP" magic, version (u32), level count (u32), reserved (u32),
+ *    size (u64) and modification time (i64, ns) of the source file, then the
+ *    binning factor (u64) and offset (u64) of each level, zero padded to 4KiB
+ *  - Levels: each of them a complete MRC file without extended header,
+ *    written in native byte order, starting at a 4KiB aligned offset
+ */
+
+constexpr size_t DEFAULT_PYRAMID_LEVEL_COUNT = 3;
+constexpr size_t PYRAMID_HEADER_SIZE = 4096;
+
+struct PyramidLevel
+{
+    size_t                      factor;         ///< Binning factor with respect to the source
+    uint64                      offset;         ///< Position of the level's MRC in the sidecar
+    MainHeader                  header;         ///< Header of the level
+};
+
+struct Pyramid
+{
+    FileStamp                   source;         ///< Stamp of the file the pyramid was built from
+    std::vector<PyramidLevel>   levels;         ///< Levels, from the finest to the coarsest
+};
+
+/**
+ * @brief Returns the path of the pyramid sidecar of the given file
+ */
+std::string getPyramidPath(const char* path);
+
+/**
+ * @brief Returns the factors 2, 4, 8... of the given amount of levels
+ */
+std::vector<size_t> getPyramidFactors(size_t levelCount);
+
+/**
+ * @brief Returns the size of the largest side of a voxel [A]. Headers
+ * without cell dimensions are measured in voxels
+ */
+float64 getVoxelSize(const MainHeader& header);
+
+/**
+ * @brief Writes the pyramid of the data block read from the stream in a
+ * single streaming pass, binning every level from the same section.
+ * The output stream needs to be seekable. The level headers are only written
+ * once all sections are binned. Returns the number of sections read
+ */
+size_t buildPyramid(std::istream& is,
+                    const MainHeader& header,
+                    const std::vector<size_t>& factors,
+                    const FileStamp& source,
+                    std::ostream& os,
+                    size_t threadCount );
+
+/**
+ * @brief Reads the table and the level headers of a pyramid sidecar
+ */
+bool readPyramid(std::istream& is, Pyramid& pyramid);
+
+/**
+ * @brief Returns true if the pyramid matches the header and stamp of the source file
+ */
+bool isPyramidValid(const Pyramid& pyramid, const MainHeader& header, const FileStamp& source);
+
+/**
+ * @brief Returns the index of the coarsest level whose voxel size (the one of
+ * the source times its factor) is not larger than the requested resolution [A].
+ * Returns the amount of levels if none of them is fine enough, so the source
+ * needs to be used
+ */
+size_t selectPyramidLevel(const Pyramid& pyramid, const MainHeader& header, float64 resolution);
+
+/**
+ * @brief Reads the data block of a level of the pyramid.
+ * Returns the amount of bytes read
+ */
+size_t readPyramidLevel(std::istream& is, const PyramidLevel& level, DataBlock& data);
+
+}
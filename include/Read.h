@@ -1,6 +1,7 @@
 #pragma once
 
 #include "MainHeader.h"
+#include "Compression.h"
 
 #include <istream>
 #include <string>
@@ -9,8 +10,37 @@
 namespace MrcInspector
 {
 
+/**
+ * @brief Detects the compression of the stream from its magic bytes. 
+ * The position of the stream is restored afterwards
+ */
+Compression detectCompression(std::istream& is);
+
+/**
+ * @brief Reads and decodes the main header. When its byte order stamp is not
+ * usable, the byte order is detected and written to the stamp of the header
+ */
 size_t readMainHeader(std::istream& is, MainHeader& header);
+bool decodeMainHeader(MainHeader& header);
+
+/**
+ * @brief Infers the byte order of a header as stored in the file, from how
+ * plausible its fields are (see Validate.h) when decoded as little and big
+ * endian. If both are equally plausible and the stream is given, a small sample
+ * of the data block following the header is scored too. Little endian otherwise.
+ * Returns le_le_le_le or be_be_be_be
+ */
+Endianess detectByteOrder(const MainHeader& header, std::istream* is = nullptr);
 size_t readExtendedHeader(std::istream& is, const MainHeader& header, std::string& extHeader);
 size_t readData(std::istream& is, const MainHeader& header, DataBlock& data);
 
+/**
+ * @brief Reads the given amount of sections from the current position of the stream.
+ * Used for streaming through the data block without reading it whole. The storage
+ * of data is reused when it already holds the type of the header's mode. Packed
+ * modes are expanded to a byte per value. Returns the amount of bytes read from
+ * the stream
+ */
+size_t readSections(std::istream& is, const MainHeader& header, size_t count, DataBlock& data);
+
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "MainHeader.h"
+
+#include <array>
+#include <istream>
+
+namespace MrcInspector
+{
+
+struct Region
+{
+    std::array<size_t, 3>       origin;         ///< First column, row and section
+    std::array<size_t, 3>       size;           ///< Number of columns, rows and sections
+};
+
+/**
+ * @brief Returns true if the region is not empty and lies within the volume
+ */
+bool isValidRegion(const MainHeader& header, const Region& region);
+
+/**
+ * @brief Returns the region of the plane orthogonal to the given storage
+ * axis (column, row or section) at the given index
+ */
+Region getSliceRegion(const MainHeader& header, AxisMapping axis, size_t index);
+
+/**
+ * @brief Returns the header of the region as a volume on its own.
+ * The sampling is kept, so the voxel size does not change
+ */
+MainHeader makeRegionHeader(const MainHeader& header, const Region& region);
+
+/**
+ * @brief Reads a region of the data block from a stream positioned at its
+ * start, seeking over the rest. Contiguous rows are read at once. Streams
+ * that can not seek are skipped through instead. Only the bytes holding the
+ * region are read from rows of packed modes, and only the region is expanded.
+ * Returns the size of the region in bytes once read, 0 on error
+ */
+size_t readRegion(std::istream& is, const MainHeader& header, const Region& region, DataBlock& data);
+
+/**
+ * @brief Allocates count elements of the mode's type in the data block.
+ * Returns a pointer to its storage, nullptr if the mode is not known
+ */
+std::byte* allocateDataBlock(DataBlock& data, Mode mode, size_t count);
+
+/**
+ * @brief Allocates count elements of the type the values of the file are
+ * read as (see emplaceDataBlock)
+ */
+std::byte* allocateDataBlock(DataBlock& data, const MainHeader& header, size_t count);
+
+}
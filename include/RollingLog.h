@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace MrcInspector
+{
+
+/**
+ * @brief Append-only text log that can be written from several threads.
+ * When it would grow past its maximum size, it is renamed to PATH.1,
+ * replacing the previous one, and started again
+ */
+class RollingLog
+{
+public:
+    RollingLog(std::string path, size_t maxSize);
+
+    /**
+     * @brief Appends the line and a newline, flushing it so that
+     * it can be followed. Returns false on error
+     */
+    bool write(std::string_view line);
+
+private:
+    std::string                 m_path;         ///< Path of the current log
+    size_t                      m_maxSize;      ///< Size that makes it roll over. Never if 0
+    size_t                      m_size;         ///< Current size
+    std::ofstream               m_file;
+    std::mutex                  m_mutex;
+};
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "MainHeader.h"
+#include "Compression.h"
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/**
+ * Seekable container layout. All integers are little endian:
+ *  - File header: "MRCZ" magic, version (u32), codec (u32), reserved (u32)
+ *  - Frames: compressed size (u64), decompressed size (u64) and payload.
+ *    The first frame holds the main and extended headers, then one frame
+ *    per section of the data block. A frame with both sizes set to 0 ends them
+ *  - Index: frame count (u64), then offset, compressed size and
+ *    decompressed size (u64 each) of every frame
+ *  - Footer: index offset (u64), "MRCZ" magic, version (u32)
+ *
+ * Concatenating the decompressed frames gives back the original file
+ */
+
+constexpr uint32 SEEKABLE_VERSION = 1;
+constexpr size_t SEEKABLE_HEADER_SIZE = 16;
+constexpr size_t SEEKABLE_FOOTER_SIZE = 16;
+
+struct SeekableFrame
+{
+    uint64                      offset;         ///< Position of the frame's payload in the container
+    uint64                      compressedSize; ///< Size of the payload
+    uint64                      size;           ///< Size once decompressed
+};
+
+struct SeekableIndex
+{
+    Compression                 codec;          ///< Compression of the frames
+    std::vector<SeekableFrame>  frames;         ///< Headers frame followed by one frame per section
+};
+
+/**
+ * @brief Returns the default compression level of the codec
+ */
+int getDefaultCompressionLevel(Compression codec);
+
+/**
+ * @brief Compresses the MRC file read from the stream into a seekable
+ * container, compressing sections in parallel. The original byte order is
+ * kept. Returns the amount of bytes of the MRC file, 0 on error
+ */
+size_t writeSeekable(   std::istream& is,
+                        std::ostream& os,
+                        Compression codec,
+                        int level,
+                        size_t threadCount );
+
+/**
+ * @brief Reads the index from the footer of the container. Returns false if
+ * a frame lies outside of the frames area or its decompressed size does not
+ * fit the layout: section frames of the same size, up to 4GiB.
+ * The position of the stream is not preserved
+ */
+bool readSeekableIndex(std::istream& is, SeekableIndex& index);
+
+/**
+ * @brief Creates a stream buffer over the decompressed contents of the
+ * container. Seeking decompresses only the frame at the new position, so
+ * a section can be read without decompressing the rest of the file.
+ * Sequential reads decompress batches of frames in parallel, holding up to
+ * 64MiB of them unless a single frame is larger.
+ * Returns nullptr if the index can not be read or the codec is not supported
+ */
+std::unique_ptr<std::streambuf> makeSeekableStreambuf(std::istream& source, size_t threadCount);
+
+}
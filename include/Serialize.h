@@ -0,0 +1,121 @@
+#pragma once
+
+#include "MainHeader.h"
+#include "Statistics.h"
+#include "Validate.h"
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MrcInspector
+{
+
+enum class OutputFormat
+{
+    text,       ///< Padded human readable text
+    json,       ///< A JSON object per line (JSON Lines)
+    cbor,       ///< A CBOR map per file, one after another (CBOR sequence)
+};
+
+/**
+ * @brief Streaming JSON writer. Values are formatted straight into the end of
+ * the buffer, without building a document first. Reusing the buffer (clearing
+ * it) makes writing allocation free once it has grown enough.
+ * Strings are copied as UTF-8, escaping only control characters, quotes and
+ * backslashes. Each byte that is not part of valid UTF-8 becomes U+FFFD
+ */
+class JsonWriter
+{
+public:
+    explicit JsonWriter(std::string& buffer);
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+    void key(std::string_view name);
+
+    void value(uint64 x);
+    void value(int64 x);
+    void value(float32 x);
+    void value(float64 x);
+    void value(bool x);
+    void value(std::string_view x);
+    void value(const char* x) { value(std::string_view(x)); }
+
+private:
+    static constexpr size_t MAX_DEPTH = 64;
+
+    std::string&                m_buffer;
+    size_t                      m_depth = 0;
+    std::array<bool, MAX_DEPTH> m_empty = {};   ///< Whether each open container has no elements yet
+    bool                        m_afterKey = false;
+
+    void separate();
+    template<typename T>
+    void number(T x);
+};
+
+/**
+ * @brief Streaming CBOR (RFC 8949) writer with the same interface as JsonWriter.
+ * Maps and arrays are written with indefinite length, so their size does not
+ * need to be known up front. Strings are written as text if they are valid
+ * UTF-8 and as byte strings otherwise
+ */
+class CborWriter
+{
+public:
+    explicit CborWriter(std::string& buffer);
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+    void key(std::string_view name);
+
+    void value(uint64 x);
+    void value(int64 x);
+    void value(float32 x);
+    void value(float64 x);
+    void value(bool x);
+    void value(std::string_view x);
+    void value(const char* x) { value(std::string_view(x)); }
+
+private:
+    std::string&                m_buffer;
+
+    void head(uint8 major, uint64 argument);
+};
+
+/**
+ * @brief Writes the fields of the header as an object. Labels are trimmed, the
+ * extended header type is written as its characters and the byte order as its
+ * stamp in hex. The mode name of IMOD's unsigned bytes is "unsigned int8"
+ */
+void serializeHeader(JsonWriter& writer, const MainHeader& header);
+void serializeHeader(CborWriter& writer, const MainHeader& header);
+
+/**
+ * @brief Writes the type and size of the extended header as an object. The
+ * records of each section are also written for the Agard layout (nInt 
+ * integers and nReal reals) and for the FEI1 and FEI2 layouts (their common 
+ * leading fields). Other layouts are not decoded
+ */
+void serializeExtendedHeader(JsonWriter& writer, const MainHeader& header, const std::string& extHeader);
+void serializeExtendedHeader(CborWriter& writer, const MainHeader& header, const std::string& extHeader);
+
+/**
+ * @brief Writes the count, min, max, mean and RMS deviation as an object
+ */
+void serializeStatistics(JsonWriter& writer, const Statistics& statistics);
+void serializeStatistics(CborWriter& writer, const Statistics& statistics);
+
+/**
+ * @brief Writes the classification and the failed rules as an object
+ */
+void serializeValidation(JsonWriter& writer, Validity validity, const std::vector<const ValidationRule*>& issues);
+void serializeValidation(CborWriter& writer, Validity validity, const std::vector<const ValidationRule*>& issues);
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "DataTypes.h"
+
+#include <string>
+#include <string_view>
+
+namespace MrcInspector
+{
+
+/**
+ * Protocol. Clients connect to a Unix domain socket and send requests, one
+ * per line. Paths are the rest of the line, so they may contain spaces, and
+ * are resolved relative to the working directory of the server:
+ *  - header PATH                   Main and extended header
+ *  - stats PATH                    Statistics of the data block
+ *  - slice AXIS INDEX PATH         Plane orthogonal to x, y or z, as --slice
+ *  - region X Y Z W H D PATH       Region, as --roi
+ *  - status                        Header cache hits and misses
+ *  - shutdown                      Stops the server
+ *
+ * Each request is answered by a status line, "OK N" or "ERROR N", followed by
+ * N bytes of text: the same output as the command line, or the error message.
+ * Connections stay open for further requests until the client closes them.
+ * Threads are busy only while answering requests, so idle connections cost
+ * no thread
+ */
+
+constexpr size_t DEFAULT_HEADER_CACHE_SIZE = 1024;
+
+struct ServerOptions
+{
+    size_t                      cacheSize;      ///< Maximum amount of files in the header cache
+    size_t                      threadCount;    ///< Amount of requests answered at once
+};
+
+struct ServerResponse
+{
+    bool                        success;        ///< False if the server answered with an error
+    std::string                 text;           ///< Output or error message
+};
+
+/**
+ * @brief Listens on the socket and serves clients from a pool of threads
+ * until a shutdown request arrives. A stale socket at the path is replaced.
+ * Returns false if the socket can not be created or accepting connections
+ * fails for a reason other than running out of descriptors
+ */
+bool runServer(const char* socketPath, const ServerOptions& options);
+
+/**
+ * @brief Sends a request to the server and waits for its response.
+ * Returns false if the server can not be reached or hangs up
+ */
+bool sendRequest(const char* socketPath, std::string_view request, ServerResponse& response);
+
+}
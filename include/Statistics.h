@@ -0,0 +1,165 @@
+#pragma once
+
+#include "MainHeader.h"
+#include "Numeric.h"
+#include "FileRead.h"
+
+#include <algorithm>
+#include <istream>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace MrcInspector
+{
+
+struct Statistics
+{
+    size_t                      count;          ///< Number of values accumulated
+    float64                     min;            ///< Minimum value
+    float64                     max;            ///< Maximum value
+    float64                     sum;            ///< Sum of the values
+    float64                     sumSquares;     ///< Sum of the squared values
+};
+
+/**
+ * @brief Returns statistics of an empty set, neutral for merging
+ */
+constexpr Statistics makeStatistics()
+{
+    return Statistics{
+        0,
+        std::numeric_limits<float64>::infinity(),
+        -std::numeric_limits<float64>::infinity(),
+        0.0,
+        0.0
+    };
+}
+
+inline void mergeStatistics(Statistics& lhs, const Statistics& rhs)
+{
+    lhs.count += rhs.count;
+    lhs.min = std::min(lhs.min, rhs.min);
+    lhs.max = std::max(lhs.max, rhs.max);
+    lhs.sum += rhs.sum;
+    lhs.sumSquares += rhs.sumSquares;
+}
+
+inline float64 getMean(const Statistics& statistics)
+{
+    return statistics.count ? statistics.sum / statistics.count : 0.0;
+}
+
+/**
+ * @brief Returns the standard deviation from the mean, which is 
+ * what the header calls RMS deviation
+ */
+inline float64 getRms(const Statistics& statistics)
+{
+    const auto mean = getMean(statistics);
+    const auto variance = statistics.count ? statistics.sumSquares / statistics.count - mean*mean : 0.0;
+    return std::sqrt(std::max(variance, 0.0));
+}
+
+/**
+ * @brief Accumulates bytes with integer arithmetic, which is exact and packs
+ * many more values per vector register than float64. The sums are flushed
+ * every BLOCK_SIZE values, before the 32bit accumulators could overflow
+ */
+template<typename T>
+inline void accumulateByteStatistics(Statistics& statistics, const T* data, size_t count)
+{
+    static_assert(sizeof(T) == 1, "Only for bytes");
+    constexpr size_t BLOCK_SIZE = 1 << 15; //255^2 * 2^15 < 2^32
+
+    int32 min = std::numeric_limits<T>::max();
+    int32 max = std::numeric_limits<T>::min();
+    int64 sum = 0;
+    uint64 sumSquares = 0;
+    for(size_t begin = 0; begin < count; begin += BLOCK_SIZE)
+    {
+        const auto end = std::min(begin + BLOCK_SIZE, count);
+        int32 blockSum = 0;
+        uint32 blockSumSquares = 0;
+        for(size_t i = begin; i < end; ++i)
+        {
+            const int32 value = data[i];
+            min = std::min(min, value);
+            max = std::max(max, value);
+            blockSum += value;
+            blockSumSquares += static_cast<uint32>(value*value);
+        }
+        sum += blockSum;
+        sumSquares += blockSumSquares;
+    }
+
+    statistics.count += count;
+    if(count)
+    {
+        statistics.min = std::min(statistics.min, static_cast<float64>(min));
+        statistics.max = std::max(statistics.max, static_cast<float64>(max));
+    }
+    statistics.sum += static_cast<float64>(sum);
+    statistics.sumSquares += static_cast<float64>(sumSquares);
+}
+
+/**
+ * @brief Accumulates the given values. Complex values are accumulated by 
+ * their modulus. Written as a single branch-free loop so that it can be 
+ * vectorized and fused right after the code producing the values
+ */
+template<typename T>
+inline void accumulateStatistics(Statistics& statistics, const T* data, size_t count)
+{
+    if constexpr (std::is_same<T, int8>::value || std::is_same<T, uint8>::value)
+    {
+        accumulateByteStatistics(statistics, data, count);
+        return;
+    }
+
+    auto min = statistics.min;
+    auto max = statistics.max;
+    float64 sum = 0;
+    float64 sumSquares = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+        const auto value = toFloat64(data[i]);
+        min = std::min(min, value);
+        max = std::max(max, value);
+        sum += value;
+        sumSquares += value*value;
+    }
+
+    statistics.count += count;
+    statistics.min = min;
+    statistics.max = max;
+    statistics.sum += sum;
+    statistics.sumSquares += sumSquares;
+}
+
+/**
+ * @brief Computes the statistics of a data block in parallel
+ */
+Statistics computeStatistics(const DataBlock& data, size_t threadCount);
+
+/**
+ * @brief Computes the statistics of the data block read from the stream, which
+ * must be at its start, a few sections at a time so that it does not need to fit
+ * in memory. Returns the amount of sections read
+ */
+size_t computeStreamStatistics(std::istream& is, const MainHeader& header, size_t threadCount, Statistics& statistics);
+
+/**
+ * @brief Computes the statistics of the data block of the file at the given path,
+ * read with a file reader (see readDataChunks) instead of a stream. Chunks are
+ * accumulated as they are read, from the reading threads. Packed modes are not
+ * supported. Returns the amount of sections read
+ */
+size_t computeFileStatistics(const char* path, const MainHeader& header, const FileReadOptions& options, Statistics& statistics);
+
+/**
+ * @brief Writes the min, max, mean and RMS deviation into the header
+ */
+void updateHeaderStatistics(MainHeader& header, const Statistics& statistics);
+
+}
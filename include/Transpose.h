@@ -0,0 +1,36 @@
+#pragma once
+
+#include "MainHeader.h"
+
+namespace MrcInspector
+{
+
+/**
+ * @brief Returns true if the column, row and section mapping is a 
+ * permutation of x, y and z
+ */
+bool isValidAxisMapping(const std::array<AxisMapping, 3>& axisMapping);
+
+/**
+ * @brief Returns true if the data is already stored as column=x, row=y, section=z
+ */
+bool isCanonicalAxisMapping(const std::array<AxisMapping, 3>& axisMapping);
+
+/**
+ * @brief Returns the header describing the data permuted to the canonical 
+ * order. Dimensions and starts are permuted, while sampling and cell 
+ * dimensions are already given along x, y and z. The extended header,
+ * which holds per-section metadata, is dropped when sections change
+ */
+MainHeader makeCanonicalHeader(const MainHeader& header);
+
+/**
+ * @brief Permutes the data block so that columns, rows and sections 
+ * correspond to x, y and z according to the header's axis mapping.
+ * The permutation is computed by tiles that fit in cache, so that neither
+ * the reads nor the writes are strided through the whole volume.
+ * Returns false if the axis mapping is not valid
+ */
+bool transposeToCanonical(const MainHeader& header, const DataBlock& src, DataBlock& dst, size_t threadCount);
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "MainHeader.h"
+
+#include <istream>
+#include <string_view>
+#include <vector>
+
+namespace MrcInspector
+{
+
+enum class Validity
+{
+    valid,          ///< Passes every rule
+    suspicious,     ///< Readable, but some field looks wrong
+    corrupt,        ///< Reading the data with it would fail or misbehave
+};
+
+constexpr std::string_view toString(Validity x)
+{
+    switch (x)
+    {
+    case Validity::valid:       return "valid";
+    case Validity::suspicious:  return "suspicious";
+    case Validity::corrupt:     return "corrupt";
+    default:                    return "";
+    }
+}
+
+/**
+ * @brief What is known about the file besides its header
+ */
+struct ValidationContext
+{
+    uint64                      fileSize;       ///< Size of the file in bytes, 0 if unknown (e.g. compressed)
+};
+
+struct ValidationRule
+{
+    std::string_view            name;           ///< Short identifier of the rule
+    Validity                    severity;       ///< Classification of the file when it fails
+    std::string_view            message;        ///< Description of the failure
+    bool (*check)(const MainHeader& header, const ValidationContext& context); ///< True if the header passes
+};
+
+/**
+ * @brief Largest data block accepted when the size of the file is not known.
+ * Readers of such streams also allocate in step with the bytes received, so
+ * a header within the bound can not drive a huge allocation either
+ */
+constexpr uint64 MAX_UNKNOWN_DATA_SIZE = uint64(1) << 40;
+
+/**
+ * @brief Returns the context of a stream positioned right after the main
+ * header. Its size is only known if it can seek, which is then restored
+ */
+ValidationContext getValidationContext(std::istream& is);
+
+/**
+ * @brief Returns the rules, corrupting ones first
+ */
+const std::vector<ValidationRule>& getValidationRules();
+
+/**
+ * @brief Checks a decoded header against the rules, before anything else of the
+ * file is read. Only looks at the fields, so it takes well under a microsecond.
+ * If issues is given, the failed rules are appended to it; otherwise it stops at
+ * the first corrupting one
+ */
+Validity validateHeader(const MainHeader& header, const ValidationContext& context, std::vector<const ValidationRule*>* issues = nullptr);
+
+}
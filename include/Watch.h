@@ -0,0 +1,63 @@
+#pragma once
+
+#include "MainHeader.h"
+#include "Statistics.h"
+#include "Validate.h"
+
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace MrcInspector
+{
+
+struct Inspection
+{
+    std::string                 path;           ///< Inspected file
+    bool                        valid;          ///< False if the file did not pass the checks
+    std::string                 error;          ///< Why it is not valid
+    Validity                    validity;       ///< Classification of the header
+    std::vector<const ValidationRule*> issues;  ///< Rules the header does not pass
+    MainHeader                  header;         ///< Decoded header, if it could be read
+    Statistics                  statistics;     ///< Statistics of the data block, if it could be read
+    std::time_t                 time;           ///< When the inspection finished
+    float64                     latency;        ///< Seconds from the notification to the end of the inspection
+};
+
+struct WatchOptions
+{
+    int                         idleTimeout;    ///< Stop after this many ms without new files, never if negative
+    size_t                      threadCount;    ///< Files inspected at once
+    size_t                      backlog;        ///< Files waiting for a worker before notifications stop being read
+};
+
+struct WatchSummary
+{
+    size_t                      fileCount;      ///< Files inspected
+    size_t                      overflowCount;  ///< Times the kernel dropped notifications
+};
+
+/**
+ * @brief Called from the worker threads, concurrently, once per inspected file
+ */
+using InspectionCallback = std::function<void(const Inspection&)>;
+
+/**
+ * @brief Checks that the header can be decoded and passes the validation rules
+ * against the size of the file, and computes the statistics of the data block.
+ * Corrupt files are rejected before anything past the main header is read
+ */
+Inspection inspectFile(const std::string& path);
+
+/**
+ * @brief Watches the directory tree with inotify and inspects every MRC file
+ * that is closed after writing or moved into it, in a pool of threads. Files
+ * found in new directories are inspected once they stop changing. While
+ * all of them are busy and the backlog is full, notifications are left queued
+ * in the kernel. Returns when the directory is deleted or moved, or after the
+ * idle timeout. False if it can not be watched
+ */
+bool watchDirectory(const char* path, const WatchOptions& options, const InspectionCallback& callback, WatchSummary& summary);
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace MrcInspector
+{
+
+/**
+ * @brief Blocking FIFO queue for handing work to a pool of threads.
+ * When it holds capacity items, push blocks until one is popped, so
+ * that producers are slowed down to the pace of the consumers
+ */
+template<typename T>
+class WorkQueue
+{
+public:
+    explicit WorkQueue(size_t capacity)
+        : m_capacity(capacity)
+    {
+    }
+
+    /**
+     * @brief Adds an item, waiting for room. Returns false if the queue was closed
+     */
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+        if(m_closed)
+        {
+            return false;
+        }
+
+        m_items.push_back(std::move(item));
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Takes the oldest item, waiting for one. Returns nothing once
+     * the queue is closed and empty
+     */
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+        if(m_items.empty())
+        {
+            return std::nullopt;
+        }
+
+        auto result = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return result;
+    }
+
+    /**
+     * @brief Wakes up everyone. Pending items can still be popped
+     */
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_items.size();
+    }
+
+private:
+    size_t                          m_capacity;
+    bool                            m_closed = false;
+    std::deque<T>                   m_items;
+    mutable std::mutex              m_mutex;
+    std::condition_variable         m_notEmpty;
+    std::condition_variable         m_notFull;
+};
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "MainHeader.h"
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace MrcInspector
+{
+
+/**
+ * @brief Writes the header in the native byte order of this machine.
+ * The byteOrder field of the header is ignored and replaced by the native stamp
+ */
+size_t writeMainHeader(std::ostream& os, const MainHeader& header);
+size_t writeExtendedHeader(std::ostream& os, const std::string& extHeader);
+
+/**
+ * @brief Writes the values in the native byte order of this machine. Can be
+ * called repeatedly for streaming sections
+ */
+size_t writeData(std::ostream& os, const DataBlock& data);
+
+/**
+ * @brief Writes the values as the mode of the header stores them. Rows of
+ * packed modes are packed, each of them starting on a byte. Returns the
+ * amount of bytes written
+ */
+size_t writeData(std::ostream& os, const MainHeader& header, const DataBlock& data);
+
+/**
+ * @brief Appends a label to the header if there is room for it. Used
+ * for recording the processing applied to derived files
+ */
+void appendLabel(MainHeader& header, std::string_view text);
+
+}
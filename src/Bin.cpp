@@ -0,0 +1,254 @@
+#include <Bin.h>
+
+#include <Read.h>
+#include <Write.h>
+#include <Numeric.h>
+#include <Parallel.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/** STATIC FUNCTIONS **/
+
+static size_t divideCeil(size_t num, size_t den)
+{
+    return (num + den - 1) / den;
+}
+
+static int64 divideFloor(int64 num, int64 den)
+{
+    const auto result = num / den;
+    return (num % den != 0 && num < 0) ? result - 1 : result;
+}
+
+template<typename T>
+using Accumulator = typename std::conditional<isComplex<T>, cfloat128, float64>::type;
+
+template<typename T>
+using Binned = typename std::conditional<isComplex<T>, cfloat64, float32>::type;
+
+template<typename T>
+static Accumulator<T> toAccumulator(const T& value)
+{
+    if constexpr (isComplex<T>)
+    {
+        return toComplex128(value);
+    }
+    else
+    {
+        return static_cast<float64>(value);
+    }
+}
+
+template<typename T>
+static void accumulateRow(  const T* row, 
+                            size_t nColumns, 
+                            size_t factor, 
+                            Accumulator<T>* acc )
+{
+    //Full blocks. Reduce factor consecutive columns at a time
+    const auto nFull = nColumns / factor;
+    for(size_t c = 0; c < nFull; ++c)
+    {
+        Accumulator<T> sum = 0;
+        for(size_t i = 0; i < factor; ++i)
+        {
+            sum += toAccumulator(row[c*factor + i]);
+        }
+        acc[c] += sum;
+    }
+
+    //Partial block at the edge
+    if(nFull*factor < nColumns)
+    {
+        Accumulator<T> sum = 0;
+        for(size_t i = nFull*factor; i < nColumns; ++i)
+        {
+            sum += toAccumulator(row[i]);
+        }
+        acc[nFull] += sum;
+    }
+}
+
+template<typename T>
+struct BinLevel
+{
+    size_t                          factor;         ///< Binning factor
+    size_t                          nColumns;       ///< Binned columns
+    size_t                          nRows;          ///< Binned rows
+    size_t                          nSections;      ///< Sections accumulated for the current binned section
+    std::vector<Accumulator<T>>     acc;            ///< Sums of the current binned section
+    DataBlock                       binned;         ///< Averages of the current binned section
+};
+
+template<typename T>
+static size_t binDataImpl(  std::istream& is, 
+                            const MainHeader& header, 
+                            const std::vector<size_t>& factors,
+                            size_t threadCount,
+                            const BinnedSectionCallback& callback,
+                            DataBlock& data,
+                            std::vector<Statistics>& statistics )
+{
+    const size_t nColumns = header.dimensions[0];
+    const size_t nRows = header.dimensions[1];
+    const size_t nSections = header.dimensions[2];
+
+    std::vector<BinLevel<T>> levels;
+    levels.reserve(factors.size());
+    for(const auto factor : factors)
+    {
+        const auto nBinnedColumns = divideCeil(nColumns, factor);
+        const auto nBinnedRows = divideCeil(nRows, factor);
+        levels.push_back(BinLevel<T>{
+            factor, nBinnedColumns, nBinnedRows, 0,
+            std::vector<Accumulator<T>>(nBinnedColumns * nBinnedRows, Accumulator<T>(0)),
+            std::vector<Binned<T>>(nBinnedColumns * nBinnedRows)
+        });
+    }
+
+    for(size_t s = 0; s < nSections; ++s)
+    {
+        if(readSections(is, header, 1, data) != getSectionSize(header))
+        {
+            return s; //Truncated
+        }
+        const auto& values = std::get<std::vector<T>>(data);
+
+        for(size_t l = 0; l < levels.size(); ++l)
+        {
+            auto& level = levels[l];
+            const auto factor = level.factor;
+
+            //Accumulate the section. Binned rows are independent, 
+            //so they are computed in parallel
+            parallelFor(
+                level.nRows, threadCount,
+                [&values, &level, nColumns, nRows, factor] (size_t j)
+                {
+                    const auto end = std::min((j+1)*factor, nRows);
+                    for(size_t r = j*factor; r < end; ++r)
+                    {
+                        accumulateRow(values.data() + r*nColumns, nColumns, factor, level.acc.data() + j*level.nColumns);
+                    }
+                }
+            );
+            ++level.nSections;
+            if(level.nSections < factor && s + 1 < nSections)
+            {
+                continue; //Binned section not complete yet
+            }
+
+            //Average by the number of voxels of each block
+            auto& binnedValues = std::get<std::vector<Binned<T>>>(level.binned);
+            for(size_t j = 0; j < level.nRows; ++j)
+            {
+                const auto nBlockRows = std::min((j+1)*factor, nRows) - j*factor;
+                for(size_t c = 0; c < level.nColumns; ++c)
+                {
+                    const auto nBlockColumns = std::min((c+1)*factor, nColumns) - c*factor;
+                    const auto nVoxels = static_cast<float64>(nBlockColumns * nBlockRows * level.nSections);
+                    const auto index = j*level.nColumns + c;
+                    binnedValues[index] = static_cast<Binned<T>>(level.acc[index] / nVoxels);
+                }
+            }
+            accumulateStatistics(statistics[l], binnedValues.data(), binnedValues.size());
+
+            if(!callback(l, level.binned))
+            {
+                return s;
+            }
+            std::fill(level.acc.begin(), level.acc.end(), Accumulator<T>(0));
+            level.nSections = 0;
+        }
+    }
+
+    return nSections;
+}
+
+/** PUBLIC FUNCTIONS **/
+
+Mode getBinnedMode(Mode mode)
+{
+    switch (mode)
+    {
+    case Mode::cint16:
+    case Mode::cfloat32:
+        return Mode::cfloat32;
+    default:
+        return Mode::float32;
+    }
+}
+
+MainHeader makeBinnedHeader(const MainHeader& header, size_t factor)
+{
+    auto result = header;
+    result.mode = getBinnedMode(header.mode);
+    clearExtendedHeader(result); //Per-section metadata does not apply anymore
+    clearUnusedFields(result);
+    for(size_t i = 0; i < 3; ++i)
+    {
+        //The cell keeps its size, so the sampling is reduced
+        result.dimensions[i] = divideCeil(header.dimensions[i], factor);
+        result.sampling[i] = divideCeil(header.sampling[i], factor);
+        //The start is signed, although it is stored as unsigned
+        const auto start = divideFloor(static_cast<int32>(header.start[i]), static_cast<int64>(factor));
+        result.start[i] = static_cast<uint32>(static_cast<int32>(start));
+    }
+    appendLabel(result, "mrcinspector: binned by " + std::to_string(factor));
+    return result;
+}
+
+size_t binData( std::istream& is, 
+                const MainHeader& header, 
+                size_t factor,
+                std::ostream& os, 
+                size_t threadCount,
+                Statistics& statistics )
+{
+    size_t result = 0;
+    std::vector<Statistics> levelStatistics = { statistics };
+    binDataLevels(
+        is, header, { factor }, threadCount,
+        [&os, &result] (size_t, const DataBlock& binned)
+        {
+            const auto written = writeData(os, binned);
+            result += written;
+            return written > 0;
+        },
+        levelStatistics
+    );
+
+    statistics = levelStatistics.front();
+    return result;
+}
+
+size_t binDataLevels(   std::istream& is, 
+                        const MainHeader& header, 
+                        const std::vector<size_t>& factors,
+                        size_t threadCount,
+                        const BinnedSectionCallback& callback,
+                        std::vector<Statistics>& statistics )
+{
+    DataBlock section;
+    const bool validFactors = std::find(factors.cbegin(), factors.cend(), 0) == factors.cend();
+    if(!validFactors || statistics.size() != factors.size() || !emplaceDataBlock(section, header))
+    {
+        return 0;
+    }
+
+    return std::visit(
+        [&is, &header, &factors, threadCount, &callback, &section, &statistics] (const auto& values)
+        {
+            using T = typename std::decay<decltype(values)>::type::value_type;
+            return binDataImpl<T>(is, header, factors, threadCount, callback, section, statistics);
+        },
+        section
+    );
+}
+
+}
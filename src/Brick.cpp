@@ -0,0 +1,291 @@
+#include <Brick.h>
+
+#include <Read.h>
+#include <ByteSwap.h>
+#include <Parallel.h>
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr std::string_view BRICK_CACHE_MAGIC = "MRCB";
+static constexpr uint32 BRICK_CACHE_VERSION = 1;
+
+/** STATIC FUNCTIONS **/
+
+static size_t divideCeil(size_t num, size_t den)
+{
+    return (num + den - 1) / den;
+}
+
+template<typename T>
+static void storeLittleEndian(std::vector<char>& buffer, size_t offset, T value)
+{
+    makeLittleEndian(value);
+    std::memcpy(buffer.data() + offset, &value, sizeof(value));
+}
+
+template<typename T>
+static T loadLittleEndian(const std::vector<char>& buffer, size_t offset)
+{
+    T value;
+    std::memcpy(&value, buffer.data() + offset, sizeof(value));
+    makeLittleEndian(value);
+    return value;
+}
+
+static std::array<size_t, 3> getBrickCounts(const BrickCache& cache)
+{
+    return {
+        divideCeil(cache.dimensions[0], cache.brickSize),
+        divideCeil(cache.dimensions[1], cache.brickSize),
+        divideCeil(cache.dimensions[2], cache.brickSize)
+    };
+}
+
+static size_t getBrickBytes(const BrickCache& cache)
+{
+    return cache.brickSize * cache.brickSize * cache.brickSize * getModeSize(cache.mode);
+}
+
+/** PUBLIC FUNCTIONS **/
+
+std::string getBrickCachePath(const char* path)
+{
+    return std::string(path) + ".bricks";
+}
+
+size_t buildBrickCache( std::istream& is,
+                        const MainHeader& header,
+                        size_t brickSize,
+                        const FileStamp& source,
+                        std::ostream& os,
+                        size_t threadCount )
+{
+    const BrickCache cache = {
+        brickSize,
+        header.mode,
+        { header.dimensions[0], header.dimensions[1], header.dimensions[2] },
+        source
+    };
+    const auto elementSize = getModeSize(header.mode);
+    if(brickSize == 0 || elementSize == 0)
+    {
+        return 0;
+    }
+
+    //Header
+    std::vector<char> buffer(BRICK_CACHE_HEADER_SIZE, 0);
+    std::copy(BRICK_CACHE_MAGIC.cbegin(), BRICK_CACHE_MAGIC.cend(), buffer.begin());
+    storeLittleEndian<uint32>(buffer, 4, BRICK_CACHE_VERSION);
+    storeLittleEndian<uint32>(buffer, 8, brickSize);
+    storeLittleEndian<uint32>(buffer, 12, static_cast<uint32>(header.mode));
+    for(size_t i = 0; i < 3; ++i)
+    {
+        storeLittleEndian<uint32>(buffer, 16 + 4*i, header.dimensions[i]);
+    }
+    auto byteOrder = getNativeEndianess();
+    makeBigEndian(byteOrder);
+    std::memcpy(buffer.data() + 28, &byteOrder, sizeof(byteOrder));
+    storeLittleEndian<uint64>(buffer, 32, source.size);
+    storeLittleEndian<int64>(buffer, 40, source.modificationTime);
+    os.write(buffer.data(), buffer.size());
+
+    //Bricks, a slab of sections at a time
+    const auto brickCounts = getBrickCounts(cache);
+    const auto brickBytes = getBrickBytes(cache);
+    const size_t nColumns = header.dimensions[0];
+    const size_t nRows = header.dimensions[1];
+    std::vector<std::byte> bricks(brickCounts[0] * brickCounts[1] * brickBytes);
+    DataBlock slab;
+    size_t result = 0;
+    for(size_t bz = 0; bz < brickCounts[2]; ++bz)
+    {
+        const auto nSections = std::min(brickSize, cache.dimensions[2] - bz*brickSize);
+        const auto expected = nSections * getSectionSize(header);
+        const auto count = readSections(is, header, nSections, slab);
+        if(count != expected)
+        {
+            return 0;
+        }
+        result += count;
+
+        const std::byte* slabData = nullptr;
+        std::visit(
+            [&slabData] (const auto& values)
+            {
+                slabData = reinterpret_cast<const std::byte*>(values.data());
+            },
+            slab
+        );
+
+        //Assemble the bricks of the slab in parallel
+        parallelFor(
+            brickCounts[0] * brickCounts[1], threadCount,
+            [&] (size_t i)
+            {
+                const auto bx = i % brickCounts[0];
+                const auto by = i / brickCounts[0];
+                const auto nBrickColumns = std::min(brickSize, nColumns - bx*brickSize);
+                const auto nBrickRows = std::min(brickSize, nRows - by*brickSize);
+                auto* brick = bricks.data() + i*brickBytes;
+                std::fill(brick, brick + brickBytes, std::byte(0));
+                for(size_t z = 0; z < nSections; ++z)
+                {
+                    for(size_t y = 0; y < nBrickRows; ++y)
+                    {
+                        const auto* src = slabData + ((z*nRows + by*brickSize + y)*nColumns + bx*brickSize) * elementSize;
+                        auto* dst = brick + ((z*brickSize + y)*brickSize) * elementSize;
+                        std::memcpy(dst, src, nBrickColumns * elementSize);
+                    }
+                }
+            }
+        );
+
+        os.write(reinterpret_cast<const char*>(bricks.data()), bricks.size());
+        if(!os.good())
+        {
+            return 0;
+        }
+    }
+
+    return result;
+}
+
+bool readBrickCacheHeader(std::istream& is, BrickCache& cache)
+{
+    std::vector<char> buffer(BRICK_CACHE_HEADER_SIZE);
+    is.read(buffer.data(), buffer.size());
+    if( !is.good() ||
+        std::string_view(buffer.data(), BRICK_CACHE_MAGIC.size()) != BRICK_CACHE_MAGIC ||
+        loadLittleEndian<uint32>(buffer, 4) != BRICK_CACHE_VERSION )
+    {
+        return false;
+    }
+
+    Endianess byteOrder;
+    std::memcpy(&byteOrder, buffer.data() + 28, sizeof(byteOrder));
+    makeBigEndian(byteOrder);
+    if(byteOrder != getNativeEndianess())
+    {
+        return false;
+    }
+
+    cache.brickSize = loadLittleEndian<uint32>(buffer, 8);
+    cache.mode = static_cast<Mode>(loadLittleEndian<uint32>(buffer, 12));
+    for(size_t i = 0; i < 3; ++i)
+    {
+        cache.dimensions[i] = loadLittleEndian<uint32>(buffer, 16 + 4*i);
+    }
+    cache.source.size = loadLittleEndian<uint64>(buffer, 32);
+    cache.source.modificationTime = loadLittleEndian<int64>(buffer, 40);
+    return cache.brickSize > 0 && getModeSize(cache.mode) > 0;
+}
+
+bool isBrickCacheValid(const BrickCache& cache, const MainHeader& header, const FileStamp& source)
+{
+    return  cache.mode == header.mode &&
+            cache.dimensions[0] == header.dimensions[0] &&
+            cache.dimensions[1] == header.dimensions[1] &&
+            cache.dimensions[2] == header.dimensions[2] &&
+            cache.source.size == source.size &&
+            cache.source.modificationTime == source.modificationTime;
+}
+
+size_t readBrickRegion(std::istream& is, const BrickCache& cache, const MainHeader& header, const Region& region, DataBlock& data)
+{
+    const auto elementSize = getModeSize(cache.mode);
+    const auto brickSize = cache.brickSize;
+    const auto brickCounts = getBrickCounts(cache);
+    const auto brickBytes = getBrickBytes(cache);
+    for(size_t i = 0; i < 3; ++i)
+    {
+        if(region.size[i] == 0 || region.origin[i] + region.size[i] > cache.dimensions[i])
+        {
+            return 0;
+        }
+    }
+    auto* output = allocateDataBlock(data, header, region.size[0] * region.size[1] * region.size[2]);
+    if(!output)
+    {
+        return 0;
+    }
+
+    //Range of bricks intersected by the region
+    std::array<size_t, 3> first, last;
+    for(size_t i = 0; i < 3; ++i)
+    {
+        first[i] = region.origin[i] / brickSize;
+        last[i] = (region.origin[i] + region.size[i] - 1) / brickSize;
+    }
+
+    //Read each row of bricks along x at once and copy the intersection
+    std::vector<std::byte> bricks((last[0] - first[0] + 1) * brickBytes);
+    size_t result = 0;
+    for(size_t bz = first[2]; bz <= last[2]; ++bz)
+    {
+        for(size_t by = first[1]; by <= last[1]; ++by)
+        {
+            const auto offset = BRICK_CACHE_HEADER_SIZE + ((bz*brickCounts[1] + by)*brickCounts[0] + first[0]) * brickBytes;
+            is.seekg(offset);
+            is.read(reinterpret_cast<char*>(bricks.data()), bricks.size());
+            if(static_cast<size_t>(is.gcount()) != bricks.size())
+            {
+                return 0;
+            }
+
+            //Intersection of the bricks with the region (y, z)
+            const auto z0 = std::max(region.origin[2], bz*brickSize);
+            const auto z1 = std::min(region.origin[2] + region.size[2], (bz+1)*brickSize);
+            const auto y0 = std::max(region.origin[1], by*brickSize);
+            const auto y1 = std::min(region.origin[1] + region.size[1], (by+1)*brickSize);
+            for(size_t bx = first[0]; bx <= last[0]; ++bx)
+            {
+                const auto x0 = std::max(region.origin[0], bx*brickSize);
+                const auto x1 = std::min(region.origin[0] + region.size[0], (bx+1)*brickSize);
+                const auto* brick = bricks.data() + (bx - first[0])*brickBytes;
+                for(size_t z = z0; z < z1; ++z)
+                {
+                    for(size_t y = y0; y < y1; ++y)
+                    {
+                        const auto* src = brick + (((z - bz*brickSize)*brickSize + (y - by*brickSize))*brickSize + (x0 - bx*brickSize)) * elementSize;
+                        auto* dst = output + (((z - region.origin[2])*region.size[1] + (y - region.origin[1]))*region.size[0] + (x0 - region.origin[0])) * elementSize;
+                        std::memcpy(dst, src, (x1 - x0) * elementSize);
+                        result += (x1 - x0) * elementSize;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+size_t readCachedRegion(const char* path, std::istream& is, const MainHeader& header, const Region& region, DataBlock& data)
+{
+    //Whole sections are contiguous in the file, read them from it directly
+    if(region.size[0] == header.dimensions[0] && region.size[1] == header.dimensions[1])
+    {
+        return readRegion(is, header, region, data);
+    }
+
+    FileStamp stamp;
+    BrickCache cache;
+    std::ifstream cacheFile(getBrickCachePath(path), std::ios_base::in | std::ios_base::binary);
+    if( cacheFile && getFileStamp(path, stamp) &&
+        readBrickCacheHeader(cacheFile, cache) && isBrickCacheValid(cache, header, stamp) )
+    {
+        return readBrickRegion(cacheFile, cache, header, region, data);
+    }
+
+    return readRegion(is, header, region, data);
+}
+
+}
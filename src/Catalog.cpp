@@ -0,0 +1,617 @@
+#include <Catalog.h>
+
+#include <Read.h>
+#include <Decompress.h>
+#include <Pyramid.h>
+#include <ByteSwap.h>
+#include <Parallel.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <unordered_map>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr std::string_view CATALOG_MAGIC = "MRCI";
+static constexpr uint32 CATALOG_VERSION = 2;
+static constexpr size_t CATALOG_HEADER_SIZE = 24;
+static constexpr size_t CATALOG_NAME_SIZE = 16;
+static constexpr size_t CATALOG_ENTRY_SIZE = CATALOG_NAME_SIZE + 16;
+
+//Offsets of the fields that do not come from the header
+static constexpr size_t FILE_SIZE_FIELD = static_cast<size_t>(-1);
+static constexpr size_t MODIFICATION_TIME_FIELD = static_cast<size_t>(-2);
+static constexpr size_t VOXEL_SIZE_FIELD = static_cast<size_t>(-3);
+
+struct FieldDefinition
+{
+    CatalogField                field;          ///< Name and type
+    size_t                      offset;         ///< Offset in MainHeader or one of the special fields
+};
+
+#define HEADER_FIELD(name, type, member, index) \
+    FieldDefinition{ { name, type }, offsetof(MainHeader, member) + (index)*4 }
+
+static const std::array<FieldDefinition, 36> FIELD_DEFINITIONS = {
+    FieldDefinition{ { "size", CatalogType::u64 }, FILE_SIZE_FIELD },
+    FieldDefinition{ { "mtime", CatalogType::i64 }, MODIFICATION_TIME_FIELD },
+    FieldDefinition{ { "voxel", CatalogType::f32 }, VOXEL_SIZE_FIELD },
+    HEADER_FIELD("columns", CatalogType::u32, dimensions, 0),
+    HEADER_FIELD("rows", CatalogType::u32, dimensions, 1),
+    HEADER_FIELD("sections", CatalogType::u32, dimensions, 2),
+    HEADER_FIELD("mode", CatalogType::u32, mode, 0),
+    HEADER_FIELD("startx", CatalogType::u32, start, 0),
+    HEADER_FIELD("starty", CatalogType::u32, start, 1),
+    HEADER_FIELD("startz", CatalogType::u32, start, 2),
+    HEADER_FIELD("mx", CatalogType::u32, sampling, 0),
+    HEADER_FIELD("my", CatalogType::u32, sampling, 1),
+    HEADER_FIELD("mz", CatalogType::u32, sampling, 2),
+    HEADER_FIELD("cellx", CatalogType::f32, cellDimensions, 0),
+    HEADER_FIELD("celly", CatalogType::f32, cellDimensions, 1),
+    HEADER_FIELD("cellz", CatalogType::f32, cellDimensions, 2),
+    HEADER_FIELD("alpha", CatalogType::f32, cellAngles, 0),
+    HEADER_FIELD("beta", CatalogType::f32, cellAngles, 1),
+    HEADER_FIELD("gamma", CatalogType::f32, cellAngles, 2),
+    HEADER_FIELD("mapc", CatalogType::u32, axisMapping, 0),
+    HEADER_FIELD("mapr", CatalogType::u32, axisMapping, 1),
+    HEADER_FIELD("maps", CatalogType::u32, axisMapping, 2),
+    HEADER_FIELD("min", CatalogType::f32, min, 0),
+    HEADER_FIELD("max", CatalogType::f32, max, 0),
+    HEADER_FIELD("mean", CatalogType::f32, avg, 0),
+    HEADER_FIELD("ispg", CatalogType::u32, ispg, 0),
+    HEADER_FIELD("next", CatalogType::u32, extHeaderLen, 0),
+    HEADER_FIELD("exttyp", CatalogType::u32, extHeaderType, 0),
+    HEADER_FIELD("version", CatalogType::u32, version, 0),
+    HEADER_FIELD("imodflags", CatalogType::u32, imodFlags, 0),
+    HEADER_FIELD("originx", CatalogType::f32, origin, 0),
+    HEADER_FIELD("originy", CatalogType::f32, origin, 1),
+    HEADER_FIELD("originz", CatalogType::f32, origin, 2),
+    HEADER_FIELD("machst", CatalogType::u32, byteOrder, 0),
+    HEADER_FIELD("rms", CatalogType::f32, rms, 0),
+    HEADER_FIELD("nlabl", CatalogType::u32, nLabels, 0),
+};
+
+#undef HEADER_FIELD
+
+static constexpr std::array<std::string_view, 6> CATALOG_EXTENSIONS = {
+    ".mrc", ".mrcs", ".map", ".st", ".ali", ".rec"
+};
+
+static constexpr std::array<std::string_view, 4> COMPRESSION_EXTENSIONS = {
+    ".gz", ".bz2", ".zst", ".mrcz"
+};
+
+/** STATIC FUNCTIONS **/
+
+static size_t getTypeSize(CatalogType type)
+{
+    switch (type)
+    {
+    case CatalogType::u32:
+    case CatalogType::f32:
+        return 4;
+    default:
+        return 8;
+    }
+}
+
+template<typename T>
+static void storeLittleEndian(std::vector<char>& buffer, size_t offset, T value)
+{
+    makeLittleEndian(value);
+    std::memcpy(buffer.data() + offset, &value, sizeof(value));
+}
+
+template<typename T>
+static T loadLittleEndian(const std::vector<char>& buffer, size_t offset)
+{
+    T value;
+    std::memcpy(&value, buffer.data() + offset, sizeof(value));
+    makeLittleEndian(value);
+    return value;
+}
+
+static bool endsWith(std::string_view str, std::string_view suffix)
+{
+    return str.size() >= suffix.size() && str.substr(str.size() - suffix.size()) == suffix;
+}
+
+/**
+ * @brief Writes values stored in native byte order as little endian
+ */
+static void writeValues(std::ostream& os, const std::byte* data, size_t count, size_t width)
+{
+    if(needsSwap(Endianess::le))
+    {
+        std::vector<std::byte> swapped(data, data + count*width);
+        swapEndianess(swapped.data(), count, width);
+        os.write(reinterpret_cast<const char*>(swapped.data()), swapped.size());
+    }
+    else
+    {
+        os.write(reinterpret_cast<const char*>(data), count*width);
+    }
+}
+
+/**
+ * @brief Reads little endian values into native byte order
+ */
+static bool readValues(std::istream& is, std::byte* data, size_t count, size_t width)
+{
+    is.read(reinterpret_cast<char*>(data), count*width);
+    if(needsSwap(Endianess::le))
+    {
+        swapEndianess(data, count, width);
+    }
+    return static_cast<size_t>(is.gcount()) == count*width;
+}
+
+static void appendRow(Catalog& catalog, const std::string& path, const FileStamp& stamp, const MainHeader& header)
+{
+    catalog.paths.push_back(path);
+    for(size_t i = 0; i < FIELD_DEFINITIONS.size(); ++i)
+    {
+        const auto& definition = FIELD_DEFINITIONS[i];
+        auto& values = catalog.columns[i].values;
+        const auto width = getTypeSize(definition.field.type);
+        values.resize(values.size() + width);
+        auto* value = values.data() + values.size() - width;
+
+        switch (definition.offset)
+        {
+        case FILE_SIZE_FIELD:
+            std::memcpy(value, &stamp.size, width);
+            break;
+        case MODIFICATION_TIME_FIELD:
+            std::memcpy(value, &stamp.modificationTime, width);
+            break;
+        case VOXEL_SIZE_FIELD:
+        {
+            const auto voxelSize = static_cast<float32>(getVoxelSize(header));
+            std::memcpy(value, &voxelSize, width);
+            break;
+        }
+        default:
+            std::memcpy(value, reinterpret_cast<const std::byte*>(&header) + definition.offset, width);
+            break;
+        }
+    }
+}
+
+static void copyRow(Catalog& catalog, const Catalog& source, size_t row)
+{
+    catalog.paths.push_back(source.paths[row]);
+    for(size_t i = 0; i < catalog.columns.size(); ++i)
+    {
+        const auto width = getTypeSize(catalog.columns[i].type);
+        const auto* value = source.columns[i].values.data() + row*width;
+        auto& values = catalog.columns[i].values;
+        values.insert(values.end(), value, value + width);
+    }
+}
+
+static Catalog makeEmptyCatalog()
+{
+    Catalog result;
+    for(const auto& definition : FIELD_DEFINITIONS)
+    {
+        result.columns.push_back(CatalogColumn{ definition.field.type, {} });
+    }
+    return result;
+}
+
+template<typename T, typename Compare>
+static void evaluateCondition(const std::vector<std::byte>& column, float64 value, Compare compare, std::vector<uint8>& mask)
+{
+    //Plain loop over the column, so that the compiler can vectorize it
+    const auto count = mask.size();
+    for(size_t i = 0; i < count; ++i)
+    {
+        T x;
+        std::memcpy(&x, column.data() + i*sizeof(T), sizeof(T));
+        mask[i] &= compare(static_cast<float64>(x), value);
+    }
+}
+
+template<typename T>
+static void evaluateCondition(const std::vector<std::byte>& column, const CatalogCondition& condition, std::vector<uint8>& mask)
+{
+    const auto value = condition.value;
+    switch (condition.op)
+    {
+    case CatalogOperator::equal:        evaluateCondition<T>(column, value, std::equal_to<float64>(), mask); break;
+    case CatalogOperator::notEqual:     evaluateCondition<T>(column, value, std::not_equal_to<float64>(), mask); break;
+    case CatalogOperator::less:         evaluateCondition<T>(column, value, std::less<float64>(), mask); break;
+    case CatalogOperator::lessEqual:    evaluateCondition<T>(column, value, std::less_equal<float64>(), mask); break;
+    case CatalogOperator::greater:      evaluateCondition<T>(column, value, std::greater<float64>(), mask); break;
+    case CatalogOperator::greaterEqual: evaluateCondition<T>(column, value, std::greater_equal<float64>(), mask); break;
+    default: break;
+    }
+}
+
+/** PUBLIC FUNCTIONS **/
+
+const std::vector<CatalogField>& getCatalogFields()
+{
+    static const auto result = [] ()
+    {
+        std::vector<CatalogField> fields;
+        for(const auto& definition : FIELD_DEFINITIONS)
+        {
+            fields.push_back(definition.field);
+        }
+        return fields;
+    }();
+
+    return result;
+}
+
+size_t findCatalogField(std::string_view name)
+{
+    const auto& fields = getCatalogFields();
+    return std::find_if(
+        fields.cbegin(), fields.cend(),
+        [name] (const CatalogField& field)
+        {
+            return field.name == name;
+        }
+    ) - fields.cbegin();
+}
+
+bool parseCatalogCondition(std::string_view str, CatalogCondition& condition)
+{
+    //Longest operators first, so that "<=" is not taken as "<"
+    constexpr std::array<std::pair<std::string_view, CatalogOperator>, 6> OPERATORS = {
+        std::make_pair("<=", CatalogOperator::lessEqual),
+        std::make_pair(">=", CatalogOperator::greaterEqual),
+        std::make_pair("!=", CatalogOperator::notEqual),
+        std::make_pair("=", CatalogOperator::equal),
+        std::make_pair("<", CatalogOperator::less),
+        std::make_pair(">", CatalogOperator::greater),
+    };
+
+    for(const auto& [symbol, op] : OPERATORS)
+    {
+        const auto position = str.find(symbol);
+        if(position != std::string_view::npos)
+        {
+            condition.field = findCatalogField(str.substr(0, position));
+            condition.op = op;
+            try
+            {
+                condition.value = std::stod(std::string(str.substr(position + symbol.size())));
+            }
+            catch(const std::exception&)
+            {
+                return false;
+            }
+            return condition.field < getCatalogFields().size();
+        }
+    }
+
+    return false;
+}
+
+bool isCatalogPath(std::string_view path)
+{
+    for(const auto& compression : COMPRESSION_EXTENSIONS)
+    {
+        if(endsWith(path, compression))
+        {
+            path.remove_suffix(compression.size());
+            break;
+        }
+    }
+
+    return std::any_of(
+        CATALOG_EXTENSIONS.cbegin(), CATALOG_EXTENSIONS.cend(),
+        [path] (std::string_view extension)
+        {
+            return endsWith(path, extension);
+        }
+    );
+}
+
+size_t refreshCatalog(Catalog& catalog, const std::vector<std::string>& paths, size_t threadCount)
+{
+    namespace fs = std::filesystem;
+
+    //List the files. Explicitly given files are taken regardless of their extension
+    std::vector<std::string> files;
+    for(const auto& path : paths)
+    {
+        std::error_code error;
+        if(fs::is_directory(path, error))
+        {
+            const auto options = fs::directory_options::skip_permission_denied;
+            for(fs::recursive_directory_iterator it(path, options, error), end; it != end; it.increment(error))
+            {
+                if(it->is_regular_file(error) && isCatalogPath(it->path().native()))
+                {
+                    files.push_back(it->path().string());
+                }
+            }
+        }
+        else if(fs::is_regular_file(path, error))
+        {
+            files.push_back(path);
+        }
+    }
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+
+    //Find the files that changed
+    std::unordered_map<std::string_view, size_t> previous;
+    for(size_t i = 0; i < catalog.paths.size(); ++i)
+    {
+        previous.emplace(catalog.paths[i], i);
+    }
+    const auto* sizes = reinterpret_cast<const std::byte*>(catalog.columns.empty() ? nullptr : catalog.columns[0].values.data());
+    const auto* times = reinterpret_cast<const std::byte*>(catalog.columns.empty() ? nullptr : catalog.columns[1].values.data());
+
+    std::vector<FileStamp> stamps(files.size());
+    std::vector<size_t> rows(files.size(), catalog.paths.size()); //Previous row if unchanged
+    std::vector<uint8> valid(files.size(), false);
+    parallelFor(
+        files.size(), threadCount,
+        [&] (size_t i)
+        {
+            valid[i] = getFileStamp(files[i].c_str(), stamps[i]);
+            const auto ite = previous.find(files[i]);
+            if(valid[i] && ite != previous.cend())
+            {
+                FileStamp stamp;
+                std::memcpy(&stamp.size, sizes + ite->second*sizeof(uint64), sizeof(uint64));
+                std::memcpy(&stamp.modificationTime, times + ite->second*sizeof(int64), sizeof(int64));
+                if(stamp.size == stamps[i].size && stamp.modificationTime == stamps[i].modificationTime)
+                {
+                    rows[i] = ite->second;
+                }
+            }
+        }
+    );
+
+    //Read the headers of the rest in parallel
+    std::vector<size_t> changed;
+    for(size_t i = 0; i < files.size(); ++i)
+    {
+        if(valid[i] && rows[i] == catalog.paths.size())
+        {
+            changed.push_back(i);
+        }
+    }
+    std::vector<MainHeader> headers(files.size());
+    parallelFor(
+        changed.size(), threadCount,
+        [&] (size_t j)
+        {
+            const auto i = changed[j];
+            Compression compression;
+            const auto is = openInputFile(files[i].c_str(), 1, compression);
+            valid[i] = is && readMainHeader(*is, headers[i]) == sizeof(MainHeader);
+        }
+    );
+
+    //Assemble the refreshed catalog in path order
+    auto result = makeEmptyCatalog();
+    for(size_t i = 0; i < files.size(); ++i)
+    {
+        if(rows[i] < catalog.paths.size())
+        {
+            copyRow(result, catalog, rows[i]);
+        }
+        else if(valid[i])
+        {
+            appendRow(result, files[i], stamps[i], headers[i]);
+        }
+    }
+
+    catalog = std::move(result);
+    return changed.size();
+}
+
+size_t writeCatalog(std::ostream& os, const Catalog& catalog)
+{
+    const auto rowCount = catalog.paths.size();
+    const auto columnCount = catalog.columns.size();
+    const auto& fields = getCatalogFields();
+    if(columnCount != fields.size())
+    {
+        return 0;
+    }
+
+    //Paths
+    std::vector<uint64> pathOffsets = { 0 };
+    for(const auto& path : catalog.paths)
+    {
+        pathOffsets.push_back(pathOffsets.back() + path.size());
+    }
+
+    //Lay out the columns after the paths, 8 byte aligned
+    const auto pathsOffset = CATALOG_HEADER_SIZE + columnCount*CATALOG_ENTRY_SIZE;
+    auto offset = pathsOffset + pathOffsets.size()*sizeof(uint64) + pathOffsets.back();
+    std::vector<uint64> columnOffsets;
+    for(const auto& column : catalog.columns)
+    {
+        offset = (offset + 7) / 8 * 8;
+        columnOffsets.push_back(offset);
+        offset += column.values.size();
+    }
+
+    //Header and directory
+    std::vector<char> buffer(pathsOffset, 0);
+    std::copy(CATALOG_MAGIC.cbegin(), CATALOG_MAGIC.cend(), buffer.begin());
+    storeLittleEndian<uint32>(buffer, 4, CATALOG_VERSION);
+    storeLittleEndian<uint64>(buffer, 8, rowCount);
+    storeLittleEndian<uint32>(buffer, 16, columnCount);
+    for(size_t i = 0; i < columnCount; ++i)
+    {
+        const auto entry = CATALOG_HEADER_SIZE + i*CATALOG_ENTRY_SIZE;
+        std::copy(fields[i].name.cbegin(), fields[i].name.cend(), buffer.begin() + entry);
+        storeLittleEndian<uint32>(buffer, entry + CATALOG_NAME_SIZE, static_cast<uint32>(catalog.columns[i].type));
+        storeLittleEndian<uint64>(buffer, entry + CATALOG_NAME_SIZE + 8, columnOffsets[i]);
+    }
+    os.write(buffer.data(), buffer.size());
+
+    //Paths, then the columns
+    writeValues(os, reinterpret_cast<const std::byte*>(pathOffsets.data()), pathOffsets.size(), sizeof(uint64));
+    for(const auto& path : catalog.paths)
+    {
+        os.write(path.data(), path.size());
+    }
+    for(size_t i = 0; i < columnCount; ++i)
+    {
+        const auto& column = catalog.columns[i];
+        const auto width = getTypeSize(column.type);
+        const auto padding = columnOffsets[i] - static_cast<uint64>(os.tellp());
+        os.write("\0\0\0\0\0\0\0", padding);
+        writeValues(os, column.values.data(), column.values.size() / width, width);
+    }
+
+    return os.good() ? offset : 0;
+}
+
+bool readCatalog(std::istream& is, Catalog& catalog, const std::vector<size_t>& fields)
+{
+    //Header
+    std::vector<char> buffer(CATALOG_HEADER_SIZE);
+    is.read(buffer.data(), buffer.size());
+    if( !is.good() ||
+        std::string_view(buffer.data(), CATALOG_MAGIC.size()) != CATALOG_MAGIC ||
+        loadLittleEndian<uint32>(buffer, 4) != CATALOG_VERSION )
+    {
+        return false;
+    }
+    const auto rowCount = loadLittleEndian<uint64>(buffer, 8);
+    const size_t columnCount = loadLittleEndian<uint32>(buffer, 16);
+
+    //Bound the counts by the size of the file before allocating anything
+    is.seekg(0, std::ios_base::end);
+    const auto fileSize = static_cast<uint64>(is.tellg());
+    is.seekg(CATALOG_HEADER_SIZE);
+    if(!is.good() || columnCount > (fileSize - CATALOG_HEADER_SIZE) / CATALOG_ENTRY_SIZE)
+    {
+        return false;
+    }
+    const auto pathsOffset = CATALOG_HEADER_SIZE + columnCount*CATALOG_ENTRY_SIZE;
+    if(rowCount >= (fileSize - pathsOffset) / sizeof(uint64))
+    {
+        return false;
+    }
+
+    //Directory. Columns are matched by name
+    const auto& definitions = getCatalogFields();
+    std::vector<uint64> offsets(definitions.size(), 0);
+    buffer.resize(columnCount * CATALOG_ENTRY_SIZE);
+    is.read(buffer.data(), buffer.size());
+    if(!is.good())
+    {
+        return false;
+    }
+    for(size_t i = 0; i < columnCount; ++i)
+    {
+        const auto entry = i*CATALOG_ENTRY_SIZE;
+        const std::string_view name(buffer.data() + entry, strnlen(buffer.data() + entry, CATALOG_NAME_SIZE));
+        const auto field = findCatalogField(name);
+        const auto type = static_cast<CatalogType>(loadLittleEndian<uint32>(buffer, entry + CATALOG_NAME_SIZE));
+        if(field < definitions.size() && type == definitions[field].type)
+        {
+            offsets[field] = loadLittleEndian<uint64>(buffer, entry + CATALOG_NAME_SIZE + 8);
+        }
+    }
+
+    //Paths
+    std::vector<uint64> pathOffsets(rowCount + 1);
+    if(!readValues(is, reinterpret_cast<std::byte*>(pathOffsets.data()), pathOffsets.size(), sizeof(uint64)))
+    {
+        return false;
+    }
+    const auto blobOffset = pathsOffset + pathOffsets.size()*sizeof(uint64);
+    if( pathOffsets.front() != 0 || 
+        pathOffsets.back() > fileSize - blobOffset ||
+        !std::is_sorted(pathOffsets.cbegin(), pathOffsets.cend()) )
+    {
+        return false;
+    }
+    std::string blob(pathOffsets.back(), '\0');
+    is.read(blob.data(), blob.size());
+    if(!is.good())
+    {
+        return false;
+    }
+    catalog.paths.resize(rowCount);
+    for(size_t i = 0; i < rowCount; ++i)
+    {
+        catalog.paths[i] = blob.substr(pathOffsets[i], pathOffsets[i+1] - pathOffsets[i]);
+    }
+
+    //Requested columns
+    catalog.columns.clear();
+    for(const auto& definition : definitions)
+    {
+        catalog.columns.push_back(CatalogColumn{ definition.type, {} });
+    }
+    for(size_t i = 0; i < definitions.size(); ++i)
+    {
+        const bool requested = fields.empty() || std::find(fields.cbegin(), fields.cend(), i) != fields.cend();
+        if(requested)
+        {
+            const auto width = getTypeSize(definitions[i].type);
+            if(offsets[i] == 0 || offsets[i] > fileSize || rowCount * width > fileSize - offsets[i])
+            {
+                return false; //Missing or out of the file
+            }
+
+            auto& values = catalog.columns[i].values;
+            values.resize(rowCount * width);
+            is.seekg(offsets[i]);
+            if(!readValues(is, values.data(), rowCount, width))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+std::vector<size_t> queryCatalog(const Catalog& catalog, const std::vector<CatalogCondition>& conditions)
+{
+    std::vector<uint8> mask(catalog.paths.size(), true);
+    for(const auto& condition : conditions)
+    {
+        const auto& column = catalog.columns[condition.field];
+        if(column.values.size() != mask.size() * getTypeSize(column.type))
+        {
+            return {}; //Column not loaded
+        }
+
+        switch (column.type)
+        {
+        case CatalogType::u32: evaluateCondition<uint32>(column.values, condition, mask); break;
+        case CatalogType::f32: evaluateCondition<float32>(column.values, condition, mask); break;
+        case CatalogType::u64: evaluateCondition<uint64>(column.values, condition, mask); break;
+        case CatalogType::i64: evaluateCondition<int64>(column.values, condition, mask); break;
+        default: break;
+        }
+    }
+
+    std::vector<size_t> result;
+    for(size_t i = 0; i < mask.size(); ++i)
+    {
+        if(mask[i])
+        {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,210 @@
+#include <Checksum.h>
+
+#include <Read.h>
+#include <FileRead.h>
+#include <Hash.h>
+#include <ByteSwap.h>
+#include <Parallel.h>
+#include <Validate.h>
+
+#include <string>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr size_t CHUNKS_PER_SEGMENT = 64;
+
+/** STATIC FUNCTIONS **/
+
+static void normalizeMainHeader(MainHeader& header)
+{
+    //Writers leave garbage in the unused bytes, or swap them as words or not
+    clearUnusedFields(header);
+
+    //Encode the already decoded header as little endian
+    transformMainHeader(header, makeLittleEndian<uint32>, makeLittleEndian<float32>);
+    header.byteOrder = Endianess::le_le_le_le;
+    makeBigEndian(header.byteOrder);
+    makeBigEndian(header.extHeaderType);
+}
+
+static size_t hashData( std::istream& is, 
+                        const MainHeader& header, 
+                        bool normalize, 
+                        size_t threadCount,
+                        uint64& result )
+{
+    const auto dataSize = getDataSize(header);
+    const auto wordSize = getModeWordSize(header.mode);
+    const bool swap = normalize && getModeEndianess(header.byteOrder, header.mode) == Endianess::be;
+
+    //Small data blocks do not need a whole segment
+    std::vector<std::byte> segment(std::min(dataSize, CHUNKS_PER_SEGMENT * CHECKSUM_CHUNK_SIZE));
+    std::vector<uint64> chunkHashes;
+    chunkHashes.reserve((dataSize + CHECKSUM_CHUNK_SIZE - 1) / CHECKSUM_CHUNK_SIZE);
+
+    //Read the data block by segments, hashing each chunk in parallel
+    size_t count = 0;
+    while(count < dataSize)
+    {
+        const auto requested = std::min(segment.size(), dataSize - count);
+        is.read(reinterpret_cast<char*>(segment.data()), requested);
+        const auto received = static_cast<size_t>(is.gcount());
+
+        const auto nChunks = (received + CHECKSUM_CHUNK_SIZE - 1) / CHECKSUM_CHUNK_SIZE;
+        const auto first = chunkHashes.size();
+        chunkHashes.resize(first + nChunks);
+        parallelFor(
+            nChunks, threadCount,
+            [&segment, &chunkHashes, received, first, wordSize, swap] (size_t i)
+            {
+                auto* chunk = segment.data() + i*CHECKSUM_CHUNK_SIZE;
+                const auto size = std::min(CHECKSUM_CHUNK_SIZE, received - i*CHECKSUM_CHUNK_SIZE);
+                if(swap)
+                {
+                    //Byte-order normalization to little endian
+                    swapEndianess(chunk, size / wordSize, wordSize);
+                }
+                chunkHashes[first + i] = hash64(chunk, size);
+            }
+        );
+
+        count += received;
+        if(received != requested)
+        {
+            break; //Truncated
+        }
+    }
+
+    result = combineHash64Tree(std::move(chunkHashes));
+    return count;
+}
+
+/**
+ * @brief As hashData, but the data block is read with the file reader. Read 
+ * chunks are made of whole hashed chunks, which are hashed as they complete
+ * into their slot, so the result is the same as with the stream
+ */
+static size_t hashFileData( const char* path,
+                            const MainHeader& header,
+                            FileReadOptions options,
+                            bool normalize,
+                            uint64& result )
+{
+    const auto dataSize = getDataSize(header);
+    const auto wordSize = getModeWordSize(header.mode);
+    const bool swap = normalize && getModeEndianess(header.byteOrder, header.mode) == Endianess::be;
+
+    std::vector<uint64> chunkHashes((dataSize + CHECKSUM_CHUNK_SIZE - 1) / CHECKSUM_CHUNK_SIZE);
+    options.chunkSize = std::max(options.chunkSize / CHECKSUM_CHUNK_SIZE, size_t(1)) * CHECKSUM_CHUNK_SIZE;
+    const auto count = readDataChunks(
+        path, header, options,
+        [&chunkHashes, wordSize, swap] (std::byte* data, size_t offset, size_t size)
+        {
+            for(size_t begin = 0; begin < size; begin += CHECKSUM_CHUNK_SIZE)
+            {
+                auto* chunk = data + begin;
+                const auto chunkSize = std::min(CHECKSUM_CHUNK_SIZE, size - begin);
+                if(swap)
+                {
+                    //Byte-order normalization to little endian
+                    swapEndianess(chunk, chunkSize / wordSize, wordSize);
+                }
+                chunkHashes[(offset + begin) / CHECKSUM_CHUNK_SIZE] = hash64(chunk, chunkSize);
+            }
+        }
+    );
+
+    chunkHashes.resize((count + CHECKSUM_CHUNK_SIZE - 1) / CHECKSUM_CHUNK_SIZE);
+    result = combineHash64Tree(std::move(chunkHashes));
+    return count;
+}
+
+/**
+ * @brief Hashes the main and extended headers read from the stream. Returns 
+ * their size, 0 if the header could not be read or is corrupt
+ */
+static size_t hashHeaders(std::istream& is, MainHeader& header, Checksum& checksum, bool normalize)
+{
+    //Read the raw header
+    is.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if(!is.good())
+    {
+        return 0;
+    }
+    const auto rawHeader = header;
+    if(!decodeMainHeader(header))
+    {
+        return 0;
+    }
+
+    //Rejected before the lengths in the header drive any read
+    if(validateHeader(header, getValidationContext(is)) == Validity::corrupt)
+    {
+        return 0;
+    }
+
+    //Hash the header, either as stored or as little endian
+    auto hashedHeader = rawHeader;
+    if(normalize)
+    {
+        hashedHeader = header;
+        normalizeMainHeader(hashedHeader);
+    }
+    checksum.header = hash64(reinterpret_cast<const std::byte*>(&hashedHeader), sizeof(hashedHeader));
+
+    //Hash the extended header. Its layout is not known, so it is always hashed as is
+    std::string extHeader;
+    const auto extHeaderSize = readExtendedHeader(is, header, extHeader);
+    checksum.extHeader = hash64(reinterpret_cast<const std::byte*>(extHeader.data()), extHeaderSize);
+    return sizeof(MainHeader) + extHeaderSize;
+}
+
+static size_t completeChecksum(const MainHeader& header, size_t headersSize, Checksum& checksum)
+{
+    const auto extHeaderSize = headersSize - sizeof(MainHeader);
+    checksum.complete = getModeSize(header.mode) != 0 && extHeaderSize == header.extHeaderLen && checksum.dataSize == getDataSize(header);
+    checksum.total = combineHash64Tree({checksum.header, checksum.extHeader, checksum.data});
+    return headersSize + checksum.dataSize;
+}
+
+/** PUBLIC FUNCTIONS **/
+
+size_t computeChecksum(std::istream& is, Checksum& checksum, bool normalize, size_t threadCount)
+{
+    MainHeader header;
+    const auto headersSize = hashHeaders(is, header, checksum, normalize);
+    if(headersSize == 0)
+    {
+        return 0;
+    }
+
+    checksum.dataSize = hashData(is, header, normalize, threadCount, checksum.data);
+    return completeChecksum(header, headersSize, checksum);
+}
+
+size_t computeChecksum(std::istream& is, const char* path, const FileReadOptions& options, Checksum& checksum, bool normalize)
+{
+    MainHeader header;
+    const auto headersSize = hashHeaders(is, header, checksum, normalize);
+    if(headersSize == 0)
+    {
+        return 0;
+    }
+
+    //Packed modes can not be read in chunks of the file
+    if(isPackedMode(header.mode))
+    {
+        checksum.dataSize = hashData(is, header, normalize, options.threadCount, checksum.data);
+    }
+    else
+    {
+        checksum.dataSize = hashFileData(path, header, options, normalize, checksum.data);
+    }
+    return completeChecksum(header, headersSize, checksum);
+}
+
+}
@@ -0,0 +1,273 @@
+#include <Convert.h>
+
+#include <Read.h>
+#include <Write.h>
+#include <Parallel.h>
+#include <ByteSwap.h>
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr size_t BATCH_SIZE = 16 << 20;
+static constexpr size_t BAND_SIZE = 1 << 14;
+static constexpr std::string_view CONVERSION_LABEL = "mrcinspector: converted mode";
+static constexpr float64 FLOAT16_MAX = 65504.0;
+
+/** STATIC FUNCTIONS **/
+
+template<Rounding R>
+static float64 round(float64 x)
+{
+    if constexpr (R == Rounding::nearest)
+    {
+        return std::round(x);
+    }
+    else if constexpr (R == Rounding::floor)
+    {
+        return std::floor(x);
+    }
+    else if constexpr (R == Rounding::ceil)
+    {
+        return std::ceil(x);
+    }
+    else
+    {
+        return std::trunc(x);
+    }
+}
+
+template<typename S, Rounding R>
+static S convertScalar(float64 x, const ConversionOptions& options)
+{
+    x = x*options.scale + options.offset;
+    if(options.clamp)
+    {
+        x = std::min(std::max(x, options.clampMin), options.clampMax);
+    }
+
+    if constexpr (std::is_integral<S>::value)
+    {
+        //Saturate, as out of range conversions are not defined. NaN becomes 0
+        constexpr auto lowest = static_cast<float64>(std::numeric_limits<S>::lowest());
+        constexpr auto highest = static_cast<float64>(std::numeric_limits<S>::max());
+        x = (x == x) ? round<R>(x) : 0.0;
+        x = std::min(std::max(x, lowest), highest);
+    }
+    else if constexpr (std::is_same<S, float16>::value)
+    {
+        //Saturate instead of overflowing to infinity. NaN is kept
+        x = std::min(std::max(x, -FLOAT16_MAX), FLOAT16_MAX);
+    }
+
+    return static_cast<S>(x);
+}
+
+template<typename T, typename Q, Rounding R>
+static void convertBand(const T* src, Q* dst, size_t count, const ConversionOptions& options)
+{
+    using S = typename ScalarType<Q>::type;
+    if constexpr (isComplex<T> && isComplex<Q>)
+    {
+        //Component-wise
+        for(size_t i = 0; i < count; ++i)
+        {
+            dst[i] = Q(
+                convertScalar<S, R>(static_cast<float64>(src[i].real()), options),
+                convertScalar<S, R>(static_cast<float64>(src[i].imag()), options)
+            );
+        }
+    }
+    else if constexpr (isComplex<Q>)
+    {
+        //Null imaginary part
+        for(size_t i = 0; i < count; ++i)
+        {
+            dst[i] = Q(convertScalar<S, R>(toFloat64(src[i]), options), S(0));
+        }
+    }
+    else
+    {
+        //Complex sources are converted by their modulus
+        for(size_t i = 0; i < count; ++i)
+        {
+            dst[i] = convertScalar<S, R>(toFloat64(src[i]), options);
+        }
+    }
+}
+
+template<typename T, typename Q>
+static void convertBand(const T* src, Q* dst, size_t count, const ConversionOptions& options)
+{
+    //Hoist the rounding mode out of the inner loop
+    switch (options.rounding)
+    {
+    case Rounding::nearest: convertBand<T, Q, Rounding::nearest>(src, dst, count, options); break;
+    case Rounding::floor:   convertBand<T, Q, Rounding::floor>(src, dst, count, options); break;
+    case Rounding::ceil:    convertBand<T, Q, Rounding::ceil>(src, dst, count, options); break;
+    case Rounding::truncate:convertBand<T, Q, Rounding::truncate>(src, dst, count, options); break;
+    }
+}
+
+template<typename T, typename Q>
+static void convertBatch(   const std::vector<T>& src, 
+                            std::vector<Q>& dst, 
+                            const ConversionOptions& options,
+                            Statistics& statistics )
+{
+    dst.resize(src.size());
+
+    //Convert bands in parallel, accumulating the statistics of each 
+    //band right after converting it, while it is still in cache
+    std::vector<Statistics> bands((src.size() + BAND_SIZE - 1) / BAND_SIZE, makeStatistics());
+    parallelFor(
+        bands.size(), options.threadCount,
+        [&src, &dst, &bands, &options] (size_t i)
+        {
+            const auto begin = i * BAND_SIZE;
+            const auto count = std::min(begin + BAND_SIZE, src.size()) - begin;
+            convertBand(src.data() + begin, dst.data() + begin, count, options);
+            accumulateStatistics(bands[i], dst.data() + begin, count);
+        }
+    );
+
+    for(const auto& band : bands)
+    {
+        mergeStatistics(statistics, band);
+    }
+}
+
+template<typename T>
+static std::pair<float64, float64> getRange()
+{
+    using S = typename ScalarType<T>::type;
+    return {
+        static_cast<float64>(std::numeric_limits<S>::lowest()), 
+        static_cast<float64>(std::numeric_limits<S>::max())
+    };
+}
+
+static bool emplaceTargetBlock(DataBlock& data, const MainHeader& header, const ConversionOptions& options)
+{
+    //IMOD's unsigned bytes stay unsigned when converted to mode 0
+    if(options.mode == Mode::sint8 && hasUnsignedBytes(header))
+    {
+        data.emplace<std::vector<uint8>>();
+        return true;
+    }
+    return emplaceDataBlock(data, options.mode);
+}
+
+/** PUBLIC FUNCTIONS **/
+
+bool fitConversionRange(const MainHeader& header, ConversionOptions& options)
+{
+    DataBlock target;
+    if(!emplaceTargetBlock(target, header, options))
+    {
+        return false;
+    }
+
+    return std::visit(
+        [&header, &options] (const auto& values)
+        {
+            using S = typename ScalarType<typename std::decay<decltype(values)>::type::value_type>::type;
+            if constexpr (std::is_integral<S>::value)
+            {
+                const auto [lowest, highest] = getRange<S>();
+                const float64 min = header.min;
+                const float64 max = header.max;
+                if(!std::isfinite(min) || !std::isfinite(max) || !(max > min))
+                {
+                    return false;
+                }
+                options.scale = (highest - lowest) / (max - min);
+                options.offset = lowest - min*options.scale;
+            }
+            return true;
+        },
+        target
+    );
+}
+
+MainHeader makeConvertedHeader(const MainHeader& header, const ConversionOptions& options)
+{
+    auto result = header;
+    result.mode = options.mode;
+    if(options.mode == Mode::sint8 && result.imodStamp == IMOD_STAMP && !hasUnsignedBytes(header))
+    {
+        result.imodFlags |= IMOD_FLAG_SIGNED_BYTES; //Otherwise IMOD reads them as unsigned
+    }
+    clearUnusedFields(result);
+    appendLabel(result, CONVERSION_LABEL);
+    return result;
+}
+
+std::string makeConvertedExtendedHeader(const MainHeader& header, const std::string& extHeader)
+{
+    auto result = extHeader;
+    if(header.extHeaderType == ExtendedHeaderType::agar && needsSwap(getIntEndianess(header.byteOrder)))
+    {
+        swapEndianess(reinterpret_cast<std::byte*>(result.data()), result.size() / sizeof(uint32), sizeof(uint32));
+    }
+    return result;
+}
+
+size_t convertData( std::istream& is, 
+                    const MainHeader& header, 
+                    std::ostream& os, 
+                    const ConversionOptions& options,
+                    Statistics& statistics )
+{
+    DataBlock src;
+    DataBlock dst;
+    if(!emplaceTargetBlock(dst, header, options))
+    {
+        return 0;
+    }
+
+    const auto sectionSize = std::max(getSectionSize(header), getSectionElementCount(header) * getModeSize(options.mode));
+    if(sectionSize == 0)
+    {
+        return 0;
+    }
+    const auto batchSections = std::max(BATCH_SIZE / sectionSize, size_t(1));
+
+    //Stream the sections through the conversion
+    size_t result = 0;
+    const size_t nSections = header.dimensions[2];
+    for(size_t section = 0; section < nSections; section += batchSections)
+    {
+        const auto count = std::min(batchSections, nSections - section);
+        if(readSections(is, header, count, src) != count*getSectionSize(header))
+        {
+            break; //Truncated
+        }
+
+        std::visit(
+            [&options, &statistics] (const auto& srcValues, auto& dstValues)
+            {
+                convertBatch(srcValues, dstValues, options, statistics);
+            },
+            src, dst
+        );
+
+        const auto written = writeData(os, dst);
+        if(written == 0)
+        {
+            break;
+        }
+        result += written;
+    }
+
+    return result;
+}
+
+}
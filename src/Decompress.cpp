@@ -0,0 +1,801 @@
+#include <Decompress.h>
+
+#include <Read.h>
+#include <DataTypes.h>
+#include <Parallel.h>
+#include <Seekable.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#if defined(MRCINSPECTOR_WITH_ZLIB)
+    #include <zlib.h>
+#endif
+
+#if defined(MRCINSPECTOR_WITH_BZIP2)
+    #include <bzlib.h>
+#endif
+
+#if defined(MRCINSPECTOR_WITH_ZSTD)
+    #include <zstd.h>
+#endif
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr size_t INPUT_BUFFER_SIZE = 1 << 16;
+static constexpr size_t OUTPUT_BUFFER_SIZE = 1 << 20;
+static constexpr size_t FRAMES_PER_THREAD = 4;
+static constexpr size_t MAX_FRAME_SIZE = 1 << 24;
+static constexpr size_t MAX_BATCH_SIZE = 1 << 26;
+static constexpr size_t MAX_BGZF_BLOCK_SIZE = 1 << 16; ///< BGZF blocks never inflate beyond 64 KiB
+
+/** STATIC FUNCTIONS **/
+
+static uint32 readLittleEndian(const char* data, size_t size)
+{
+    uint32 result = 0;
+    for(size_t i = 0; i < size; ++i)
+    {
+        result |= static_cast<uint32>(static_cast<uint8>(data[i])) << (8*i);
+    }
+    return result;
+}
+
+/**
+ * @brief Appends count bytes read from the stream to the buffer
+ */
+static bool readAppend(std::istream& is, std::vector<char>& buffer, size_t count)
+{
+    const auto size = buffer.size();
+    buffer.resize(size + count);
+    is.read(buffer.data() + size, count);
+    return static_cast<size_t>(is.gcount()) == count;
+}
+
+/** DECODERS **/
+
+class Decoder
+{
+public:
+    virtual ~Decoder() = default;
+
+    /**
+     * @brief Decodes the next block, of about maxSize bytes at most. The
+     * returned data remains valid until the next call. Its size is 0 at the
+     * end or on error
+     */
+    virtual std::pair<char*, size_t> decode(size_t maxSize) = 0;
+};
+
+/**
+ * @brief Decoder for formats composed of independently decodable frames of
+ * bounded size. Frames are read sequentially and decoded in parallel by 
+ * batches. Batches start with a single frame and grow up to MAX_BATCH_SIZE
+ * decompressed bytes, so that short reads (e.g. the header) do not decode
+ * more than a frame
+ */
+class FrameDecoder : public Decoder
+{
+public:
+    explicit FrameDecoder(size_t threadCount)
+        : m_threadCount(threadCount)
+    {
+    }
+
+    std::pair<char*, size_t> decode(size_t) override
+    {
+        while(true)
+        {
+            if(m_next < m_outputs.size())
+            {
+                auto& output = m_outputs[m_next++];
+                if(!output.empty())
+                {
+                    return { output.data(), output.size() };
+                }
+            }
+            else if(!decodeBatch())
+            {
+                return { nullptr, 0 };
+            }
+        }
+    }
+
+protected:
+    /**
+     * @brief Reads the next frame from the source and gives the size it
+     * decompresses to. False at the end or on error
+     */
+    virtual bool readFrame(std::vector<char>& frame, size_t& contentSize) = 0;
+
+    /**
+     * @brief Decodes a frame. Called concurrently
+     */
+    virtual bool decodeFrame(const std::vector<char>& frame, std::vector<char>& output) const = 0;
+
+private:
+    size_t                          m_threadCount;
+    size_t                          m_batchSize = 1;
+    size_t                          m_next = 0;
+    bool                            m_end = false;
+    std::vector<std::vector<char>>  m_frames;
+    std::vector<std::vector<char>>  m_outputs;
+
+    bool decodeBatch()
+    {
+        //Read the frames of the batch
+        size_t count = 0;
+        size_t batchSize = 0;
+        m_frames.resize(m_batchSize);
+        while(count < m_batchSize && batchSize < MAX_BATCH_SIZE && !m_end)
+        {
+            m_frames[count].clear();
+            size_t contentSize = 0;
+            if(readFrame(m_frames[count], contentSize))
+            {
+                ++count;
+                batchSize += contentSize;
+            }
+            else
+            {
+                m_end = true;
+            }
+        }
+
+        //Decode them in parallel
+        std::vector<uint8> decoded(count, false);
+        m_outputs.resize(count);
+        parallelFor(
+            count, m_threadCount,
+            [this, &decoded] (size_t i)
+            {
+                decoded[i] = decodeFrame(m_frames[i], m_outputs[i]);
+            }
+        );
+
+        //Stop at the first frame that could not be decoded
+        const auto firstFailed = std::find(decoded.cbegin(), decoded.cend(), false) - decoded.cbegin();
+        if(static_cast<size_t>(firstFailed) < count)
+        {
+            m_outputs.resize(firstFailed);
+            m_end = true;
+        }
+
+        m_next = 0;
+        m_batchSize = std::min(m_batchSize * 2, std::max(m_threadCount, size_t(1)) * FRAMES_PER_THREAD);
+        return !m_outputs.empty() || !m_end;
+    }
+};
+
+#if defined(MRCINSPECTOR_WITH_ZLIB)
+
+/**
+ * @brief Sequential gzip decoder. Handles concatenated members
+ */
+class GzipDecoder : public Decoder
+{
+public:
+    explicit GzipDecoder(std::istream& source)
+        : m_source(source)
+        , m_input(INPUT_BUFFER_SIZE)
+        , m_output(OUTPUT_BUFFER_SIZE)
+    {
+        m_valid = inflateInit2(&m_stream, 16 + MAX_WBITS) == Z_OK;
+    }
+
+    ~GzipDecoder()
+    {
+        inflateEnd(&m_stream);
+    }
+
+    std::pair<char*, size_t> decode(size_t maxSize) override
+    {
+        const auto size = std::min(maxSize, m_output.size());
+        m_stream.next_out = reinterpret_cast<Bytef*>(m_output.data());
+        m_stream.avail_out = static_cast<uInt>(size);
+        while(m_valid && m_stream.avail_out > 0)
+        {
+            if(m_stream.avail_in == 0)
+            {
+                m_source.read(m_input.data(), m_input.size());
+                m_stream.next_in = reinterpret_cast<Bytef*>(m_input.data());
+                m_stream.avail_in = static_cast<uInt>(m_source.gcount());
+                if(m_stream.avail_in == 0)
+                {
+                    break; //EOF
+                }
+            }
+
+            const auto ret = inflate(&m_stream, Z_NO_FLUSH);
+            if(ret == Z_STREAM_END)
+            {
+                inflateReset(&m_stream); //Next member
+            }
+            else if(ret != Z_OK)
+            {
+                m_valid = false;
+            }
+        }
+
+        return { m_output.data(), size - m_stream.avail_out };
+    }
+
+private:
+    std::istream&                   m_source;
+    std::vector<char>               m_input;
+    std::vector<char>               m_output;
+    z_stream                        m_stream = {};
+    bool                            m_valid;
+};
+
+/**
+ * @brief Parallel decoder for BGZF-style gzip files, whose members carry
+ * their compressed size in a 'BC' extra subfield, so that they can be
+ * split without inflating them
+ */
+class BgzfDecoder : public FrameDecoder
+{
+public:
+    BgzfDecoder(std::istream& source, size_t threadCount)
+        : FrameDecoder(threadCount)
+        , m_source(source)
+    {
+    }
+
+    /**
+     * @brief Returns true if the first member of the stream has the
+     * block size subfield. The position of the stream is restored
+     */
+    static bool check(std::istream& is)
+    {
+        std::array<char, 18> header = {};
+        const auto position = is.tellg();
+        is.read(header.data(), header.size());
+        const auto count = is.gcount();
+        is.clear();
+        is.seekg(position);
+
+        return  count == static_cast<std::streamsize>(header.size()) &&
+                (header[3] & 0x04) && header[12] == 'B' && header[13] == 'C';
+    }
+
+protected:
+    bool readFrame(std::vector<char>& frame, size_t& contentSize) override
+    {
+        //Fixed part of the member header and extra field
+        constexpr size_t FIXED_SIZE = 12;
+        if(!readAppend(m_source, frame, FIXED_SIZE) || !(frame[3] & 0x04))
+        {
+            return false;
+        }
+        const auto extraSize = readLittleEndian(frame.data() + 10, 2);
+        if(!readAppend(m_source, frame, extraSize))
+        {
+            return false;
+        }
+
+        //Look for the block size subfield
+        size_t blockSize = 0;
+        for(size_t i = FIXED_SIZE; i + 4 <= frame.size(); )
+        {
+            const auto subfieldSize = readLittleEndian(frame.data() + i + 2, 2);
+            if(frame[i] == 'B' && frame[i+1] == 'C' && subfieldSize == 2)
+            {
+                blockSize = readLittleEndian(frame.data() + i + 4, 2) + 1;
+            }
+            i += 4 + subfieldSize;
+        }
+
+        if(blockSize <= frame.size() || !readAppend(m_source, frame, blockSize - frame.size()))
+        {
+            return false;
+        }
+
+        //Decompressed size is stored at the end of the member. It is trusted for
+        //sizing the output, so blocks claiming more than BGZF allows are rejected
+        contentSize = readLittleEndian(frame.data() + frame.size() - 4, 4);
+        return contentSize <= MAX_BGZF_BLOCK_SIZE;
+    }
+
+    bool decodeFrame(const std::vector<char>& frame, std::vector<char>& output) const override
+    {
+        //Decompressed size is stored at the end of the member
+        output.resize(readLittleEndian(frame.data() + frame.size() - 4, 4));
+
+        z_stream stream = {};
+        if(inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+        {
+            return false;
+        }
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(frame.data()));
+        stream.avail_in = static_cast<uInt>(frame.size());
+        stream.next_out = reinterpret_cast<Bytef*>(output.data());
+        stream.avail_out = static_cast<uInt>(output.size());
+        const auto ret = inflate(&stream, Z_FINISH);
+        const auto result = (ret == Z_STREAM_END && stream.total_out == output.size());
+        inflateEnd(&stream);
+        return result;
+    }
+
+private:
+    std::istream&                   m_source;
+};
+
+#endif
+
+#if defined(MRCINSPECTOR_WITH_BZIP2)
+
+/**
+ * @brief Sequential bzip2 decoder. Handles concatenated streams (e.g. pbzip2)
+ */
+class Bzip2Decoder : public Decoder
+{
+public:
+    explicit Bzip2Decoder(std::istream& source)
+        : m_source(source)
+        , m_input(INPUT_BUFFER_SIZE)
+        , m_output(OUTPUT_BUFFER_SIZE)
+    {
+        m_valid = BZ2_bzDecompressInit(&m_stream, 0, 0) == BZ_OK;
+    }
+
+    ~Bzip2Decoder()
+    {
+        BZ2_bzDecompressEnd(&m_stream);
+    }
+
+    std::pair<char*, size_t> decode(size_t maxSize) override
+    {
+        const auto size = std::min(maxSize, m_output.size());
+        m_stream.next_out = m_output.data();
+        m_stream.avail_out = static_cast<unsigned>(size);
+        while(m_valid && m_stream.avail_out > 0)
+        {
+            if(m_stream.avail_in == 0)
+            {
+                m_source.read(m_input.data(), m_input.size());
+                m_stream.next_in = m_input.data();
+                m_stream.avail_in = static_cast<unsigned>(m_source.gcount());
+                if(m_stream.avail_in == 0)
+                {
+                    break; //EOF
+                }
+            }
+
+            const auto ret = BZ2_bzDecompress(&m_stream);
+            if(ret == BZ_STREAM_END)
+            {
+                //Next stream. Keep the pending input and output
+                const auto next_in = m_stream.next_in;
+                const auto avail_in = m_stream.avail_in;
+                const auto next_out = m_stream.next_out;
+                const auto avail_out = m_stream.avail_out;
+                BZ2_bzDecompressEnd(&m_stream);
+                m_valid = BZ2_bzDecompressInit(&m_stream, 0, 0) == BZ_OK;
+                m_stream.next_in = next_in;
+                m_stream.avail_in = avail_in;
+                m_stream.next_out = next_out;
+                m_stream.avail_out = avail_out;
+            }
+            else if(ret != BZ_OK)
+            {
+                m_valid = false;
+            }
+        }
+
+        return { m_output.data(), size - m_stream.avail_out };
+    }
+
+private:
+    std::istream&                   m_source;
+    std::vector<char>               m_input;
+    std::vector<char>               m_output;
+    bz_stream                       m_stream = {};
+    bool                            m_valid;
+};
+
+#endif
+
+#if defined(MRCINSPECTOR_WITH_ZSTD)
+
+/**
+ * @brief Sequential zstd decoder. Compressed input is read in fixed-size
+ * chunks and decompressed into a bounded window, so that it stops as soon
+ * as enough has been read. Handles concatenated and skippable frames.
+ * Starts with the given bytes, already taken from the source
+ */
+class ZstdStreamDecoder : public Decoder
+{
+public:
+    ZstdStreamDecoder(std::istream& source, std::vector<char> prefix)
+        : m_source(source)
+        , m_input(std::move(prefix))
+        , m_output(OUTPUT_BUFFER_SIZE)
+        , m_stream(ZSTD_createDStream())
+    {
+        m_inBuffer = { m_input.data(), m_input.size(), 0 };
+        m_valid = m_stream && !ZSTD_isError(ZSTD_initDStream(m_stream));
+    }
+
+    ~ZstdStreamDecoder()
+    {
+        ZSTD_freeDStream(m_stream);
+    }
+
+    std::pair<char*, size_t> decode(size_t maxSize) override
+    {
+        ZSTD_outBuffer output = { m_output.data(), std::min(maxSize, m_output.size()), 0 };
+        while(m_valid && output.pos < output.size)
+        {
+            if(m_inBuffer.pos == m_inBuffer.size)
+            {
+                m_input.resize(INPUT_BUFFER_SIZE);
+                m_source.read(m_input.data(), m_input.size());
+                m_inBuffer = { m_input.data(), static_cast<size_t>(m_source.gcount()), 0 };
+                if(m_inBuffer.size == 0)
+                {
+                    break; //EOF
+                }
+            }
+
+            if(ZSTD_isError(ZSTD_decompressStream(m_stream, &output, &m_inBuffer)))
+            {
+                m_valid = false;
+            }
+        }
+
+        return { m_output.data(), output.pos };
+    }
+
+private:
+    std::istream&                   m_source;
+    std::vector<char>               m_input;
+    std::vector<char>               m_output;
+    ZSTD_DStream*                   m_stream;
+    ZSTD_inBuffer                   m_inBuffer;
+    bool                            m_valid;
+};
+
+/**
+ * @brief Parallel zstd decoder for inputs made of many frames, such as those
+ * of pzstd. Frames are delimited by parsing their headers and block headers,
+ * without decompressing them. It stops at the first frame whose size is not
+ * given or larger than MAX_FRAME_SIZE, leaving its header to be taken by a 
+ * ZstdStreamDecoder
+ */
+class ZstdFrameDecoder : public FrameDecoder
+{
+public:
+    ZstdFrameDecoder(std::istream& source, size_t threadCount)
+        : FrameDecoder(threadCount)
+        , m_source(source)
+    {
+    }
+
+    /**
+     * @brief Moves the bytes read from the frame it stopped at, if any
+     */
+    bool takeUnboundedFrame(std::vector<char>& prefix)
+    {
+        if(!m_unbounded)
+        {
+            return false;
+        }
+        m_unbounded = false;
+        prefix = std::move(m_prefix);
+        return true;
+    }
+
+protected:
+    bool readFrame(std::vector<char>& frame, size_t& contentSize) override
+    {
+        constexpr uint32 FRAME_MAGIC = 0xFD2FB528;
+        constexpr uint32 SKIPPABLE_MAGIC = 0x184D2A50;
+        constexpr uint32 SKIPPABLE_MASK = 0xFFFFFFF0;
+
+        //Ignore skippable frames
+        uint32 magic;
+        while(true)
+        {
+            frame.clear();
+            if(!readAppend(m_source, frame, 4))
+            {
+                return false;
+            }
+            magic = readLittleEndian(frame.data(), 4);
+            if((magic & SKIPPABLE_MASK) != SKIPPABLE_MAGIC)
+            {
+                break;
+            }
+            if(!readAppend(m_source, frame, 4))
+            {
+                return false;
+            }
+            m_source.ignore(readLittleEndian(frame.data() + 4, 4));
+        }
+        if(magic != FRAME_MAGIC || !readAppend(m_source, frame, 1))
+        {
+            return false;
+        }
+
+        //Frame header
+        const auto descriptor = static_cast<uint8>(frame.back());
+        const auto contentSizeFlag = descriptor >> 6;
+        const bool singleSegment = (descriptor >> 5) & 1;
+        const bool checksum = (descriptor >> 2) & 1;
+        const auto dictionaryIdFlag = descriptor & 3;
+        constexpr std::array<size_t, 4> DICTIONARY_ID_SIZES = { 0, 1, 2, 4 };
+        constexpr std::array<size_t, 4> CONTENT_SIZE_SIZES = { 0, 2, 4, 8 };
+        const size_t headerSize =
+            (singleSegment ? 0 : 1) +
+            DICTIONARY_ID_SIZES[dictionaryIdFlag] +
+            ((contentSizeFlag == 0 && singleSegment) ? 1 : CONTENT_SIZE_SIZES[contentSizeFlag]);
+        if(!readAppend(m_source, frame, headerSize))
+        {
+            return false;
+        }
+
+        //Large frames (e.g. the single one of the zstd CLI) are streamed instead
+        const auto frameContentSize = ZSTD_getFrameContentSize(frame.data(), frame.size());
+        if(frameContentSize == ZSTD_CONTENTSIZE_ERROR)
+        {
+            return false;
+        }
+        else if(frameContentSize == ZSTD_CONTENTSIZE_UNKNOWN || frameContentSize > MAX_FRAME_SIZE)
+        {
+            m_unbounded = true;
+            m_prefix = frame;
+            return false;
+        }
+        contentSize = frameContentSize;
+
+        //Blocks
+        const auto maxCompressedSize = ZSTD_compressBound(MAX_FRAME_SIZE) + frame.size();
+        bool last = false;
+        while(!last)
+        {
+            if(!readAppend(m_source, frame, 3))
+            {
+                return false;
+            }
+            const auto blockHeader = readLittleEndian(frame.data() + frame.size() - 3, 3);
+            last = blockHeader & 1;
+            const auto type = (blockHeader >> 1) & 3;
+            const auto size = blockHeader >> 3;
+            if(type == 3 || frame.size() + size > maxCompressedSize || !readAppend(m_source, frame, type == 1 ? 1 : size))
+            {
+                return false; //Reserved type, too large or truncated
+            }
+        }
+
+        return !checksum || readAppend(m_source, frame, 4);
+    }
+
+    bool decodeFrame(const std::vector<char>& frame, std::vector<char>& output) const override
+    {
+        //Size already checked by readFrame
+        const auto contentSize = ZSTD_getFrameContentSize(frame.data(), frame.size());
+        output.resize(contentSize);
+        const auto ret = ZSTD_decompress(output.data(), output.size(), frame.data(), frame.size());
+        return !ZSTD_isError(ret) && ret == contentSize;
+    }
+
+private:
+    std::istream&                   m_source;
+    std::vector<char>               m_prefix;
+    bool                            m_unbounded = false;
+};
+
+/**
+ * @brief zstd decoder. Frames of bounded size are decoded in parallel. From
+ * the first one that is not bounded, the rest is decoded as a stream
+ */
+class ZstdDecoder : public Decoder
+{
+public:
+    ZstdDecoder(std::istream& source, size_t threadCount)
+        : m_source(source)
+        , m_frames(source, threadCount)
+    {
+    }
+
+    std::pair<char*, size_t> decode(size_t maxSize) override
+    {
+        if(!m_stream)
+        {
+            const auto result = m_frames.decode(maxSize);
+            std::vector<char> prefix;
+            if(result.second > 0 || !m_frames.takeUnboundedFrame(prefix))
+            {
+                return result;
+            }
+            m_stream = std::make_unique<ZstdStreamDecoder>(m_source, std::move(prefix));
+        }
+
+        return m_stream->decode(maxSize);
+    }
+
+private:
+    std::istream&                       m_source;
+    ZstdFrameDecoder                    m_frames;
+    std::unique_ptr<ZstdStreamDecoder>  m_stream;
+};
+
+#endif
+
+/** STREAMS **/
+
+class DecompressStreambuf : public std::streambuf
+{
+public:
+    explicit DecompressStreambuf(std::unique_ptr<Decoder> decoder)
+        : m_decoder(std::move(decoder))
+    {
+    }
+
+protected:
+    int_type underflow() override
+    {
+        if(gptr() == egptr() && !refill(OUTPUT_BUFFER_SIZE))
+        {
+            return traits_type::eof();
+        }
+
+        return traits_type::to_int_type(*gptr());
+    }
+
+    /**
+     * @brief Reads are forwarded with their size, so that sequential decoders
+     * do not decompress more than asked for (e.g. only the header)
+     */
+    std::streamsize xsgetn(char* s, std::streamsize count) override
+    {
+        std::streamsize result = 0;
+        while(result < count)
+        {
+            if(gptr() == egptr() && !refill(static_cast<size_t>(count - result)))
+            {
+                break;
+            }
+            const auto available = std::min<std::streamsize>(egptr() - gptr(), count - result);
+            std::memcpy(s + result, gptr(), available);
+            setg(eback(), gptr() + available, egptr());
+            result += available;
+        }
+        return result;
+    }
+
+private:
+    std::unique_ptr<Decoder>        m_decoder;
+
+    bool refill(size_t maxSize)
+    {
+        const auto [data, size] = m_decoder->decode(maxSize);
+        if(size == 0)
+        {
+            return false;
+        }
+        setg(data, data, data + size);
+        return true;
+    }
+};
+
+/**
+ * @brief Input file stream that owns the file and the decompressor
+ */
+class InputFileStream : public std::istream
+{
+public:
+    InputFileStream(const char* path, size_t threadCount, Compression& compression)
+        : std::istream(nullptr)
+        , m_file(path, std::ios_base::in | std::ios_base::binary)
+    {
+        compression = m_file ? detectCompression(m_file) : Compression::none;
+        if(compression != Compression::none)
+        {
+            m_decompressor = makeDecompressStreambuf(m_file, compression, threadCount);
+        }
+        if(compression == Compression::none)
+        {
+            rdbuf(m_file.rdbuf());
+        }
+        else if(m_decompressor)
+        {
+            rdbuf(m_decompressor.get());
+        }
+        if(!m_file)
+        {
+            setstate(std::ios_base::failbit);
+        }
+    }
+
+private:
+    std::ifstream                   m_file;
+    std::unique_ptr<std::streambuf> m_decompressor;
+};
+
+/** PUBLIC FUNCTIONS **/
+
+bool isCompressionSupported(Compression compression)
+{
+    switch (compression)
+    {
+    case Compression::none:
+    case Compression::seekable:
+        return true;
+    #if defined(MRCINSPECTOR_WITH_ZLIB)
+        case Compression::gzip:
+            return true;
+    #endif
+    #if defined(MRCINSPECTOR_WITH_BZIP2)
+        case Compression::bzip2:
+            return true;
+    #endif
+    #if defined(MRCINSPECTOR_WITH_ZSTD)
+        case Compression::zstd:
+            return true;
+    #endif
+    default:
+        return false;
+    }
+}
+
+std::unique_ptr<std::streambuf> makeDecompressStreambuf(std::istream& source, Compression compression, size_t threadCount)
+{
+    if(compression == Compression::seekable)
+    {
+        return makeSeekableStreambuf(source, threadCount);
+    }
+
+    std::unique_ptr<Decoder> decoder;
+    switch (compression)
+    {
+    #if defined(MRCINSPECTOR_WITH_ZLIB)
+        case Compression::gzip:
+            if(BgzfDecoder::check(source))
+            {
+                decoder = std::make_unique<BgzfDecoder>(source, threadCount);
+            }
+            else
+            {
+                decoder = std::make_unique<GzipDecoder>(source);
+            }
+            break;
+    #endif
+    #if defined(MRCINSPECTOR_WITH_BZIP2)
+        case Compression::bzip2:
+            decoder = std::make_unique<Bzip2Decoder>(source);
+            break;
+    #endif
+    #if defined(MRCINSPECTOR_WITH_ZSTD)
+        case Compression::zstd:
+            decoder = std::make_unique<ZstdDecoder>(source, threadCount);
+            break;
+    #endif
+    default:
+        break;
+    }
+
+    (void)source;
+    (void)threadCount;
+    return decoder ? std::make_unique<DecompressStreambuf>(std::move(decoder)) : nullptr;
+}
+
+std::unique_ptr<std::istream> openInputFile(const char* path, size_t threadCount, Compression& compression)
+{
+    auto result = std::make_unique<InputFileStream>(path, threadCount, compression);
+    if(!isCompressionSupported(compression) || !result->rdbuf())
+    {
+        result.reset();
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,321 @@
+#include <Diff.h>
+
+#include <Read.h>
+#include <Numeric.h>
+#include <Parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr size_t BATCH_SIZE = 16 << 20;
+static constexpr size_t BAND_SIZE = 1 << 16;
+
+/** STATIC FUNCTIONS **/
+
+template<typename T>
+static std::string toFieldString(const T& value)
+{
+    std::ostringstream oss;
+    if constexpr (std::is_enum<T>::value)
+    {
+        oss << static_cast<int>(value) << " (" << toString(value) << ")";
+    }
+    else
+    {
+        oss << value;
+    }
+    return oss.str();
+}
+
+template<size_t N>
+static std::string toFieldString(const std::array<char, N>& value)
+{
+    return std::string(value.data(), value.size());
+}
+
+template<typename T>
+static void diffField(  std::vector<HeaderDifference>& differences, 
+                        std::string name, 
+                        const T& lhs, 
+                        const T& rhs )
+{
+    if(lhs != rhs)
+    {
+        differences.push_back(HeaderDifference{
+            std::move(name), 
+            toFieldString(lhs), 
+            toFieldString(rhs)
+        });
+    }
+}
+
+struct BandDifference
+{
+    float64                     sumSquares = 0;
+    float64                     maxError = 0;
+    size_t                      mismatchCount = 0;
+    std::vector<Mismatch>       mismatches;
+};
+
+static bool isNanValue(float64 x)
+{
+    return std::isnan(x);
+}
+
+static bool isNanValue(const cfloat128& x)
+{
+    return std::isnan(x.real()) || std::isnan(x.imag());
+}
+
+/**
+ * @brief Maximum that keeps a NaN, so that it shows in the report
+ */
+static float64 maxKeepNan(float64 lhs, float64 rhs)
+{
+    return (std::isnan(lhs) || lhs >= rhs) ? lhs : rhs;
+}
+
+/**
+ * @brief Returns abs + rel*|b|. The relative term is left out for a non-finite
+ * b, so that nothing but an equal value (error 0) is within it
+ */
+static float64 getBound(float64 magnitude, const DiffOptions& options)
+{
+    return options.absTolerance + (std::isfinite(magnitude) ? options.relTolerance*magnitude : 0.0);
+}
+
+/**
+ * @brief Returns the absolute error, NaN if either value is NaN. Equal values
+ * have no error, including equal infinities, and so do two NaNs if equalNan
+ */
+template<typename T, typename Q>
+static float64 getError(const T& lhs, const Q& rhs, float64& bound, const DiffOptions& options)
+{
+    if constexpr (isComplex<T> || isComplex<Q>)
+    {
+        const auto a = toComplex128(lhs);
+        const auto b = toComplex128(rhs);
+        bound = getBound(std::abs(b), options);
+        const bool equal = a == b || (options.equalNan && isNanValue(a) && isNanValue(b));
+        return equal ? 0.0 : std::abs(a - b);
+    }
+    else
+    {
+        const auto a = static_cast<float64>(lhs);
+        const auto b = static_cast<float64>(rhs);
+        bound = getBound(std::abs(b), options);
+        const bool equal = a == b || (options.equalNan && isNanValue(a) && isNanValue(b));
+        return equal ? 0.0 : std::abs(a - b);
+    }
+}
+
+template<typename T, typename Q>
+static void diffBand(   const T* lhs, 
+                        const Q* rhs, 
+                        size_t count, 
+                        size_t maxMismatches,
+                        const DiffOptions& options,
+                        BandDifference& result )
+{
+    //Branch-free reduction pass, so that it can be vectorized
+    float64 sumSquares = 0;
+    float64 maxError = 0;
+    size_t mismatchCount = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+        float64 bound;
+        const auto error = getError(lhs[i], rhs[i], bound, options);
+        sumSquares += error*error;
+        maxError = maxKeepNan(maxError, error);
+        mismatchCount += !(error <= bound); //NaN errors mismatch
+    }
+
+    result.sumSquares = sumSquares;
+    result.maxError = maxError;
+    result.mismatchCount = mismatchCount;
+
+    //Only look for the positions when there are mismatches. The position 
+    //holds the index inside the band. It is fixed up when merging
+    for(size_t i = 0; i < count && result.mismatches.size() < std::min(mismatchCount, maxMismatches); ++i)
+    {
+        float64 bound;
+        const auto error = getError(lhs[i], rhs[i], bound, options);
+        if(!(error <= bound))
+        {
+            result.mismatches.push_back(Mismatch{
+                {i, 0, 0},
+                toComplex128(lhs[i]),
+                toComplex128(rhs[i])
+            });
+        }
+    }
+}
+
+template<typename T, typename Q>
+static void diffBatch(  const std::vector<T>& lhs, 
+                        const std::vector<Q>& rhs, 
+                        size_t firstElement,
+                        const MainHeader& header,
+                        const DiffOptions& options,
+                        float64& sumSquares,
+                        DataDifference& difference )
+{
+    const auto count = std::min(lhs.size(), rhs.size());
+    const auto maxMismatches = options.maxMismatches - std::min(options.maxMismatches, difference.mismatches.size());
+
+    //Compare fixed-size bands in parallel. As the bands do not depend on 
+    //the thread count, neither does the result
+    std::vector<BandDifference> bands((count + BAND_SIZE - 1) / BAND_SIZE);
+    parallelFor(
+        bands.size(), options.threadCount,
+        [&lhs, &rhs, &bands, &options, count, maxMismatches] (size_t i)
+        {
+            const auto begin = i * BAND_SIZE;
+            const auto end = std::min(begin + BAND_SIZE, count);
+            diffBand(lhs.data() + begin, rhs.data() + begin, end - begin, maxMismatches, options, bands[i]);
+        }
+    );
+
+    //Merge the results in band order
+    const size_t nColumns = header.dimensions[0];
+    const size_t nRows = header.dimensions[1];
+    for(size_t i = 0; i < bands.size(); ++i)
+    {
+        const auto& band = bands[i];
+        sumSquares += band.sumSquares;
+        difference.maxError = maxKeepNan(difference.maxError, band.maxError);
+        difference.mismatchCount += band.mismatchCount;
+
+        for(const auto& mismatch : band.mismatches)
+        {
+            if(difference.mismatches.size() >= options.maxMismatches)
+            {
+                break;
+            }
+
+            const auto index = firstElement + i*BAND_SIZE + mismatch.position[0];
+            difference.mismatches.push_back(Mismatch{
+                { index % nColumns, (index / nColumns) % nRows, index / (nColumns*nRows) },
+                mismatch.lhs,
+                mismatch.rhs
+            });
+        }
+    }
+}
+
+/** PUBLIC FUNCTIONS **/
+
+void diffMainHeader(const MainHeader& lhs, const MainHeader& rhs, std::vector<HeaderDifference>& differences)
+{
+    diffField(differences, "Columns", lhs.dimensions[0], rhs.dimensions[0]);
+    diffField(differences, "Rows", lhs.dimensions[1], rhs.dimensions[1]);
+    diffField(differences, "Sections", lhs.dimensions[2], rhs.dimensions[2]);
+    diffField(differences, "Mode", lhs.mode, rhs.mode);
+    diffField(differences, "Column start", lhs.start[0], rhs.start[0]);
+    diffField(differences, "Row start", lhs.start[1], rhs.start[1]);
+    diffField(differences, "Section start", lhs.start[2], rhs.start[2]);
+    diffField(differences, "X sampling", lhs.sampling[0], rhs.sampling[0]);
+    diffField(differences, "Y sampling", lhs.sampling[1], rhs.sampling[1]);
+    diffField(differences, "Z sampling", lhs.sampling[2], rhs.sampling[2]);
+    diffField(differences, "X cell dimension", lhs.cellDimensions[0], rhs.cellDimensions[0]);
+    diffField(differences, "Y cell dimension", lhs.cellDimensions[1], rhs.cellDimensions[1]);
+    diffField(differences, "Z cell dimension", lhs.cellDimensions[2], rhs.cellDimensions[2]);
+    diffField(differences, "Alpha cell angle", lhs.cellAngles[0], rhs.cellAngles[0]);
+    diffField(differences, "Beta cell angle", lhs.cellAngles[1], rhs.cellAngles[1]);
+    diffField(differences, "Gamma cell angle", lhs.cellAngles[2], rhs.cellAngles[2]);
+    diffField(differences, "Column mapping", lhs.axisMapping[0], rhs.axisMapping[0]);
+    diffField(differences, "Row mapping", lhs.axisMapping[1], rhs.axisMapping[1]);
+    diffField(differences, "Section mapping", lhs.axisMapping[2], rhs.axisMapping[2]);
+    diffField(differences, "Min density", lhs.min, rhs.min);
+    diffField(differences, "Max density", lhs.max, rhs.max);
+    diffField(differences, "Avg density", lhs.avg, rhs.avg);
+    diffField(differences, "Space group number", lhs.ispg, rhs.ispg);
+    diffField(differences, "Extended header length", lhs.extHeaderLen, rhs.extHeaderLen);
+    diffField(differences, "Creator ID", lhs.creatorId, rhs.creatorId);
+    diffField(differences, "Extended header type", lhs.extHeaderType, rhs.extHeaderType);
+    diffField(differences, "Version", lhs.version, rhs.version);
+    diffField(differences, "Integers per section", lhs.nInt, rhs.nInt);
+    diffField(differences, "Reals per section", lhs.nReal, rhs.nReal);
+    diffField(differences, "IMOD stamp", lhs.imodStamp, rhs.imodStamp);
+    diffField(differences, "IMOD flags", lhs.imodFlags, rhs.imodFlags);
+    diffField(differences, "Data type", lhs.dataType, rhs.dataType);
+    diffField(differences, "Lens", lhs.lens, rhs.lens);
+    diffField(differences, "Data count #1", lhs.dataCounts[0], rhs.dataCounts[0]);
+    diffField(differences, "Data count #2", lhs.dataCounts[1], rhs.dataCounts[1]);
+    diffField(differences, "Data value #1", lhs.dataValues[0], rhs.dataValues[0]);
+    diffField(differences, "Data value #2", lhs.dataValues[1], rhs.dataValues[1]);
+    diffField(differences, "X original tilt", lhs.originalTilt[0], rhs.originalTilt[0]);
+    diffField(differences, "Y original tilt", lhs.originalTilt[1], rhs.originalTilt[1]);
+    diffField(differences, "Z original tilt", lhs.originalTilt[2], rhs.originalTilt[2]);
+    diffField(differences, "X current tilt", lhs.currentTilt[0], rhs.currentTilt[0]);
+    diffField(differences, "Y current tilt", lhs.currentTilt[1], rhs.currentTilt[1]);
+    diffField(differences, "Z current tilt", lhs.currentTilt[2], rhs.currentTilt[2]);
+    diffField(differences, "X origin", lhs.origin[0], rhs.origin[0]);
+    diffField(differences, "Y origin", lhs.origin[1], rhs.origin[1]);
+    diffField(differences, "Z origin", lhs.origin[2], rhs.origin[2]);
+    diffField(differences, "Map", lhs.map, rhs.map);
+    diffField(differences, "RMS density", lhs.rms, rhs.rms);
+    diffField(differences, "Label count", lhs.nLabels, rhs.nLabels);
+    for (size_t i = 0; i < lhs.labels.size(); ++i)
+    {
+        diffField(differences, "Label #" + std::to_string(i), lhs.labels[i], rhs.labels[i]);
+    }
+}
+
+size_t diffData(std::istream& lhsIs, 
+                const MainHeader& lhsHeader, 
+                std::istream& rhsIs, 
+                const MainHeader& rhsHeader, 
+                const DiffOptions& options, 
+                DataDifference& difference )
+{
+    difference = DataDifference{};
+    if(lhsHeader.dimensions != rhsHeader.dimensions)
+    {
+        return 0;
+    }
+
+    //Decide how many sections are read at once
+    const auto sectionSize = std::max(getSectionSize(lhsHeader), getSectionSize(rhsHeader));
+    if(sectionSize == 0)
+    {
+        return 0;
+    }
+    const auto batchSections = std::max(BATCH_SIZE / sectionSize, size_t(1));
+
+    //Stream both files in lockstep
+    DataBlock lhsData;
+    DataBlock rhsData;
+    float64 sumSquares = 0;
+    const size_t nSections = lhsHeader.dimensions[2];
+    for(size_t section = 0; section < nSections; section += batchSections)
+    {
+        const auto count = std::min(batchSections, nSections - section);
+        const auto lhsSize = readSections(lhsIs, lhsHeader, count, lhsData);
+        const auto rhsSize = readSections(rhsIs, rhsHeader, count, rhsData);
+        if(lhsSize != count*getSectionSize(lhsHeader) || rhsSize != count*getSectionSize(rhsHeader))
+        {
+            break; //Truncated
+        }
+
+        std::visit(
+            [section, &lhsHeader, &options, &sumSquares, &difference] (const auto& lhs, const auto& rhs)
+            {
+                diffBatch(lhs, rhs, section*getSectionElementCount(lhsHeader), lhsHeader, options, sumSquares, difference);
+                difference.count += lhs.size();
+            },
+            lhsData, rhsData
+        );
+    }
+
+    difference.rmsError = difference.count ? std::sqrt(sumSquares / difference.count) : 0.0;
+    return difference.count;
+}
+
+}
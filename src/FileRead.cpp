@@ -0,0 +1,798 @@
+#include <FileRead.h>
+
+#include <Read.h>
+#include <ByteSwap.h>
+#include <AlignedBuffer.h>
+#include <Parallel.h>
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <numeric>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#if __has_include(<linux/io_uring.h>)
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #define MRCINSPECTOR_HAS_URING 1
+#else
+    #define MRCINSPECTOR_HAS_URING 0
+#endif
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr size_t DIRECT_ALIGNMENT = 4096; ///< Assumed when the file system does not report it
+static constexpr size_t BUFFER_ALIGNMENT = 64;
+static constexpr uint64 CANCEL_USER_DATA = ~uint64(0); ///< Tag of the cancel requests, never a chunk
+
+/** STATIC FUNCTIONS **/
+
+/**
+ * @brief Destination of a chunked read and the fix-up applied to each chunk
+ */
+struct ChunkedRead
+{
+    std::byte*                  data;           ///< Destination buffer. Null if chunks are only handed to the callback
+    size_t                      size;           ///< Size of the data block
+    size_t                      offset;         ///< Offset of the data block in the file
+    size_t                      elementSize;    ///< Size of the values, chunks hold whole ones
+    size_t                      wordSize;       ///< Size of the words whose endianess is matched
+    bool                        swap;           ///< Whether words need to be swapped
+    bool                        dropCache;      ///< Whether chunks are dropped from the page cache once read
+    const ChunkCallback*        callback;       ///< Consumer of the completed chunks
+};
+
+/**
+ * @brief A read request. With O_DIRECT, it is widened to the aligned 
+ * range that encloses the chunk
+ */
+struct Chunk
+{
+    size_t                      dataOffset;     ///< Offset of the chunk in the data block
+    size_t                      dataSize;       ///< Size of the chunk
+    size_t                      fileOffset;     ///< Offset of the read in the file
+    size_t                      readSize;       ///< Size of the read
+    size_t                      skip;           ///< Bytes read before the chunk because of the alignment
+    bool                        bounce;         ///< Read into a pool buffer instead of the destination
+};
+
+/**
+ * @brief Alignment required by O_DIRECT transfers. Zero if not supported
+ */
+struct DirectAlignment
+{
+    size_t                      memory;         ///< Alignment of the buffer addresses
+    size_t                      offset;         ///< Alignment of the file offsets and sizes
+};
+
+/**
+ * @brief Aligned buffers for the chunks that can not be read in place,
+ * shared by the reading threads. Sized so that it never runs out
+ */
+class BufferPool
+{
+public:
+    BufferPool(size_t count, size_t size, size_t alignment)
+    {
+        m_buffers.reserve(count);
+        for(size_t i = 0; i < count; ++i)
+        {
+            m_buffers.emplace_back(size, alignment);
+            m_free.push_back(m_buffers.back().data());
+        }
+    }
+
+    bool isValid() const
+    {
+        return std::find(m_free.cbegin(), m_free.cend(), nullptr) == m_free.cend();
+    }
+
+    std::byte* acquire()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto* result = m_free.back();
+        m_free.pop_back();
+        return result;
+    }
+
+    void release(std::byte* buffer)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(buffer);
+    }
+
+private:
+    std::vector<AlignedBuffer>  m_buffers;
+    std::vector<std::byte*>     m_free;
+    std::mutex                  m_mutex;
+};
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static DirectAlignment getDirectAlignment(int fd)
+{
+    #ifdef STATX_DIOALIGN
+        struct statx info = {};
+        if(::statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &info) == 0 && (info.stx_mask & STATX_DIOALIGN))
+        {
+            return { info.stx_dio_mem_align, info.stx_dio_offset_align };
+        }
+    #endif
+
+    return { DIRECT_ALIGNMENT, DIRECT_ALIGNMENT };
+}
+
+/**
+ * @brief Splits the data block in chunks. Chunks are read in place, except when 
+ * there is no destination or, with O_DIRECT, the destination is not aligned. 
+ * The address of the destination is fixed by the allocator, so only when it
+ * is congruent with the data offset are the aligned windows read in place,
+ * with just the unaligned head and tail going through pool buffers
+ */
+static std::vector<Chunk> planChunks(const ChunkedRead& read, size_t chunkSize, const DirectAlignment* direct)
+{
+    std::vector<Chunk> result;
+    const auto addChunks = [&read, &result, direct] (size_t begin, size_t end, size_t step, bool bounce)
+    {
+        for(auto position = begin; position < end; position += step)
+        {
+            Chunk chunk;
+            chunk.dataOffset = position;
+            chunk.dataSize = std::min(step, end - position);
+            chunk.fileOffset = read.offset + position;
+            chunk.skip = direct ? chunk.fileOffset % direct->offset : 0;
+            chunk.fileOffset -= chunk.skip;
+            chunk.readSize = direct ? alignUp(chunk.skip + chunk.dataSize, direct->offset) : chunk.dataSize;
+            chunk.bounce = bounce;
+            result.push_back(chunk);
+        }
+    };
+
+    if(!read.data || !direct)
+    {
+        addChunks(0, read.size, chunkSize, !read.data);
+        return result;
+    }
+
+    const auto head = std::min(alignUp(read.offset, direct->offset) - read.offset, read.size);
+    const auto tail = head + (read.size - head) / direct->offset * direct->offset;
+    const bool inPlace = head % read.elementSize == 0 && reinterpret_cast<uintptr_t>(read.data + head) % direct->memory == 0;
+    if(inPlace)
+    {
+        addChunks(0, head, head, true);
+        addChunks(head, tail, chunkSize, false);
+        addChunks(tail, read.size, read.size - tail, true);
+    }
+    else
+    {
+        addChunks(0, read.size, chunkSize, true);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Reads a chunk into the target, up to the EOF past its end
+ */
+static bool preadChunk(int fd, std::byte* target, const Chunk& chunk)
+{
+    size_t received = 0;
+    while(received < chunk.skip + chunk.dataSize)
+    {
+        const auto count = ::pread(fd, target + received, chunk.readSize - received, chunk.fileOffset + received);
+        if(count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if(count <= 0)
+        {
+            return false;
+        }
+
+        received += count;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Checks that O_DIRECT reads at the alignment are accepted, with a
+ * read of the first aligned block of the data
+ */
+static bool probeDirect(int fd, const ChunkedRead& read, const DirectAlignment& alignment)
+{
+    if(alignment.offset == 0 || alignment.memory == 0)
+    {
+        return false;
+    }
+
+    AlignedBuffer buffer(alignment.offset, std::max(alignment.memory, BUFFER_ALIGNMENT));
+    ssize_t count;
+    do
+    {
+        count = ::pread(fd, buffer.data(), alignment.offset, read.offset / alignment.offset * alignment.offset);
+    } while(count < 0 && errno == EINTR);
+    return buffer.data() && count >= 0;
+}
+
+/**
+ * @brief Fixes-up a chunk read into the target, copying it to the
+ * destination if it went through a pool buffer
+ */
+static void completeChunk(int fd, const ChunkedRead& read, const Chunk& chunk, std::byte* target)
+{
+    auto* data = target + chunk.skip;
+    if(chunk.bounce && read.data)
+    {
+        std::memcpy(read.data + chunk.dataOffset, data, chunk.dataSize);
+        data = read.data + chunk.dataOffset;
+    }
+    if(read.swap)
+    {
+        swapEndianess(data, chunk.dataSize / read.wordSize, read.wordSize);
+    }
+    if(read.dropCache)
+    {
+        //Evict what has just been read, as it will not be read again
+        ::posix_fadvise(fd, chunk.fileOffset, chunk.readSize, POSIX_FADV_DONTNEED);
+    }
+    if(*read.callback)
+    {
+        (*read.callback)(data, chunk.dataOffset, chunk.dataSize);
+    }
+}
+
+static bool readChunk(int fd, const ChunkedRead& read, const Chunk& chunk, BufferPool& pool)
+{
+    auto* target = chunk.bounce ? pool.acquire() : read.data + chunk.dataOffset;
+    const auto result = preadChunk(fd, target, chunk);
+    if(result)
+    {
+        completeChunk(fd, read, chunk, target);
+    }
+    if(chunk.bounce)
+    {
+        pool.release(target);
+    }
+    return result;
+}
+
+/**
+ * @brief Counts the contiguous bytes that were completed
+ */
+static size_t countCompleted(const std::vector<Chunk>& chunks, const std::vector<uint8>& completed)
+{
+    size_t result = 0;
+    for(size_t i = 0; i < chunks.size() && completed[i]; ++i)
+    {
+        result += chunks[i].dataSize;
+    }
+    return result;
+}
+
+static size_t readChunksPread(int fd, const ChunkedRead& read, const std::vector<Chunk>& chunks, BufferPool& pool)
+{
+    if(read.dropCache)
+    {
+        ::posix_fadvise(fd, read.offset, read.size, POSIX_FADV_SEQUENTIAL);
+    }
+
+    size_t result = 0;
+    for(const auto& chunk : chunks)
+    {
+        if(!readChunk(fd, read, chunk, pool))
+        {
+            break;
+        }
+        result += chunk.dataSize;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Reads the chunks concurrently, each thread reading into a disjoint 
+ * slice of the destination, or a buffer of its own, and fixing up the chunks
+ * it reads
+ */
+static size_t readChunksParallel(int fd, const ChunkedRead& read, const std::vector<Chunk>& chunks, BufferPool& pool, size_t threadCount)
+{
+    std::vector<uint8> completed(chunks.size(), false);
+    parallelFor(
+        chunks.size(), threadCount,
+        [fd, &read, &chunks, &pool, &completed] (size_t i)
+        {
+            completed[i] = readChunk(fd, read, chunks[i], pool);
+        }
+    );
+
+    return countCompleted(chunks, completed);
+}
+
+#if MRCINSPECTOR_HAS_URING
+
+/**
+ * @brief Minimal io_uring wrapper over the raw system calls, so that 
+ * liburing is not needed
+ */
+class Uring
+{
+public:
+    explicit Uring(unsigned entries)
+    {
+        io_uring_params params = {};
+        m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if(m_fd < 0)
+        {
+            return;
+        }
+
+        //Map the rings
+        m_sqSize = params.sq_off.array + params.sq_entries*sizeof(unsigned);
+        m_cqSize = params.cq_off.cqes + params.cq_entries*sizeof(io_uring_cqe);
+        if(params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            m_sqSize = m_cqSize = std::max(m_sqSize, m_cqSize);
+        }
+        m_sqesSize = params.sq_entries*sizeof(io_uring_sqe);
+
+        m_sq = ::mmap(nullptr, m_sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+        m_cq = (params.features & IORING_FEAT_SINGLE_MMAP) ? m_sq :
+               ::mmap(nullptr, m_cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+        m_sqes = ::mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+        if(m_sq == MAP_FAILED || m_cq == MAP_FAILED || m_sqes == MAP_FAILED)
+        {
+            release();
+            return;
+        }
+
+        auto* sq = static_cast<std::byte*>(m_sq);
+        auto* cq = static_cast<std::byte*>(m_cq);
+        m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        m_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        m_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        m_entries = params.sq_entries;
+    }
+
+    Uring(const Uring& other) = delete;
+    Uring& operator=(const Uring& other) = delete;
+
+    ~Uring()
+    {
+        release();
+    }
+
+    bool isValid() const
+    {
+        return m_fd >= 0;
+    }
+
+    unsigned getEntries() const
+    {
+        return m_entries;
+    }
+
+    void prepareRead(int fd, std::byte* data, size_t size, size_t offset, uint64 userData)
+    {
+        const auto tail = *m_sqTail;
+        const auto index = tail & m_sqMask;
+        auto& sqe = static_cast<io_uring_sqe*>(m_sqes)[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64>(data);
+        sqe.len = static_cast<uint32>(size);
+        sqe.off = offset;
+        sqe.user_data = userData;
+        m_sqArray[index] = index;
+        __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++m_pending;
+    }
+
+    void prepareCancel(uint64 target, uint64 userData)
+    {
+        const auto tail = *m_sqTail;
+        const auto index = tail & m_sqMask;
+        auto& sqe = static_cast<io_uring_sqe*>(m_sqes)[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_ASYNC_CANCEL;
+        sqe.fd = -1;
+        sqe.addr = target;
+        sqe.user_data = userData;
+        m_sqArray[index] = index;
+        __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++m_pending;
+    }
+
+    unsigned getPending() const
+    {
+        return m_pending;
+    }
+
+    bool submitAndWait(unsigned minComplete)
+    {
+        int result;
+        do
+        {
+            result = static_cast<int>(::syscall(__NR_io_uring_enter, m_fd, m_pending, minComplete, IORING_ENTER_GETEVENTS, nullptr, 0));
+        } while(result < 0 && errno == EINTR);
+
+        if(result >= 0)
+        {
+            m_pending -= std::min(m_pending, static_cast<unsigned>(result));
+        }
+        return result >= 0;
+    }
+
+    template<typename F>
+    void forEachCompletion(F&& func)
+    {
+        auto head = *m_cqHead;
+        const auto tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        for(; head != tail; ++head)
+        {
+            const auto& cqe = m_cqes[head & m_cqMask];
+            func(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    int                         m_fd = -1;
+    unsigned                    m_entries = 0;
+    unsigned                    m_pending = 0;
+    void*                       m_sq = MAP_FAILED;
+    void*                       m_cq = MAP_FAILED;
+    void*                       m_sqes = MAP_FAILED;
+    size_t                      m_sqSize = 0;
+    size_t                      m_cqSize = 0;
+    size_t                      m_sqesSize = 0;
+    unsigned*                   m_sqTail = nullptr;
+    unsigned                    m_sqMask = 0;
+    unsigned*                   m_sqArray = nullptr;
+    unsigned*                   m_cqHead = nullptr;
+    unsigned*                   m_cqTail = nullptr;
+    unsigned                    m_cqMask = 0;
+    io_uring_cqe*               m_cqes = nullptr;
+
+    void release()
+    {
+        if(m_sqes != MAP_FAILED) ::munmap(m_sqes, m_sqesSize);
+        if(m_cq != MAP_FAILED && m_cq != m_sq) ::munmap(m_cq, m_cqSize);
+        if(m_sq != MAP_FAILED) ::munmap(m_sq, m_sqSize);
+        if(m_fd >= 0) ::close(m_fd);
+        m_sq = m_cq = m_sqes = MAP_FAILED;
+        m_fd = -1;
+    }
+};
+
+/**
+ * @brief Reads the chunks keeping up to queueDepth of them in flight. 
+ * Returns false if io_uring is not usable, so that the caller falls 
+ * back to pread. Otherwise, count holds the amount of bytes read
+ */
+static bool readChunksUring(int fd, const ChunkedRead& read, const std::vector<Chunk>& chunks, BufferPool& pool, size_t queueDepth, size_t& count)
+{
+    Uring ring(static_cast<unsigned>(std::max(queueDepth, size_t(1))));
+    if(!ring.isValid())
+    {
+        return false;
+    }
+
+    //Progress and target of each of the chunks, for resubmitting short reads
+    const auto nChunks = chunks.size();
+    const auto maxInFlight = std::min<size_t>(std::max(queueDepth, size_t(1)), ring.getEntries());
+    std::vector<size_t> progress(nChunks, 0);
+    std::vector<std::byte*> targets(nChunks, nullptr);
+    std::vector<uint8> completed(nChunks, false);
+    std::vector<bool> pending(nChunks, false);
+    size_t nextChunk = 0;
+    size_t inFlight = 0;
+    size_t completedCount = 0;
+    bool error = false;
+    bool unsupported = false;
+
+    const auto submitChunk = [&ring, &read, &chunks, &progress, &targets, &pending, &pool, fd] (size_t i)
+    {
+        const auto& chunk = chunks[i];
+        if(!targets[i])
+        {
+            targets[i] = chunk.bounce ? pool.acquire() : read.data + chunk.dataOffset;
+        }
+        ring.prepareRead(fd, targets[i] + progress[i], chunk.readSize - progress[i], chunk.fileOffset + progress[i], i);
+        pending[i] = true;
+    };
+    const auto releaseChunk = [&chunks, &targets, &pool] (size_t i)
+    {
+        if(chunks[i].bounce && targets[i])
+        {
+            pool.release(targets[i]);
+        }
+        targets[i] = nullptr;
+    };
+
+    //Keep going until all chunks complete. On error, stop submitting
+    //and only wait for the chunks in flight, as they write to the buffers
+    while((completedCount < nChunks && !error) || inFlight > 0)
+    {
+        //Fill the queue
+        while(!error && nextChunk < nChunks && inFlight < maxInFlight)
+        {
+            submitChunk(nextChunk++);
+            ++inFlight;
+        }
+
+        if(!ring.submitAndWait(1))
+        {
+            unsupported = (completedCount == 0);
+            error = true;
+            break;
+        }
+
+        //Fix-up the completed chunks while the rest are in flight
+        ring.forEachCompletion(
+            [&] (uint64 i, int res)
+            {
+                --inFlight;
+                pending[i] = false;
+                const auto& chunk = chunks[i];
+                if(res < 0 && res != -EAGAIN && res != -EINTR)
+                {
+                    unsupported = (completedCount == 0 && res == -EINVAL);
+                    error = true;
+                }
+                else if(res == 0)
+                {
+                    error = true; //Unexpected EOF
+                }
+                else if(!error)
+                {
+                    progress[i] += std::max(res, 0);
+                    if(progress[i] < chunk.skip + chunk.dataSize)
+                    {
+                        //Short read or retry, request the remainder
+                        submitChunk(i);
+                        ++inFlight;
+                        return;
+                    }
+
+                    completeChunk(fd, read, chunk, targets[i]);
+                    completed[i] = true;
+                    ++completedCount;
+                }
+                releaseChunk(i);
+            }
+        );
+    }
+
+    //The kernel may still write to the buffers, which are about to be reused by
+    //the fallback or freed. Cancel the chunks in flight and reap them first
+    if(inFlight > 0)
+    {
+        for(size_t i = 0; i < nChunks; ++i)
+        {
+            if(pending[i])
+            {
+                if(ring.getPending() >= ring.getEntries())
+                {
+                    ring.submitAndWait(0);
+                }
+                ring.prepareCancel(i, CANCEL_USER_DATA);
+            }
+        }
+
+        while(true)
+        {
+            ring.forEachCompletion(
+                [&] (uint64 i, int)
+                {
+                    if(i != CANCEL_USER_DATA)
+                    {
+                        --inFlight;
+                        releaseChunk(i);
+                    }
+                }
+            );
+
+            if(inFlight == 0)
+            {
+                break;
+            }
+            else if(!ring.submitAndWait(1) && errno != EAGAIN && errno != EBUSY)
+            {
+                //Can not tell when the buffers are released. Fail the read
+                //instead of falling back to pread into them
+                count = 0;
+                return true;
+            }
+        }
+    }
+
+    if(unsupported)
+    {
+        return false;
+    }
+
+    count = countCompleted(chunks, completed);
+    return true;
+}
+
+#endif
+
+/**
+ * @brief Reads the chunks with the requested backend. O_DIRECT is a property of
+ * the file descriptor, so every backend honors it once the file system has been
+ * checked to accept it. Otherwise, chunks are dropped from the page cache
+ */
+static size_t readChunks(const char* path, ChunkedRead& read, const FileReadOptions& options)
+{
+    //Chunks must hold whole values
+    auto chunkSize = std::max(options.chunkSize / read.elementSize, size_t(1)) * read.elementSize;
+
+    int fd = -1;
+    DirectAlignment alignment = { 0, 0 };
+    if(options.direct)
+    {
+        fd = ::open(path, O_RDONLY | O_CLOEXEC | O_DIRECT);
+        alignment = fd >= 0 ? getDirectAlignment(fd) : alignment;
+        if(fd >= 0 && !probeDirect(fd, read, alignment))
+        {
+            ::close(fd);
+            fd = -1;
+            alignment = { 0, 0 };
+        }
+    }
+    const bool direct = fd >= 0;
+    if(!direct)
+    {
+        fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if(fd < 0)
+        {
+            return 0;
+        }
+    }
+
+    read.dropCache = options.direct && !direct;
+    if(direct)
+    {
+        chunkSize = alignUp(chunkSize, std::lcm(read.elementSize, alignment.offset));
+    }
+    const auto chunks = planChunks(read, chunkSize, direct ? &alignment : nullptr);
+
+    //A buffer for each of the chunks that can be read at the same time
+    auto concurrency = size_t(1);
+    if(options.backend == ReadBackend::parallel)
+    {
+        concurrency = options.threadCount;
+    }
+    else if(options.backend == ReadBackend::uring)
+    {
+        concurrency = options.queueDepth;
+    }
+    const auto bounceCount = static_cast<size_t>(std::count_if(chunks.cbegin(), chunks.cend(), [] (const Chunk& chunk) { return chunk.bounce; }));
+    BufferPool pool(std::min(std::max(concurrency, size_t(1)), bounceCount), chunkSize + alignment.offset, std::max(alignment.memory, BUFFER_ALIGNMENT));
+    if(!pool.isValid())
+    {
+        ::close(fd);
+        return 0;
+    }
+
+    size_t result = 0;
+    bool done = false;
+    if(options.backend == ReadBackend::parallel)
+    {
+        result = readChunksParallel(fd, read, chunks, pool, options.threadCount);
+        done = true;
+    }
+
+    #if MRCINSPECTOR_HAS_URING
+        if(options.backend == ReadBackend::uring)
+        {
+            done = readChunksUring(fd, read, chunks, pool, options.queueDepth, result);
+        }
+    #endif
+    if(!done)
+    {
+        result = readChunksPread(fd, read, chunks, pool);
+    }
+
+    ::close(fd);
+    return result;
+}
+
+static size_t readDataStream(const char* path, const MainHeader& header, DataBlock& data, const ChunkCallback& callback)
+{
+    std::ifstream file(path, std::ios_base::in | std::ios_base::binary);
+    file.seekg(getDataOffset(header));
+    const auto result = readData(file, header, data);
+    if(result && callback)
+    {
+        std::visit(
+            [&callback, result] (auto& values)
+            {
+                callback(reinterpret_cast<std::byte*>(values.data()), 0, result);
+            },
+            data
+        );
+    }
+    return result;
+}
+
+/** PUBLIC FUNCTIONS **/
+
+size_t readDataFile(const char* path, 
+                    const MainHeader& header, 
+                    DataBlock& data, 
+                    const FileReadOptions& options,
+                    const ChunkCallback& callback )
+{
+    //Bytes have no byte order to match
+    const auto endianess = getModeEndianess(header.byteOrder, header.mode);
+    const auto wordSize = getModeWordSize(header.mode);
+    if(isPackedMode(header.mode) || !emplaceDataBlock(data, header) || (wordSize > 1 && static_cast<Word>(endianess) == 0))
+    {
+        return 0;
+    }
+    if(options.backend == ReadBackend::stream && !options.direct)
+    {
+        return readDataStream(path, header, data, callback);
+    }
+
+    //Allocate the destination
+    ChunkedRead read;
+    std::visit(
+        [&read, &header] (auto& values)
+        {
+            values.resize(getElementCount(header));
+            read.data = reinterpret_cast<std::byte*>(values.data());
+        },
+        data
+    );
+    read.size = getDataSize(header);
+    read.offset = getDataOffset(header);
+    read.elementSize = getModeSize(header.mode);
+    read.wordSize = wordSize;
+    read.swap = wordSize > 1 && needsSwap(endianess);
+    read.callback = &callback;
+    return readChunks(path, read, options);
+}
+
+size_t readDataChunks(  const char* path, 
+                        const MainHeader& header, 
+                        const FileReadOptions& options,
+                        const ChunkCallback& callback )
+{
+    ChunkedRead read;
+    read.data = nullptr;
+    read.size = getDataSize(header);
+    read.offset = getDataOffset(header);
+    read.elementSize = getModeSize(header.mode);
+    read.wordSize = getModeWordSize(header.mode);
+    read.swap = false;
+    read.callback = &callback;
+    if(isPackedMode(header.mode) || read.elementSize == 0 || read.size == 0)
+    {
+        return 0;
+    }
+
+    return readChunks(path, read, options);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#include <FileStamp.h>
+
+#include <sys/stat.h>
+
+namespace MrcInspector
+{
+
+/** PUBLIC FUNCTIONS **/
+
+bool getFileStamp(const char* path, FileStamp& stamp)
+{
+    struct stat status;
+    if(stat(path, &status) != 0)
+    {
+        return false;
+    }
+
+    stamp.size = status.st_size;
+    stamp.modificationTime = static_cast<int64>(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+    return true;
+}
+
+}
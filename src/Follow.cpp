@@ -0,0 +1,250 @@
+#include <Follow.h>
+
+#include <Read.h>
+#include <Region.h>
+#include <Checksum.h>
+#include <Hash.h>
+#include <ByteSwap.h>
+#include <Packed.h>
+#include <Parallel.h>
+
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr size_t FOLLOW_BATCH_SIZE = 64 << 20;
+static constexpr size_t EVENT_BUFFER_SIZE = 4096;
+
+/** STATIC FUNCTIONS **/
+
+static bool isSameLayout(const MainHeader& lhs, const MainHeader& rhs)
+{
+    return  lhs.dimensions[0] == rhs.dimensions[0] &&
+            lhs.dimensions[1] == rhs.dimensions[1] &&
+            lhs.mode == rhs.mode &&
+            lhs.extHeaderLen == rhs.extHeaderLen &&
+            lhs.byteOrder == rhs.byteOrder ;
+}
+
+static bool readAt(int fd, std::byte* data, size_t size, size_t offset)
+{
+    while(size > 0)
+    {
+        const auto count = pread(fd, data, size, offset);
+        if(count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if(count <= 0)
+        {
+            return false;
+        }
+        data += count;
+        size -= count;
+        offset += count;
+    }
+    return true;
+}
+
+/**
+ * @brief Hashes the bytes the same way computeChecksum does: by chunks,
+ * carrying the incomplete one over to the next call
+ */
+static void hashBytes(FollowState& state, const std::byte* data, size_t size, size_t threadCount)
+{
+    auto& pending = state.pending;
+    if(!pending.empty())
+    {
+        const auto count = std::min(size, CHECKSUM_CHUNK_SIZE - pending.size());
+        pending.insert(pending.end(), data, data + count);
+        data += count;
+        size -= count;
+        if(pending.size() == CHECKSUM_CHUNK_SIZE)
+        {
+            state.chunkHashes.push_back(hash64(pending.data(), pending.size()));
+            pending.clear();
+        }
+    }
+
+    const auto nChunks = size / CHECKSUM_CHUNK_SIZE;
+    const auto first = state.chunkHashes.size();
+    state.chunkHashes.resize(first + nChunks);
+    parallelFor(
+        nChunks, threadCount,
+        [&state, data, first] (size_t i)
+        {
+            state.chunkHashes[first + i] = hash64(data + i*CHECKSUM_CHUNK_SIZE, CHECKSUM_CHUNK_SIZE);
+        }
+    );
+
+    const auto remaining = nChunks * CHECKSUM_CHUNK_SIZE;
+    pending.insert(pending.end(), data + remaining, data + size);
+}
+
+/** PUBLIC FUNCTIONS **/
+
+FollowState makeFollowState()
+{
+    FollowState result = {};
+    result.statistics = makeStatistics();
+    return result;
+}
+
+bool updateFollowState(int fd, FollowState& state, size_t threadCount, const FollowCallback& callback)
+{
+    struct stat status;
+    if(fstat(fd, &status) != 0)
+    {
+        return false;
+    }
+    const size_t size = status.st_size;
+    if(size < sizeof(MainHeader))
+    {
+        return true; //Nothing written yet
+    }
+
+    MainHeader header;
+    if( !readAt(fd, reinterpret_cast<std::byte*>(&header), sizeof(header), 0) ||
+        !decodeMainHeader(header) ||
+        (state.sectionCount > 0 && !isSameLayout(state.header, header)) )
+    {
+        return false;
+    }
+    state.header = header;
+
+    //Only complete sections are consumed
+    const auto sectionSize = getSectionSize(header);
+    const auto offset = getDataOffset(header);
+    if(sectionSize == 0 || size < offset + state.sectionCount*sectionSize)
+    {
+        return sectionSize != 0 && state.sectionCount == 0; //Unknown mode or truncated
+    }
+    const auto available = (size - offset) / sectionSize;
+
+    //Read the new sections by batches, so that a long backlog does not need to fit in memory
+    const auto elementCount = getSectionElementCount(header);
+    const auto batchSize = std::max<size_t>(FOLLOW_BATCH_SIZE / sectionSize, 1);
+    const auto wordSize = getModeWordSize(header.mode);
+    const auto swap = wordSize > 1 && needsSwap(getModeEndianess(header.byteOrder, header.mode));
+    const auto packed = isPackedMode(header.mode);
+    std::vector<std::byte> packedBytes(packed ? std::min(batchSize, available - state.sectionCount)*sectionSize : 0);
+    DataBlock data;
+    std::vector<Statistics> sectionStatistics;
+    while(state.sectionCount < available)
+    {
+        const auto count = std::min(batchSize, available - state.sectionCount);
+        auto* bytes = allocateDataBlock(data, header, count*elementCount);
+        auto* stored = packed ? packedBytes.data() : bytes;
+        if(!bytes || !readAt(fd, stored, count*sectionSize, offset + state.sectionCount*sectionSize))
+        {
+            return false;
+        }
+
+        //Hash as stored, then compute the statistics of each section in native order
+        hashBytes(state, stored, count*sectionSize, threadCount);
+        if(packed)
+        {
+            unpackRows(reinterpret_cast<const uint8*>(stored), header.dimensions[0], count*header.dimensions[1], reinterpret_cast<uint8*>(bytes));
+        }
+        else if(swap)
+        {
+            swapEndianess(bytes, count*sectionSize / wordSize, wordSize);
+        }
+        sectionStatistics.assign(count, makeStatistics());
+        std::visit(
+            [&sectionStatistics, count, elementCount, threadCount] (const auto& values)
+            {
+                parallelFor(
+                    count, threadCount,
+                    [&sectionStatistics, &values, elementCount] (size_t i)
+                    {
+                        accumulateStatistics(sectionStatistics[i], values.data() + i*elementCount, elementCount);
+                    }
+                );
+            },
+            data
+        );
+
+        for(size_t i = 0; i < count; ++i)
+        {
+            mergeStatistics(state.statistics, sectionStatistics[i]);
+            callback(state.sectionCount + i, sectionStatistics[i]);
+        }
+        state.sectionCount += count;
+    }
+
+    return true;
+}
+
+uint64 getFollowDataHash(const FollowState& state)
+{
+    auto hashes = state.chunkHashes;
+    if(!state.pending.empty())
+    {
+        hashes.push_back(hash64(state.pending.data(), state.pending.size()));
+    }
+    return combineHash64Tree(std::move(hashes));
+}
+
+bool followFile(const char* path, const FollowOptions& options, FollowState& state, const FollowCallback& callback)
+{
+    const auto fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return false;
+    }
+
+    //Unlinking an open file only changes its link count, so IN_ATTRIB is watched too
+    const auto notify = inotify_init1(IN_CLOEXEC);
+    const auto mask = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF;
+    auto result = notify >= 0 && inotify_add_watch(notify, path, mask) >= 0;
+    result = result && updateFollowState(fd, state, options.threadCount, callback);
+
+    bool gone = false;
+    while(result && !gone)
+    {
+        pollfd request = { notify, POLLIN, 0 };
+        const auto ready = poll(&request, 1, options.idleTimeout);
+        if(ready < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if(ready <= 0)
+        {
+            break; //Idle
+        }
+
+        //Drain the events, so that a burst of writes is handled by a single update
+        alignas(inotify_event) char buffer[EVENT_BUFFER_SIZE];
+        const auto length = read(notify, buffer, sizeof(buffer));
+        for(ssize_t i = 0; i < length; )
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + i);
+            gone = gone || (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED));
+            i += sizeof(inotify_event) + event->len;
+        }
+
+        struct stat status;
+        gone = gone || fstat(fd, &status) != 0 || status.st_nlink == 0;
+        result = updateFollowState(fd, state, options.threadCount, callback);
+    }
+
+    if(notify >= 0)
+    {
+        close(notify);
+    }
+    close(fd);
+    return result;
+}
+
+}
@@ -0,0 +1,191 @@
+#include <Hash.h>
+
+#include <array>
+#include <cstring>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr size_t LANE_COUNT = 8;
+static constexpr size_t STRIPE_SIZE = LANE_COUNT * sizeof(uint64);
+static constexpr size_t STRIPES_PER_BLOCK = 16;
+static constexpr size_t BLOCK_SIZE = STRIPE_SIZE * STRIPES_PER_BLOCK;
+
+static constexpr uint64 PRIME32_1 = 0x9E3779B1U;
+static constexpr uint64 PRIME32_2 = 0x85EBCA77U;
+static constexpr uint64 PRIME32_3 = 0xC2B2AE3DU;
+static constexpr uint64 PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64 PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr uint64 PRIME64_3 = 0x165667B19E3779F9ULL;
+static constexpr uint64 PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static constexpr uint64 PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+/**
+ * @brief Secret keys. Generated at compile time with splitmix64, so that
+ * they do not need to be stored as a table of magic numbers
+ */
+static constexpr std::array<uint64, LANE_COUNT + STRIPES_PER_BLOCK> SECRET = [] ()
+{
+    std::array<uint64, LANE_COUNT + STRIPES_PER_BLOCK> result = {};
+    uint64 state = PRIME64_1;
+    for(auto& value : result)
+    {
+        state += 0x9E3779B97F4A7C15ULL;
+        uint64 z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        value = z ^ (z >> 31);
+    }
+    return result;
+}();
+
+/** STATIC FUNCTIONS **/
+
+static uint64 readLittleEndian64(const std::byte* data)
+{
+    uint64 result;
+    std::memcpy(&result, data, sizeof(result));
+    #if BYTE_ORDER == BIG_ENDIAN
+        result = __builtin_bswap64(result);
+    #endif
+    return result;
+}
+
+static uint64 mul128Fold64(uint64 lhs, uint64 rhs)
+{
+    //Portable 64x64->128bit multiplication, folding the high and low halves
+    const uint64 lo0 = lhs & 0xFFFFFFFFULL, hi0 = lhs >> 32;
+    const uint64 lo1 = rhs & 0xFFFFFFFFULL, hi1 = rhs >> 32;
+    const uint64 lolo = lo0 * lo1;
+    const uint64 hilo = hi0 * lo1;
+    const uint64 lohi = lo0 * hi1;
+    const uint64 hihi = hi0 * hi1;
+    const uint64 cross = (lolo >> 32) + (hilo & 0xFFFFFFFFULL) + lohi;
+    const uint64 upper = (hilo >> 32) + (cross >> 32) + hihi;
+    const uint64 lower = (cross << 32) | (lolo & 0xFFFFFFFFULL);
+    return lower ^ upper;
+}
+
+static uint64 avalanche(uint64 h)
+{
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+static void accumulateStripe(std::array<uint64, LANE_COUNT>& acc, const std::byte* data, const uint64* key)
+{
+    //Independent lanes. This is the loop that gets vectorized
+    for(size_t i = 0; i < LANE_COUNT; ++i)
+    {
+        const auto value = readLittleEndian64(data + i*sizeof(uint64));
+        const auto keyed = value ^ key[i];
+        acc[i ^ 1] += value;
+        acc[i] += (keyed & 0xFFFFFFFFULL) * (keyed >> 32);
+    }
+}
+
+static void scramble(std::array<uint64, LANE_COUNT>& acc)
+{
+    for(size_t i = 0; i < LANE_COUNT; ++i)
+    {
+        acc[i] ^= acc[i] >> 47;
+        acc[i] ^= SECRET[STRIPES_PER_BLOCK + i];
+        acc[i] *= PRIME32_1;
+    }
+}
+
+/** PUBLIC FUNCTIONS **/
+
+uint64 hash64(const std::byte* data, size_t size, uint64 seed)
+{
+    std::array<uint64, LANE_COUNT> acc = {
+        PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3,
+        PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1
+    };
+    for(size_t i = 0; i < LANE_COUNT; ++i)
+    {
+        acc[i] += (i % 2) ? -seed : seed;
+    }
+
+    //Process full blocks, scrambling the accumulators after each one
+    const auto* ite = data;
+    const auto* const end = data + size;
+    for(; static_cast<size_t>(end - ite) >= BLOCK_SIZE; ite += BLOCK_SIZE)
+    {
+        for(size_t s = 0; s < STRIPES_PER_BLOCK; ++s)
+        {
+            accumulateStripe(acc, ite + s*STRIPE_SIZE, SECRET.data() + s);
+        }
+        scramble(acc);
+    }
+
+    //Process the remaining full stripes
+    size_t stripe = 0;
+    for(; static_cast<size_t>(end - ite) >= STRIPE_SIZE; ite += STRIPE_SIZE)
+    {
+        accumulateStripe(acc, ite, SECRET.data() + stripe++);
+    }
+
+    //Process the last partial stripe zero-padded. The length is mixed
+    //below, so that trailing zeros are not ambiguous
+    if(ite != end)
+    {
+        std::array<std::byte, STRIPE_SIZE> last = {};
+        std::memcpy(last.data(), ite, end - ite);
+        accumulateStripe(acc, last.data(), SECRET.data() + stripe);
+    }
+
+    //Merge the accumulators
+    uint64 result = static_cast<uint64>(size) * PRIME64_1;
+    for(size_t i = 0; i < LANE_COUNT; i += 2)
+    {
+        result += mul128Fold64(acc[i] ^ SECRET[i], acc[i+1] ^ SECRET[i+1]);
+    }
+    return avalanche(result);
+}
+
+uint64 combineHash64(uint64 left, uint64 right)
+{
+    std::array<std::byte, 2*sizeof(uint64)> buffer;
+    for(size_t i = 0; i < sizeof(uint64); ++i)
+    {
+        buffer[i] = static_cast<std::byte>(left >> (8*i));
+        buffer[sizeof(uint64) + i] = static_cast<std::byte>(right >> (8*i));
+    }
+    return hash64(buffer.data(), buffer.size());
+}
+
+uint64 combineHash64Tree(std::vector<uint64> hashes)
+{
+    if(hashes.empty())
+    {
+        return hash64(nullptr, 0);
+    }
+
+    //Combine by pairs level by level. Odd elements are promoted as they are
+    while(hashes.size() > 1)
+    {
+        const auto half = hashes.size() / 2;
+        for(size_t i = 0; i < half; ++i)
+        {
+            hashes[i] = combineHash64(hashes[2*i], hashes[2*i+1]);
+        }
+        if(hashes.size() % 2)
+        {
+            hashes[half] = hashes.back();
+            hashes.resize(half + 1);
+        }
+        else
+        {
+            hashes.resize(half);
+        }
+    }
+
+    return hashes.front();
+}
+
+}
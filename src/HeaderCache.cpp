@@ -0,0 +1,107 @@
+#include <HeaderCache.h>
+
+#include <Read.h>
+#include <Decompress.h>
+#include <Validate.h>
+
+#include <algorithm>
+
+namespace MrcInspector
+{
+
+/** STATIC FUNCTIONS **/
+
+static bool isSameStamp(const FileStamp& lhs, const FileStamp& rhs)
+{
+    return lhs.size == rhs.size && lhs.modificationTime == rhs.modificationTime;
+}
+
+/** PUBLIC FUNCTIONS **/
+
+HeaderCache::HeaderCache(size_t capacity)
+    : m_capacity(std::max<size_t>(capacity, 1))
+{
+}
+
+std::shared_ptr<const HeaderCacheEntry> HeaderCache::get(const std::string& path)
+{
+    FileStamp stamp;
+    if(!getFileStamp(path.c_str(), stamp))
+    {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto ite = m_index.find(path);
+        if(ite != m_index.cend() && isSameStamp(ite->second->second->stamp, stamp))
+        {
+            m_entries.splice(m_entries.begin(), m_entries, ite->second);
+            ++m_hitCount;
+            return ite->second->second;
+        }
+        ++m_missCount;
+    }
+
+    //Parse without holding the lock, so that other clients are not stalled
+    auto entry = std::make_shared<HeaderCacheEntry>();
+    entry->stamp = stamp;
+    Compression compression;
+    const auto is = openInputFile(path.c_str(), 1, compression);
+    if( !is ||
+        readMainHeader(*is, entry->header) != sizeof(MainHeader) ||
+        validateHeader(entry->header, getValidationContext(*is)) == Validity::corrupt ||
+        readExtendedHeader(*is, entry->header, entry->extHeader) != entry->extHeader.size() )
+    {
+        return nullptr;
+    }
+
+    insert(path, entry);
+    return entry;
+}
+
+void HeaderCache::setStatistics(const std::string& path, const FileStamp& stamp, const Statistics& statistics)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto ite = m_index.find(path);
+    if(ite != m_index.cend() && isSameStamp(ite->second->second->stamp, stamp))
+    {
+        auto entry = std::make_shared<HeaderCacheEntry>(*ite->second->second);
+        entry->statistics = statistics;
+        ite->second->second = std::move(entry);
+    }
+}
+
+size_t HeaderCache::getHitCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hitCount;
+}
+
+size_t HeaderCache::getMissCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_missCount;
+}
+
+void HeaderCache::insert(const std::string& path, std::shared_ptr<const HeaderCacheEntry> entry)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto ite = m_index.find(path);
+    if(ite != m_index.cend())
+    {
+        ite->second->second = std::move(entry);
+        m_entries.splice(m_entries.begin(), m_entries, ite->second);
+        return;
+    }
+
+    m_entries.emplace_front(path, std::move(entry));
+    m_index.emplace(path, m_entries.begin());
+    if(m_entries.size() > m_capacity)
+    {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+}
+
+}
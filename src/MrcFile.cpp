@@ -0,0 +1,161 @@
+#include <MrcFile.h>
+
+#include <Read.h>
+#include <Brick.h>
+#include <Decompress.h>
+
+#include <limits>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr size_t UNKNOWN_POSITION = std::numeric_limits<size_t>::max();
+
+/** PUBLIC FUNCTIONS **/
+
+bool MrcFile::open(const std::string& path, size_t threadCount)
+{
+    m_path = path;
+    m_threadCount = threadCount;
+    m_validity = Validity::corrupt;
+    m_extHeader.clear();
+    m_stream = openInputFile(path.c_str(), threadCount, m_compression);
+    if(!m_stream || readMainHeader(*m_stream, m_header) != sizeof(MainHeader))
+    {
+        m_stream.reset();
+        return false;
+    }
+
+    //Rejected before the lengths in the header drive any allocation
+    m_validity = validateHeader(m_header, getValidationContext(*m_stream));
+    if( m_validity == Validity::corrupt ||
+        readExtendedHeader(*m_stream, m_header, m_extHeader) != m_extHeader.size() )
+    {
+        m_stream.reset();
+        return false;
+    }
+
+    m_position = getDataOffset(m_header);
+    return true;
+}
+
+bool MrcFile::isOpen() const
+{
+    return m_stream != nullptr;
+}
+
+const std::string& MrcFile::getPath() const
+{
+    return m_path;
+}
+
+const MainHeader& MrcFile::getHeader() const
+{
+    return m_header;
+}
+
+const std::string& MrcFile::getExtendedHeader() const
+{
+    return m_extHeader;
+}
+
+Compression MrcFile::getCompression() const
+{
+    return m_compression;
+}
+
+Validity MrcFile::getValidity() const
+{
+    return m_validity;
+}
+
+size_t MrcFile::readData(DataBlock& data)
+{
+    return readSections(0, m_header.dimensions[2], data);
+}
+
+size_t MrcFile::readSections(size_t first, size_t count, DataBlock& data)
+{
+    if(first + count > m_header.dimensions[2] || !seekSection(first))
+    {
+        return 0;
+    }
+
+    const auto result = MrcInspector::readSections(*m_stream, m_header, count, data);
+    m_position = result ? m_position + result : UNKNOWN_POSITION;
+    return result;
+}
+
+size_t MrcFile::readRegion(const Region& region, DataBlock& data)
+{
+    if(!isValidRegion(m_header, region) || !seekSection(0))
+    {
+        return 0;
+    }
+
+    //Rows are skipped as the region requires
+    m_position = UNKNOWN_POSITION;
+    return readCachedRegion(m_path.c_str(), *m_stream, m_header, region, data);
+}
+
+bool MrcFile::computeStatistics(Statistics& statistics)
+{
+    if(!seekSection(0))
+    {
+        return false;
+    }
+
+    const auto count = computeStreamStatistics(*m_stream, m_header, m_threadCount, statistics);
+    m_position = UNKNOWN_POSITION;
+    return count == m_header.dimensions[2];
+}
+
+bool MrcFile::computeStatistics(Statistics& statistics, const FileReadOptions& options)
+{
+    if(!m_stream || m_compression != Compression::none || isPackedMode(m_header.mode))
+    {
+        return computeStatistics(statistics);
+    }
+
+    return computeFileStatistics(m_path.c_str(), m_header, options, statistics) == m_header.dimensions[2];
+}
+
+bool MrcFile::seekSection(size_t section)
+{
+    if(!m_stream)
+    {
+        return false;
+    }
+
+    const auto target = getDataOffset(m_header) + section*getSectionSize(m_header);
+    m_stream->clear();
+    if(m_stream->seekg(target))
+    {
+        m_position = target;
+        return true;
+    }
+
+    //Streams that can not seek are read through, from the start if needed
+    m_stream->clear();
+    if(m_position > target)
+    {
+        MainHeader header;
+        m_stream = openInputFile(m_path.c_str(), m_threadCount, m_compression);
+        m_position = 0;
+        if(!m_stream || readMainHeader(*m_stream, header) != sizeof(MainHeader))
+        {
+            m_stream.reset();
+            return false;
+        }
+        m_position = sizeof(MainHeader);
+    }
+
+    m_stream->ignore(target - m_position);
+    const auto skipped = static_cast<size_t>(m_stream->gcount());
+    m_position += skipped;
+    return m_position == target;
+}
+
+}
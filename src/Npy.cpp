@@ -0,0 +1,99 @@
+#include <Npy.h>
+
+#include <string>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr std::string_view NPY_MAGIC("\x93NUMPY\x01\x00", 8);
+static constexpr size_t NPY_ALIGNMENT = 64;
+
+/** PUBLIC FUNCTIONS **/
+
+std::string_view getNpyDescriptor(Mode mode)
+{
+    #if BYTE_ORDER == LITTLE_ENDIAN
+        #define MRCINSPECTOR_NPY_ORDER "<"
+    #else
+        #define MRCINSPECTOR_NPY_ORDER ">"
+    #endif
+
+    switch (mode)
+    {
+    case Mode::sint8:   return "|i1";
+    case Mode::sint16:  return MRCINSPECTOR_NPY_ORDER "i2";
+    case Mode::float32: return MRCINSPECTOR_NPY_ORDER "f4";
+    case Mode::cint16:  return ""; //No NumPy equivalent
+    case Mode::cfloat32:return MRCINSPECTOR_NPY_ORDER "c8";
+    case Mode::uint16:  return MRCINSPECTOR_NPY_ORDER "u2";
+    case Mode::float16: return MRCINSPECTOR_NPY_ORDER "f2";
+    case Mode::packed4: return "|u1"; //Expanded
+    default:            return "";
+    }
+
+    #undef MRCINSPECTOR_NPY_ORDER
+}
+
+std::string_view getNpyDescriptor(const MainHeader& header)
+{
+    return hasUnsignedBytes(header) ? "|u1" : getNpyDescriptor(header.mode);
+}
+
+size_t writeNpyHeader(std::ostream& os, Mode mode, const std::vector<size_t>& shape)
+{
+    return writeNpyHeader(os, getNpyDescriptor(mode), shape);
+}
+
+size_t writeNpyHeader(std::ostream& os, const MainHeader& header, const std::vector<size_t>& shape)
+{
+    return writeNpyHeader(os, getNpyDescriptor(header), shape);
+}
+
+size_t writeNpyHeader(std::ostream& os, std::string_view descriptor, const std::vector<size_t>& shape)
+{
+    if(descriptor.empty())
+    {
+        return 0;
+    }
+
+    //Python dictionary literal describing the array
+    std::string dict = "{'descr': '" + std::string(descriptor) + "', 'fortran_order': False, 'shape': (";
+    for(const auto dimension : shape)
+    {
+        dict += std::to_string(dimension) + ", ";
+    }
+    if(shape.size() > 1)
+    {
+        dict.resize(dict.size() - 1); //Trailing comma is only required for 1D
+    }
+    dict += "), }";
+
+    //Pad with spaces and a newline so that the data is aligned
+    const auto prefixSize = NPY_MAGIC.size() + sizeof(uint16);
+    const auto totalSize = (prefixSize + dict.size() + 1 + NPY_ALIGNMENT - 1) / NPY_ALIGNMENT * NPY_ALIGNMENT;
+    dict.resize(totalSize - prefixSize - 1, ' ');
+    dict += '\n';
+
+    //Header length is always stored as LE
+    const auto headerSize = static_cast<uint16>(dict.size());
+    const char headerSizeBytes[] = { 
+        static_cast<char>(headerSize & 0xFF), 
+        static_cast<char>(headerSize >> 8) 
+    };
+
+    os.write(NPY_MAGIC.data(), NPY_MAGIC.size());
+    os.write(headerSizeBytes, sizeof(headerSizeBytes));
+    os.write(dict.data(), dict.size());
+    return os.good() ? totalSize : 0;
+}
+
+bool isNpyPath(std::string_view path)
+{
+    constexpr std::string_view extension = ".npy";
+    return  path.size() >= extension.size() && 
+            path.substr(path.size() - extension.size()) == extension;
+}
+
+}
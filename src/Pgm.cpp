@@ -0,0 +1,53 @@
+#include <Pgm.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/** PUBLIC FUNCTIONS **/
+
+size_t writePgm(std::ostream& os, const float32* data, size_t width, size_t height)
+{
+    const auto count = width * height;
+
+    //Range of the finite values. NaN and infinities are left out
+    auto min = std::numeric_limits<float32>::infinity();
+    auto max = -std::numeric_limits<float32>::infinity();
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(std::isfinite(data[i]))
+        {
+            min = std::min(min, data[i]);
+            max = std::max(max, data[i]);
+        }
+    }
+    const auto offset = min <= max ? min : 0.0f;
+    const auto scale = max > min ? 255.0f / (max - min) : 0.0f;
+
+    //Quantize. Non-finite values become black
+    std::vector<uint8> pixels(count);
+    for(size_t i = 0; i < count; ++i)
+    {
+        const auto value = std::isfinite(data[i]) ? (data[i] - offset) * scale + 0.5f : 0.0f;
+        pixels[i] = static_cast<uint8>(std::clamp(value, 0.0f, 255.0f));
+    }
+
+    const auto header = "P5\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    os.write(header.data(), header.size());
+    os.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+    return os.good() ? header.size() + pixels.size() : 0;
+}
+
+bool isPgmPath(std::string_view path)
+{
+    constexpr std::string_view extension = ".pgm";
+    return  path.size() >= extension.size() && 
+            path.substr(path.size() - extension.size()) == extension;
+}
+
+}
@@ -2,6 +2,7 @@
 #include <Print.h>
 
 #include <algorithm>
+#include <ctime>
 #include <iomanip>
 
 namespace MrcInspector
@@ -34,6 +35,24 @@ static void printEnum(std::ostream& os, std::string_view name, T value)
     os << std::dec << static_cast<int>(value) << " (" << toString(value) << ")\n";
 }
 
+static void printHash(std::ostream& os, std::string_view name, uint64 value)
+{
+    printName(os, name);
+    os << std::hex << std::setfill('0') << std::setw(16) << value << std::setfill(' ') << '\n';
+}
+
+static void printValue(std::ostream& os, const cfloat128& value)
+{
+    if(value.imag() == 0)
+    {
+        os << value.real();
+    }
+    else
+    {
+        os << value;
+    }
+}
+
 static std::string_view toStringBeLe(Endianess x)
 {
     switch(x)
@@ -72,7 +91,14 @@ static void printDataImpl(std::ostream& os, const MainHeader& header, const std:
             for(size_t c = 0; c < dimensions[0]; ++c)
             {
                 size_t i = strides[0]*c + strides[1]*r + strides[2]*s;
-                os << std::setw(12) << data[i];
+                if constexpr (sizeof(T) == 1)
+                {
+                    os << std::setw(12) << static_cast<int>(data[i]); //Not as characters
+                }
+                else
+                {
+                    os << std::setw(12) << data[i];
+                }
             }
             os << '\n';
         }
@@ -108,8 +134,25 @@ void printHeader(std::ostream& os, const MainHeader& header)
     printNum(os, "Avg density", header.avg);
     printNum(os, "Space group number", header.ispg);
     printNum(os, "Extended header length", header.extHeaderLen);
+    printNum(os, "Creator ID", header.creatorId);
     printEnum(os, "Extended header type", header.extHeaderType);
     printNum(os, "Version", header.version);
+    printNum(os, "Integers per section", header.nInt);
+    printNum(os, "Reals per section", header.nReal);
+    printNum(os, "IMOD stamp", header.imodStamp);
+    printNum(os, "IMOD flags", header.imodFlags);
+    printNum(os, "Data type", header.dataType);
+    printNum(os, "Lens", header.lens);
+    printNum(os, "Data count #1", header.dataCounts[0]);
+    printNum(os, "Data count #2", header.dataCounts[1]);
+    printNum(os, "Data value #1", header.dataValues[0]);
+    printNum(os, "Data value #2", header.dataValues[1]);
+    printNum(os, "X original tilt", header.originalTilt[0]);
+    printNum(os, "Y original tilt", header.originalTilt[1]);
+    printNum(os, "Z original tilt", header.originalTilt[2]);
+    printNum(os, "X current tilt", header.currentTilt[0]);
+    printNum(os, "Y current tilt", header.currentTilt[1]);
+    printNum(os, "Z current tilt", header.currentTilt[2]);
     printNum(os, "X origin", header.origin[0]);
     printNum(os, "Y origin", header.origin[1]);
     printNum(os, "Z origin", header.origin[2]);
@@ -135,4 +178,115 @@ void printData(std::ostream& os, const MainHeader& header, const DataBlock& data
     );
 }
 
+void printHeaders(std::ostream& os, const MainHeader& header, const std::string& extHeader)
+{
+    os << "==================== HEADER ====================\n";
+    printHeader(os, header);
+    os << "================ EXTENDED HEADER ===============\n";
+    os << extHeader << '\n';
+}
+
+void printAll(std::ostream& os, const MainHeader& header, const std::string& extHeader, const DataBlock& data)
+{
+    printHeaders(os, header, extHeader);
+    os << "================== DATA BLOCK ==================\n";
+    printData(os, header, data);
+}
+
+void printChecksum(std::ostream& os, const Checksum& checksum)
+{
+    printHash(os, "Header hash", checksum.header);
+    printHash(os, "Extended header hash", checksum.extHeader);
+    printHash(os, "Data hash", checksum.data);
+    printNum(os, "Data size", checksum.dataSize);
+    printHash(os, "Checksum", checksum.total);
+}
+
+void printStatistics(std::ostream& os, const Statistics& statistics)
+{
+    printNum(os, "Voxel count", statistics.count);
+    printNum(os, "Minimum", statistics.min);
+    printNum(os, "Maximum", statistics.max);
+    printNum(os, "Mean", getMean(statistics));
+    printNum(os, "RMS deviation", getRms(statistics));
+}
+
+void printSectionStatistics(std::ostream& os, size_t section, const Statistics& statistics)
+{
+    os << std::dec << "Section " << section;
+    os << ": min " << statistics.min << ", max " << statistics.max;
+    os << ", mean " << getMean(statistics) << ", rms " << getRms(statistics) << '\n';
+}
+
+void printFollowState(std::ostream& os, const FollowState& state)
+{
+    printNum(os, "Sections", state.sectionCount);
+    printStatistics(os, state.statistics);
+    printNum(os, "Data size", state.sectionCount * getSectionSize(state.header));
+    printHash(os, "Data hash", getFollowDataHash(state));
+}
+
+void printValidation(std::ostream& os, Validity validity, const std::vector<const ValidationRule*>& issues)
+{
+    printText(os, "Validity", toString(validity));
+    for(const auto* rule : issues)
+    {
+        printName(os, rule->name);
+        os << rule->message << " (" << toString(rule->severity) << ")\n";
+    }
+}
+
+void printInspection(std::ostream& os, const Inspection& inspection)
+{
+    std::tm time;
+    gmtime_r(&inspection.time, &time);
+    os << std::dec << std::put_time(&time, "%Y-%m-%dT%H:%M:%SZ") << " path=" << inspection.path;
+    if(inspection.valid)
+    {
+        const auto& header = inspection.header;
+        const auto& statistics = inspection.statistics;
+        os << " status=" << (inspection.validity == Validity::valid ? "ok" : "suspicious");
+        for(size_t i = 0; i < inspection.issues.size(); ++i)
+        {
+            os << (i ? "," : " issues=") << inspection.issues[i]->name;
+        }
+        os << " dims=" << header.dimensions[0] << 'x' << header.dimensions[1] << 'x' << header.dimensions[2];
+        os << " mode=" << static_cast<int>(header.mode);
+        os << " min=" << statistics.min << " max=" << statistics.max;
+        os << " mean=" << getMean(statistics) << " rms=" << getRms(statistics);
+    }
+    else
+    {
+        os << " status=invalid error=\"" << inspection.error << '"';
+    }
+    os << " latency_ms=" << inspection.latency * 1e3;
+}
+
+void printHeaderDifferences(std::ostream& os, const std::vector<HeaderDifference>& differences)
+{
+    for(const auto& difference : differences)
+    {
+        printName(os, difference.field);
+        os << difference.lhs << " != " << difference.rhs << '\n';
+    }
+}
+
+void printDataDifference(std::ostream& os, const DataDifference& difference)
+{
+    printNum(os, "Compared voxels", difference.count);
+    printNum(os, "Mismatching voxels", difference.mismatchCount);
+    printNum(os, "Max error", difference.maxError);
+    printNum(os, "RMS error", difference.rmsError);
+    for(const auto& mismatch : difference.mismatches)
+    {
+        const auto& position = mismatch.position;
+        os << std::setw(24) << "Mismatch" << ": (" << std::dec;
+        os << position[0] << ", " << position[1] << ", " << position[2] << ") ";
+        printValue(os, mismatch.lhs);
+        os << " != ";
+        printValue(os, mismatch.rhs);
+        os << '\n';
+    }
+}
+
 }
\ No newline at end of file
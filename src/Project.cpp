@@ -0,0 +1,227 @@
+#include <Project.h>
+
+#include <Read.h>
+#include <Write.h>
+#include <Numeric.h>
+#include <Parallel.h>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr size_t BAND_SIZE = 1 << 14; ///< Elements per parallel task
+
+/** STATIC FUNCTIONS **/
+
+/**
+ * @brief Number of lines of lineSize elements in each band, so that a band
+ * holds about BAND_SIZE elements
+ */
+static size_t getBandLines(size_t lineSize)
+{
+    return std::max<size_t>(BAND_SIZE / std::max<size_t>(lineSize, 1), 1);
+}
+
+struct SumReduction
+{
+    static constexpr float64 identity = 0.0;
+    static float64 apply(float64 acc, float64 value) { return acc + value; }
+};
+
+struct MaxReduction
+{
+    static constexpr float64 identity = -std::numeric_limits<float64>::infinity();
+    static float64 apply(float64 acc, float64 value) { return std::max(acc, value); }
+};
+
+template<typename R, typename T>
+static void reduceElementWise(const T* values, float64* acc, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        acc[i] = R::apply(acc[i], toFloat64(values[i]));
+    }
+}
+
+template<typename R, typename T>
+static float64 reduceRow(const T* values, size_t count)
+{
+    auto result = R::identity;
+    for(size_t i = 0; i < count; ++i)
+    {
+        result = R::apply(result, toFloat64(values[i]));
+    }
+    return result;
+}
+
+template<typename R, typename T>
+static void projectSection( const std::vector<T>& section, 
+                            size_t index,
+                            const MainHeader& header,
+                            const ProjectionOptions& options,
+                            std::vector<float64>& acc )
+{
+    const size_t nColumns = header.dimensions[0];
+    const size_t nRows = header.dimensions[1];
+
+    switch (options.axis)
+    {
+    case AxisMapping::x:
+    {
+        //Each row reduces to a single value of the index-th projection row
+        const auto bandRows = getBandLines(nColumns);
+        parallelFor(
+            (nRows + bandRows - 1) / bandRows, options.threadCount,
+            [&section, &acc, index, nColumns, nRows, bandRows] (size_t band)
+            {
+                const auto end = std::min((band+1)*bandRows, nRows);
+                for(size_t r = band*bandRows; r < end; ++r)
+                {
+                    acc[index*nRows + r] = reduceRow<R>(section.data() + r*nColumns, nColumns);
+                }
+            }
+        );
+        break;
+    }
+
+    case AxisMapping::y:
+    {
+        //All rows accumulate into the index-th projection row. Split by column bands,
+        //one per thread as every band already spans all the rows
+        const auto threadCount = std::max<size_t>(options.threadCount, 1);
+        const auto bandColumns = std::max<size_t>((nColumns + threadCount - 1) / threadCount, 1);
+        parallelFor(
+            (nColumns + bandColumns - 1) / bandColumns, threadCount,
+            [&section, &acc, index, nColumns, nRows, bandColumns] (size_t band)
+            {
+                const auto begin = band*bandColumns;
+                const auto count = std::min(begin + bandColumns, nColumns) - begin;
+                auto* row = acc.data() + index*nColumns + begin;
+                std::fill(row, row + count, R::identity);
+                for(size_t r = 0; r < nRows; ++r)
+                {
+                    reduceElementWise<R>(section.data() + r*nColumns + begin, row, count);
+                }
+            }
+        );
+        break;
+    }
+
+    default:
+        //The section accumulates element-wise into the projection. Split by element bands
+        parallelFor(
+            (section.size() + BAND_SIZE - 1) / BAND_SIZE, options.threadCount,
+            [&section, &acc] (size_t band)
+            {
+                const auto begin = band*BAND_SIZE;
+                const auto count = std::min(begin + BAND_SIZE, section.size()) - begin;
+                reduceElementWise<R>(section.data() + begin, acc.data() + begin, count);
+            }
+        );
+        break;
+    }
+}
+
+template<typename R>
+static size_t projectDataImpl(  std::istream& is, 
+                                const MainHeader& header, 
+                                const ProjectionOptions& options,
+                                std::vector<float64>& acc )
+{
+    const auto dimensions = getProjectionDimensions(header, options.axis);
+    acc.assign(dimensions[0]*dimensions[1], R::identity);
+
+    DataBlock section;
+    const size_t nSections = header.dimensions[2];
+    for(size_t s = 0; s < nSections; ++s)
+    {
+        if(readSections(is, header, 1, section) != getSectionSize(header))
+        {
+            return s; //Truncated
+        }
+
+        std::visit(
+            [s, &header, &options, &acc] (const auto& values)
+            {
+                projectSection<R>(values, s, header, options, acc);
+            },
+            section
+        );
+    }
+
+    return nSections;
+}
+
+/** PUBLIC FUNCTIONS **/
+
+std::array<size_t, 2> getProjectionDimensions(const MainHeader& header, AxisMapping axis)
+{
+    switch (axis)
+    {
+    case AxisMapping::x:    return { header.dimensions[1], header.dimensions[2] };
+    case AxisMapping::y:    return { header.dimensions[0], header.dimensions[2] };
+    default:                return { header.dimensions[0], header.dimensions[1] };
+    }
+}
+
+MainHeader makeProjectionHeader(const MainHeader& header, const ProjectionOptions& options)
+{
+    //Keep the sampling and cell size of the projected plane. The collapsed
+    //axis is a single voxel of its size, and the result is stored as x, y, z
+    const auto axis = static_cast<size_t>(options.axis) - 1;
+    const std::array<size_t, 2> axes = 
+        axis == 0 ? std::array<size_t, 2>{1, 2} :
+        axis == 1 ? std::array<size_t, 2>{0, 2} :
+                    std::array<size_t, 2>{0, 1} ;
+
+    auto result = header;
+    result.mode = Mode::float32;
+    clearExtendedHeader(result);
+    clearUnusedFields(result);
+    for(size_t i = 0; i < 2; ++i)
+    {
+        result.dimensions[i] = header.dimensions[axes[i]];
+        result.start[i] = header.start[axes[i]];
+        result.sampling[i] = header.sampling[axes[i]];
+        result.cellDimensions[i] = header.cellDimensions[axes[i]];
+    }
+    result.dimensions[2] = 1;
+    result.start[2] = 0;
+    result.sampling[2] = 1;
+    result.cellDimensions[2] = header.sampling[axis] ? header.cellDimensions[axis] / header.sampling[axis] : 1.0f;
+    result.axisMapping = { AxisMapping::x, AxisMapping::y, AxisMapping::z };
+    appendLabel(result, std::string("mrcinspector: projected along ") + std::string(toString(options.axis)));
+    return result;
+}
+
+size_t projectData( std::istream& is, 
+                    const MainHeader& header, 
+                    const ProjectionOptions& options,
+                    std::vector<float32>& projection )
+{
+    std::vector<float64> acc;
+    size_t result;
+    switch (options.type)
+    {
+    case ProjectionType::max:   result = projectDataImpl<MaxReduction>(is, header, options, acc); break;
+    default:                    result = projectDataImpl<SumReduction>(is, header, options, acc); break;
+    }
+
+    //Convert the accumulator
+    const size_t axisSize = header.dimensions[static_cast<size_t>(options.axis) - 1];
+    const auto scale = (options.type == ProjectionType::mean && axisSize) ? 1.0 / axisSize : 1.0;
+    projection.resize(acc.size());
+    for(size_t i = 0; i < acc.size(); ++i)
+    {
+        projection[i] = static_cast<float32>(acc[i] * scale);
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,235 @@
+#include <Pyramid.h>
+
+#include <Read.h>
+#include <Write.h>
+#include <Bin.h>
+#include <ByteSwap.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr std::string_view PYRAMID_MAGIC = "MRCP";
+static constexpr uint32 PYRAMID_VERSION = 1;
+static constexpr size_t PYRAMID_ALIGNMENT = 4096;
+static constexpr size_t PYRAMID_ENTRY_SIZE = 16;
+
+/** STATIC FUNCTIONS **/
+
+static size_t divideCeil(size_t num, size_t den)
+{
+    return (num + den - 1) / den;
+}
+
+template<typename T>
+static void storeLittleEndian(std::vector<char>& buffer, size_t offset, T value)
+{
+    makeLittleEndian(value);
+    std::memcpy(buffer.data() + offset, &value, sizeof(value));
+}
+
+template<typename T>
+static T loadLittleEndian(const std::vector<char>& buffer, size_t offset)
+{
+    T value;
+    std::memcpy(&value, buffer.data() + offset, sizeof(value));
+    makeLittleEndian(value);
+    return value;
+}
+
+/** PUBLIC FUNCTIONS **/
+
+std::string getPyramidPath(const char* path)
+{
+    return std::string(path) + ".pyramid";
+}
+
+std::vector<size_t> getPyramidFactors(size_t levelCount)
+{
+    std::vector<size_t> result(levelCount);
+    for(size_t i = 0; i < levelCount; ++i)
+    {
+        result[i] = size_t(2) << i;
+    }
+    return result;
+}
+
+float64 getVoxelSize(const MainHeader& header)
+{
+    float64 result = 0.0;
+    for(size_t i = 0; i < 3; ++i)
+    {
+        const auto size = (header.sampling[i] > 0 && header.cellDimensions[i] > 0) ?
+                          static_cast<float64>(header.cellDimensions[i]) / header.sampling[i] :
+                          1.0;
+        result = std::max(result, size);
+    }
+    return result;
+}
+
+size_t buildPyramid(std::istream& is,
+                    const MainHeader& header,
+                    const std::vector<size_t>& factors,
+                    const FileStamp& source,
+                    std::ostream& os,
+                    size_t threadCount )
+{
+    if(PYRAMID_HEADER_SIZE < 32 + factors.size()*PYRAMID_ENTRY_SIZE)
+    {
+        return 0; //Too many levels
+    }
+
+    //Lay out the levels
+    std::vector<PyramidLevel> levels;
+    uint64 offset = PYRAMID_HEADER_SIZE;
+    for(const auto factor : factors)
+    {
+        const auto levelHeader = makeBinnedHeader(header, factor);
+        levels.push_back(PyramidLevel{factor, offset, levelHeader});
+        offset += divideCeil(sizeof(MainHeader) + getDataSize(levelHeader), PYRAMID_ALIGNMENT) * PYRAMID_ALIGNMENT;
+    }
+
+    //Table
+    std::vector<char> buffer(PYRAMID_HEADER_SIZE, 0);
+    std::copy(PYRAMID_MAGIC.cbegin(), PYRAMID_MAGIC.cend(), buffer.begin());
+    storeLittleEndian<uint32>(buffer, 4, PYRAMID_VERSION);
+    storeLittleEndian<uint32>(buffer, 8, levels.size());
+    storeLittleEndian<uint64>(buffer, 16, source.size);
+    storeLittleEndian<int64>(buffer, 24, source.modificationTime);
+    for(size_t i = 0; i < levels.size(); ++i)
+    {
+        storeLittleEndian<uint64>(buffer, 32 + i*PYRAMID_ENTRY_SIZE, levels[i].factor);
+        storeLittleEndian<uint64>(buffer, 40 + i*PYRAMID_ENTRY_SIZE, levels[i].offset);
+    }
+    os.write(buffer.data(), buffer.size());
+
+    //Bin all levels at once, writing each binned section at its level
+    std::vector<uint64> positions;
+    for(const auto& level : levels)
+    {
+        positions.push_back(level.offset + sizeof(MainHeader));
+    }
+    std::vector<Statistics> statistics(levels.size(), makeStatistics());
+    const auto result = binDataLevels(
+        is, header, factors, threadCount,
+        [&os, &positions] (size_t level, const DataBlock& binned)
+        {
+            os.seekp(positions[level]);
+            const auto written = writeData(os, binned);
+            positions[level] += written;
+            return written > 0;
+        },
+        statistics
+    );
+
+    //Without all sections, leave the levels without a valid header, so
+    //that a pyramid left behind is never served
+    if(result != header.dimensions[2])
+    {
+        return result;
+    }
+
+    //Write the level headers with their statistics. Pad the last level
+    for(size_t i = 0; i < levels.size(); ++i)
+    {
+        updateHeaderStatistics(levels[i].header, statistics[i]);
+        os.seekp(levels[i].offset);
+        writeMainHeader(os, levels[i].header);
+    }
+    if(!levels.empty() && positions.back() < offset)
+    {
+        os.seekp(offset - 1);
+        os.put(0);
+    }
+
+    return os.good() ? result : 0;
+}
+
+bool readPyramid(std::istream& is, Pyramid& pyramid)
+{
+    std::vector<char> buffer(PYRAMID_HEADER_SIZE);
+    is.read(buffer.data(), buffer.size());
+    if( !is.good() ||
+        std::string_view(buffer.data(), PYRAMID_MAGIC.size()) != PYRAMID_MAGIC ||
+        loadLittleEndian<uint32>(buffer, 4) != PYRAMID_VERSION )
+    {
+        return false;
+    }
+
+    const size_t levelCount = loadLittleEndian<uint32>(buffer, 8);
+    if(PYRAMID_HEADER_SIZE < 32 + levelCount*PYRAMID_ENTRY_SIZE)
+    {
+        return false;
+    }
+    pyramid.source.size = loadLittleEndian<uint64>(buffer, 16);
+    pyramid.source.modificationTime = loadLittleEndian<int64>(buffer, 24);
+    pyramid.levels.resize(levelCount);
+    for(size_t i = 0; i < levelCount; ++i)
+    {
+        auto& level = pyramid.levels[i];
+        level.factor = loadLittleEndian<uint64>(buffer, 32 + i*PYRAMID_ENTRY_SIZE);
+        level.offset = loadLittleEndian<uint64>(buffer, 40 + i*PYRAMID_ENTRY_SIZE);
+        is.seekg(level.offset);
+        if(readMainHeader(is, level.header) != sizeof(MainHeader))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool isPyramidValid(const Pyramid& pyramid, const MainHeader& header, const FileStamp& source)
+{
+    if(pyramid.source.size != source.size || pyramid.source.modificationTime != source.modificationTime)
+    {
+        return false;
+    }
+
+    for(const auto& level : pyramid.levels)
+    {
+        for(size_t i = 0; i < 3; ++i)
+        {
+            if(level.factor == 0 || level.header.dimensions[i] != divideCeil(header.dimensions[i], level.factor))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t selectPyramidLevel(const Pyramid& pyramid, const MainHeader& header, float64 resolution)
+{
+    constexpr float64 TOLERANCE = 1e-6;
+    const auto voxelSize = getVoxelSize(header);
+
+    size_t result = pyramid.levels.size();
+    size_t coarsest = 1;
+    for(size_t i = 0; i < pyramid.levels.size(); ++i)
+    {
+        const auto& level = pyramid.levels[i];
+        if(level.factor > coarsest && voxelSize*level.factor <= resolution * (1.0 + TOLERANCE))
+        {
+            coarsest = level.factor;
+            result = i;
+        }
+    }
+
+    return result;
+}
+
+size_t readPyramidLevel(std::istream& is, const PyramidLevel& level, DataBlock& data)
+{
+    is.clear();
+    is.seekg(level.offset + sizeof(MainHeader) + level.header.extHeaderLen);
+    return readData(is, level.header, data);
+}
+
+}
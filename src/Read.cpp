@@ -1,176 +1,374 @@
 #include <Read.h>
 
+#include <ByteSwap.h>
+#include <Packed.h>
+#include <Validate.h>
+
 #include <array>
 #include <algorithm>
 #include <numeric>
 #include <type_traits>
 #include <cstring>
 #include <cassert>
+#include <cmath>
 
 namespace MrcInspector
 {
 
+/** STATIC CONSTANTS **/
+
+static constexpr size_t BYTE_ORDER_SAMPLE_SIZE = 4096;
+static constexpr size_t PACKED_CHUNK_SIZE = 1 << 16;
+static constexpr size_t UNSIZED_READ_STEP = 64 << 20;
+static constexpr float64 MIN_PLAUSIBLE_MAGNITUDE = 1e-20;
+static constexpr float64 MAX_PLAUSIBLE_MAGNITUDE = 1e20;
+
 /** STATIC FUNCTIONS **/
 
-template<typename T>
-static void swapEndianess(T& value)
+/**
+ * @brief Returns true if the stream can seek. Its size is then known, and
+ * validation has checked the header against it
+ */
+static bool hasKnownSize(std::istream& is)
+{
+    return is.tellg() != std::istream::pos_type(-1);
+}
+
+/**
+ * @brief Reads nBytes into data, resizing it to hold them. When the size of 
+ * the stream is not known, the header can not be checked against it, so the
+ * storage grows in step with the bytes received instead of being allocated
+ * upfront. Returns true if all of them were read
+ */
+template <typename T>
+static bool readGrowing(std::istream& is, size_t nBytes, std::vector<T>& data)
 {
-    static_assert(std::is_scalar<T>::value, "Type must be a scalar type");
+    if(hasKnownSize(is))
+    {
+        data.resize(nBytes / sizeof(T));
+        is.read(reinterpret_cast<char*>(data.data()), nBytes);
+        return is.good();
+    }
 
-    //Swap its endianess in place (reverse bytes)
-    auto* first = reinterpret_cast<std::byte*>(&value);
-    auto* last = first + sizeof(T);
-    std::reverse(first, last);
+    size_t received = 0;
+    while(received < nBytes)
+    {
+        const auto size = std::min(nBytes, std::max(2*received, UNSIZED_READ_STEP / sizeof(T) * sizeof(T)));
+        data.resize(size / sizeof(T));
+        is.read(reinterpret_cast<char*>(data.data()) + received, size - received);
+        if(!is.good())
+        {
+            return false;
+        }
+        received = size;
+    }
+    data.resize(nBytes / sizeof(T));
+    return true;
 }
 
-template<typename T>
-static void swapEndianess(std::complex<T>& value)
+template <typename T>
+static size_t readDataImpl(std::istream& is, const MainHeader& header, size_t nElements, std::vector<T>& data)
 {
-    //Swap the endianess for each of the components
-    swapEndianess(reinterpret_cast<T*>(&value)[0]);
-    swapEndianess(reinterpret_cast<T*>(&value)[1]);
+    //Check that the requested type matches the type provided by the header
+    if constexpr (std::is_same<T, uint8>::value)
+    {
+        assert(hasUnsignedBytes(header));
+    }
+    else
+    {
+        assert(header.mode == DataTypeMode<T>::value);
+    }
+
+    //Obtain the size of the read
+    const auto nBytes = nElements * sizeof(T);
+
+    //Read from disk
+    size_t result = 0;
+    const auto success = readGrowing(is, nBytes, data);
+    if constexpr (sizeof(T) == 1)
+    {
+        //Bytes have no byte order to match
+        result = success ? nBytes : 0;
+    }
+    else if(success)
+    {
+        //Match the endianess. Native data is left untouched
+        const auto endianess = getModeEndianess(header.byteOrder, header.mode);
+        if(endianess == Endianess::be || endianess == Endianess::le)
+        {
+            if(needsSwap(endianess))
+            {
+                const auto wordSize = getModeWordSize(header.mode);
+                swapEndianess(reinterpret_cast<std::byte*>(data.data()), nBytes / wordSize, wordSize);
+            }
+            result = nBytes;
+        }
+    }
+    
+    return result;
 }
 
-static void swapEndianess(half_float::half& value)
+template <typename T>
+static size_t readDataImpl(std::istream& is, const MainHeader& header, size_t nElements, DataBlock& data)
 {
-    swapEndianess(reinterpret_cast<uint16&>(value));
+    //Reuse the storage when reading repeatedly (streaming)
+    if(!std::holds_alternative<std::vector<T>>(data))
+    {
+        data.emplace<std::vector<T>>();
+    }
+    return readDataImpl(is, header, nElements, std::get<std::vector<T>>(data));
 }
 
-template<typename T>
-static void makeBigEndian(T& value)
+/**
+ * @brief Reads rows of a packed mode a few at a time into a small buffer, and
+ * expands them into the data block while they are still in cache
+ */
+static size_t readPackedImpl(std::istream& is, const MainHeader& header, size_t count, DataBlock& data)
 {
-    #if BYTE_ORDER == LITTLE_ENDIAN
-        swapEndianess(value);
-    #else
-        (void)value; //No-op
-    #endif
+    if(!std::holds_alternative<std::vector<uint8>>(data))
+    {
+        data.emplace<std::vector<uint8>>();
+    }
+    auto& values = std::get<std::vector<uint8>>(data);
+
+    const size_t nColumns = header.dimensions[0];
+    const auto nRows = count * header.dimensions[1];
+    const auto rowSize = getRowSize(header);
+    const auto chunkRows = std::max<size_t>(PACKED_CHUNK_SIZE / std::max<size_t>(rowSize, 1), 1);
+    const auto knownSize = hasKnownSize(is);
+    values.resize(knownSize ? nRows * nColumns : 0);
+    std::vector<uint8> packed(std::min(chunkRows, nRows) * rowSize);
+
+    size_t result = 0;
+    for(size_t r = 0; r < nRows; r += chunkRows)
+    {
+        const auto rows = std::min(chunkRows, nRows - r);
+        is.read(reinterpret_cast<char*>(packed.data()), rows*rowSize);
+        if(!is.good())
+        {
+            return 0;
+        }
+        else if(!knownSize && values.size() < (r + rows)*nColumns)
+        {
+            //Grow in step with the bytes received, see readGrowing
+            values.resize(std::min(nRows*nColumns, std::max(2*values.size(), (r + rows)*nColumns)));
+        }
+        unpackRows(packed.data(), nColumns, rows, values.data() + r*nColumns);
+        result += rows*rowSize;
+    }
+
+    return result;
 }
 
-template<typename T>
-static void makeLittleEndian(T& value)
+static Endianess makeByteOrder(Endianess end)
+{
+    return end == Endianess::be ? Endianess::be_be_be_be : Endianess::le_le_le_le;
+}
+
+/**
+ * @brief Fills the byte order of chars and complex values of a stamp that only
+ * gives the one of integers and floats
+ */
+static Endianess completeByteOrder(Endianess end)
 {
-    #if BYTE_ORDER == BIG_ENDIAN
-        swapEndianess(value);
-    #else
-        (void)value; //No-op
-    #endif
+    const auto integer = static_cast<Word>(getIntEndianess(end));
+    const auto floating = static_cast<Word>(getFloatEndianess(end));
+    return static_cast<Endianess>((floating << 28) | (floating << 24) | (integer << 20) | (integer << 16));
+}
+
+/**
+ * @brief Returns how many rules the header fails when decoded with the given
+ * byte order, corrupting ones weighting more
+ */
+static size_t getHeaderImplausibility(MainHeader header, Endianess end)
+{
+    transformMainHeader(header, getMakeEndianFunc<uint32>(end), getMakeEndianFunc<float32>(end));
+
+    std::vector<const ValidationRule*> issues;
+    validateHeader(header, ValidationContext{ 0 }, &issues);
+    size_t result = 0;
+    for(const auto* rule : issues)
+    {
+        result += rule->severity == Validity::corrupt ? 4 : 1;
+    }
+    return result;
 }
 
+/**
+ * @brief Fraction of non-finite values or values of an implausible magnitude
+ */
 template<typename T>
-using MakeEndianFunc = void (*)(T&);
+static float64 getInvalidFraction(const std::byte* sample, size_t count, Endianess end)
+{
+    const auto makeEndianFunc = getMakeEndianFunc<T>(end);
+    size_t invalid = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+        T value;
+        std::memcpy(&value, sample + i*sizeof(T), sizeof(T));
+        makeEndianFunc(value);
+        const auto magnitude = std::abs(static_cast<float64>(value));
+        invalid += !std::isfinite(magnitude) || (magnitude != 0.0 && (magnitude < MIN_PLAUSIBLE_MAGNITUDE || magnitude > MAX_PLAUSIBLE_MAGNITUDE));
+    }
+    return count ? static_cast<float64>(invalid) / count : 0.0;
+}
 
+/**
+ * @brief Mean absolute difference between neighbouring values, which is
+ * much larger when the bytes of smooth data are swapped
+ */
 template<typename T>
-static MakeEndianFunc<T> getMakeEndianFunc(Endianess endianess)
+static float64 getRoughness(const std::byte* sample, size_t count, size_t stride, Endianess end)
 {
-    switch (endianess)
+    const auto makeEndianFunc = getMakeEndianFunc<T>(end);
+    float64 sum = 0.0;
+    T previous = 0;
+    for(size_t i = 0; i < count; i += stride)
     {
-    case Endianess::be: return makeBigEndian<T>;
-    case Endianess::le: return makeLittleEndian<T>;
-    default:            return nullptr;
+        T value;
+        std::memcpy(&value, sample + i*sizeof(T), sizeof(T));
+        makeEndianFunc(value);
+        sum += i ? std::abs(static_cast<float64>(value) - static_cast<float64>(previous)) : 0.0;
+        previous = value;
     }
+    return count > stride ? sum / (count / stride) : 0.0;
 }
 
-template <typename T>
-static size_t readDataImpl(std::istream& is, const MainHeader& header, std::vector<T>& data)
+/**
+ * @brief Reads a sample of the data block assuming the byte order and scores
+ * how implausible its values are. The position of the stream is restored
+ */
+static float64 getSampleImplausibility(std::istream& is, MainHeader header, Endianess end)
 {
-    //Check that the requested type matches the type provided by the header
-    assert(header.mode == DataTypeMode<T>::value);
-    
-    //Obtain the size of the volume
-    const auto nElements = std::accumulate(
-        header.dimensions.cbegin(), header.dimensions.cend(),
-        1U, std::multiplies<>()
-    );
-    const auto nBytes = nElements * sizeof(T);
-    data.resize(nElements);
+    transformMainHeader(header, getMakeEndianFunc<uint32>(end), getMakeEndianFunc<float32>(end));
+    const auto wordSize = getModeWordSize(header.mode);
+    const auto position = is.tellg();
+    if(wordSize == 0 || position == std::istream::pos_type(-1))
+    {
+        return 0.0;
+    }
 
-    //Read from disk
-    size_t result = 0;
-    is.read(reinterpret_cast<char*>(data.data()), nBytes);
-    if(is.good())
+    std::array<std::byte, BYTE_ORDER_SAMPLE_SIZE> sample;
+    size_t size = 0;
+    if(is.seekg(header.extHeaderLen, std::ios_base::cur))
     {
-        //Match the endianess
-        const auto makeEndianessFunc = getMakeEndianFunc<T>(getModeEndianess(header.byteOrder, DataTypeMode<T>::value));
-        if(makeEndianessFunc)
-        {
-            std::for_each(
-                data.begin(), data.end(),
-                makeEndianessFunc
-            );
-            result = nBytes;
-        }
+        is.read(reinterpret_cast<char*>(sample.data()), std::min(sample.size(), getDataSize(header)));
+        size = static_cast<size_t>(is.gcount());
+    }
+    is.clear();
+    is.seekg(position);
+
+    const auto count = size / wordSize;
+    const auto stride = getModeSize(header.mode) / wordSize; //Compares the same component of complex values
+    switch (header.mode)
+    {
+    case Mode::sint16:
+    case Mode::cint16:      return getRoughness<int16>(sample.data(), count, stride, end);
+    case Mode::uint16:      return getRoughness<uint16>(sample.data(), count, stride, end);
+    case Mode::float32:
+    case Mode::cfloat32:    return getInvalidFraction<float32>(sample.data(), count, end);
+    case Mode::float16:     return getInvalidFraction<float16>(sample.data(), count, end);
+    default:                return 0.0;
     }
-    
-    return result;
 }
 
-template <typename T>
-static size_t readDataImpl(std::istream& is, const MainHeader& header, DataBlock& data)
+static bool decodeMainHeaderImpl(MainHeader& header, std::istream* is)
 {
-    data.emplace<std::vector<T>>();
-    return readDataImpl(is, header, std::get<std::vector<T>>(data));
+    //Endianess and exttype is always stored as BE. Ensure it is correctly stored
+    makeBigEndian(header.byteOrder);
+    makeBigEndian(header.extHeaderType);
+
+    //Legacy writers leave the stamp empty, partial or garbage
+    if(!isValidByteOrder(header.byteOrder))
+    {
+        const auto valid = isValidEndianess(getIntEndianess(header.byteOrder)) && isValidEndianess(getFloatEndianess(header.byteOrder));
+        header.byteOrder = valid ? completeByteOrder(header.byteOrder) : detectByteOrder(header, is);
+    }
+
+    //Get the functions for ensuring endinaness
+    const auto makeEndianFuncInt = getMakeEndianFunc<uint32>(getIntEndianess(header.byteOrder));
+    const auto makeEndianFuncFlt = getMakeEndianFunc<float32>(getFloatEndianess(header.byteOrder));
+
+    //Match the endianess
+    bool result = false;
+    if(makeEndianFuncInt && makeEndianFuncFlt)
+    {
+        transformMainHeader(header, makeEndianFuncInt, makeEndianFuncFlt);
+        convertImod4BitBytes(header);
+        result = true;
+    }
+
+    return result;
 }
 
 /** PUBLIC FUNCTIONS **/
 
+Compression detectCompression(std::istream& is)
+{
+    //Read the magic bytes and go back
+    std::array<uint8, 4> magic = {};
+    const auto position = is.tellg();
+    is.read(reinterpret_cast<char*>(magic.data()), magic.size());
+    const auto count = is.gcount();
+    is.clear();
+    is.seekg(position);
+
+    Compression result = Compression::none;
+    if(count >= 2 && magic[0] == 0x1F && magic[1] == 0x8B)
+    {
+        result = Compression::gzip;
+    }
+    else if(count >= 3 && magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h')
+    {
+        result = Compression::bzip2;
+    }
+    else if(count >= 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD)
+    {
+        result = Compression::zstd;
+    }
+    else if(count >= 4 && magic[0] == 'M' && magic[1] == 'R' && magic[2] == 'C' && magic[3] == 'Z')
+    {
+        result = Compression::seekable;
+    }
+
+    return result;
+}
+
 size_t readMainHeader(std::istream& is, MainHeader& header)
 {
     //Read the whole file
     size_t result = 0;
     is.read(reinterpret_cast<char*>(&header), sizeof(header));
-    if(is.good())
+    if(is.good() && decodeMainHeaderImpl(header, &is))
     {
-        //Endianess and exttype is always stored as BE. Ensure it is correctly stored
-        makeBigEndian(header.byteOrder);
-        makeBigEndian(header.extHeaderType);
+        //All OK
+        result = sizeof(MainHeader);
+    }
 
-        //Get the functions for ensuring endinaness
-        const auto makeEndianFuncInt = getMakeEndianFunc<uint32>(getIntEndianess(header.byteOrder));
-        const auto makeEndianFuncFlt = getMakeEndianFunc<float32>(getFloatEndianess(header.byteOrder));
+    return result;
+}
 
-        //Match the endianess
-        if(makeEndianFuncInt && makeEndianFuncFlt)
-        {
-            //Integers
-            makeEndianFuncInt(header.dimensions[0]);
-            makeEndianFuncInt(header.dimensions[1]);
-            makeEndianFuncInt(header.dimensions[2]);
-            makeEndianFuncInt(reinterpret_cast<uint32&>(header.mode));
-            makeEndianFuncInt(header.start[0]);
-            makeEndianFuncInt(header.start[1]);
-            makeEndianFuncInt(header.start[2]);
-            makeEndianFuncInt(header.sampling[0]);
-            makeEndianFuncInt(header.sampling[1]);
-            makeEndianFuncInt(header.sampling[2]);
-            makeEndianFuncInt(reinterpret_cast<uint32&>(header.axisMapping[0]));
-            makeEndianFuncInt(reinterpret_cast<uint32&>(header.axisMapping[1]));
-            makeEndianFuncInt(reinterpret_cast<uint32&>(header.axisMapping[2]));
-            makeEndianFuncInt(header.ispg);
-            makeEndianFuncInt(header.extHeaderLen);
-            makeEndianFuncInt(header.version);
-            makeEndianFuncInt(header.nLabels);
-
-            //Floats
-            makeEndianFuncFlt(header.cellDimensions[0]);
-            makeEndianFuncFlt(header.cellDimensions[1]);
-            makeEndianFuncFlt(header.cellDimensions[2]);
-            makeEndianFuncFlt(header.cellAngles[0]);
-            makeEndianFuncFlt(header.cellAngles[1]);
-            makeEndianFuncFlt(header.cellAngles[2]);
-            makeEndianFuncFlt(header.min);
-            makeEndianFuncFlt(header.max);
-            makeEndianFuncFlt(header.avg);
-            makeEndianFuncFlt(header.origin[0]);
-            makeEndianFuncFlt(header.origin[1]);
-            makeEndianFuncFlt(header.origin[2]);
-            makeEndianFuncFlt(header.rms);
-
-            //All OK
-            result = sizeof(MainHeader);
-        }
+bool decodeMainHeader(MainHeader& header)
+{
+    return decodeMainHeaderImpl(header, nullptr);
+}
+
+Endianess detectByteOrder(const MainHeader& header, std::istream* is)
+{
+    //Fields are nearly always plausible in only one of the byte orders
+    const auto le = getHeaderImplausibility(header, Endianess::le);
+    const auto be = getHeaderImplausibility(header, Endianess::be);
+    if(le != be)
+    {
+        return makeByteOrder(le < be ? Endianess::le : Endianess::be);
     }
 
-    return result;
+    //Otherwise decide from the values of the data block
+    if(is && getSampleImplausibility(*is, header, Endianess::be) < getSampleImplausibility(*is, header, Endianess::le))
+    {
+        return Endianess::be_be_be_be;
+    }
+    return Endianess::le_le_le_le;
 }
 
 size_t readExtendedHeader(std::istream& is, const MainHeader& header, std::string& extHeader)
@@ -182,16 +380,24 @@ size_t readExtendedHeader(std::istream& is, const MainHeader& header, std::strin
 
 size_t readData(std::istream& is, const MainHeader& header, DataBlock& data)
 {
+    return readSections(is, header, header.dimensions[2], data);
+}
+
+size_t readSections(std::istream& is, const MainHeader& header, size_t count, DataBlock& data)
+{
+    const auto nElements = getSectionElementCount(header) * count;
+
     size_t result;
     switch (header.mode)
     {
-    case Mode::sint8:       result = readDataImpl<int8>(is, header, data); break;
-    case Mode::sint16:      result = readDataImpl<int16>(is, header, data); break;
-    case Mode::float32:     result = readDataImpl<float32>(is, header, data); break;
-    case Mode::cint16:      result = readDataImpl<cint32>(is, header, data); break;
-    case Mode::cfloat32:    result = readDataImpl<cfloat64>(is, header, data); break;
-    case Mode::uint16:      result = readDataImpl<uint16>(is, header, data); break;
-    case Mode::float16:     result = readDataImpl<float16>(is, header, data); break;
+    case Mode::sint8:       result = hasUnsignedBytes(header) ? readDataImpl<uint8>(is, header, nElements, data) : readDataImpl<int8>(is, header, nElements, data); break;
+    case Mode::sint16:      result = readDataImpl<int16>(is, header, nElements, data); break;
+    case Mode::float32:     result = readDataImpl<float32>(is, header, nElements, data); break;
+    case Mode::cint16:      result = readDataImpl<cint32>(is, header, nElements, data); break;
+    case Mode::cfloat32:    result = readDataImpl<cfloat64>(is, header, nElements, data); break;
+    case Mode::uint16:      result = readDataImpl<uint16>(is, header, nElements, data); break;
+    case Mode::float16:     result = readDataImpl<float16>(is, header, nElements, data); break;
+    case Mode::packed4:     result = readPackedImpl(is, header, count, data); break;
     default:                result = 0; break;
     }
 
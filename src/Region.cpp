@@ -0,0 +1,216 @@
+#include <Region.h>
+
+#include <Write.h>
+#include <ByteSwap.h>
+#include <Packed.h>
+
+#include <string>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/** STATIC FUNCTIONS **/
+
+/**
+ * @brief Moves the stream forward. Seeks if possible, reads through otherwise
+ */
+static bool skip(std::istream& is, size_t count)
+{
+    if(count > 0 && !is.seekg(count, std::ios_base::cur))
+    {
+        is.clear();
+        is.ignore(count);
+        return static_cast<size_t>(is.gcount()) == count;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Reads only the bytes of each row that hold the region, and expands
+ * only the requested values. Returns the size of the expanded region
+ */
+static size_t readPackedRegion(std::istream& is, const MainHeader& header, const Region& region, uint8* output)
+{
+    const size_t nRows = header.dimensions[1];
+    const auto rowSize = getRowSize(header);
+    const auto first = region.origin[0];
+    const auto width = region.size[0];
+    const auto byteFirst = first / 2;
+    const auto byteCount = (first + width + 1) / 2 - byteFirst;
+    std::vector<uint8> packed(byteCount);
+
+    size_t position = 0; //Relative to the start of the data block
+    for(size_t s = region.origin[2]; s < region.origin[2] + region.size[2]; ++s)
+    {
+        for(size_t r = region.origin[1]; r < region.origin[1] + region.size[1]; ++r)
+        {
+            const auto offset = (s*nRows + r)*rowSize + byteFirst;
+            if(!skip(is, offset - position))
+            {
+                return 0;
+            }
+            is.read(reinterpret_cast<char*>(packed.data()), byteCount);
+            if(static_cast<size_t>(is.gcount()) != byteCount)
+            {
+                return 0;
+            }
+            position = offset + byteCount;
+
+            unpackNibbles(packed.data(), first & 1, width, output);
+            output += width;
+        }
+    }
+
+    return region.size[0] * region.size[1] * region.size[2] * sizeof(uint8);
+}
+
+static std::byte* resizeDataBlock(DataBlock& data, size_t count)
+{
+    std::byte* result = nullptr;
+    std::visit(
+        [&result, count] (auto& values)
+        {
+            values.resize(count);
+            result = reinterpret_cast<std::byte*>(values.data());
+        },
+        data
+    );
+    return result;
+}
+
+/** PUBLIC FUNCTIONS **/
+
+bool isValidRegion(const MainHeader& header, const Region& region)
+{
+    for(size_t i = 0; i < 3; ++i)
+    {
+        if(region.size[i] == 0 || region.origin[i] + region.size[i] > header.dimensions[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+Region getSliceRegion(const MainHeader& header, AxisMapping axis, size_t index)
+{
+    Region result = {
+        { 0, 0, 0 },
+        { header.dimensions[0], header.dimensions[1], header.dimensions[2] }
+    };
+
+    const auto i = static_cast<size_t>(axis) - 1;
+    if(i < 3)
+    {
+        result.origin[i] = index;
+        result.size[i] = 1;
+    }
+    return result;
+}
+
+MainHeader makeRegionHeader(const MainHeader& header, const Region& region)
+{
+    auto result = header;
+    clearExtendedHeader(result); //Per-section metadata does not apply anymore
+    clearUnusedFields(result);
+    for(size_t i = 0; i < 3; ++i)
+    {
+        result.dimensions[i] = region.size[i];
+        result.start[i] = header.start[i] + region.origin[i];
+    }
+    appendLabel(
+        result,
+        "mrcinspector: region " +
+        std::to_string(region.origin[0]) + "," + std::to_string(region.origin[1]) + "," + std::to_string(region.origin[2]) + " " +
+        std::to_string(region.size[0]) + "x" + std::to_string(region.size[1]) + "x" + std::to_string(region.size[2])
+    );
+    return result;
+}
+
+size_t readRegion(std::istream& is, const MainHeader& header, const Region& region, DataBlock& data)
+{
+    const auto elementSize = getModeSize(header.mode);
+    const size_t nColumns = header.dimensions[0];
+    const size_t nRows = header.dimensions[1];
+    const auto count = region.size[0] * region.size[1] * region.size[2];
+    auto* output = allocateDataBlock(data, header, count);
+    if(!output || !isValidRegion(header, region))
+    {
+        return 0;
+    }
+    if(isPackedMode(header.mode))
+    {
+        return readPackedRegion(is, header, region, reinterpret_cast<uint8*>(output));
+    }
+
+    //Read runs of rows, merging the ones that are contiguous in the file
+    size_t position = 0; //Relative to the start of the data block
+    size_t runStart = 0;
+    size_t runSize = 0;
+    size_t result = 0;
+    const auto flush = [&] () -> bool
+    {
+        if(runSize > 0)
+        {
+            if(!skip(is, runStart - position))
+            {
+                return false;
+            }
+            is.read(reinterpret_cast<char*>(output + result), runSize);
+            if(static_cast<size_t>(is.gcount()) != runSize)
+            {
+                return false;
+            }
+            result += runSize;
+            position = runStart + runSize;
+            runSize = 0;
+        }
+        return true;
+    };
+
+    const auto rowSize = region.size[0] * elementSize;
+    for(size_t s = region.origin[2]; s < region.origin[2] + region.size[2]; ++s)
+    {
+        for(size_t r = region.origin[1]; r < region.origin[1] + region.size[1]; ++r)
+        {
+            const auto offset = ((s*nRows + r)*nColumns + region.origin[0]) * elementSize;
+            if(offset != runStart + runSize)
+            {
+                if(!flush())
+                {
+                    return 0;
+                }
+                runStart = offset;
+            }
+            runSize += rowSize;
+        }
+    }
+    if(!flush())
+    {
+        return 0;
+    }
+
+    //Match the endianess. Bytes have none
+    const auto wordSize = getModeWordSize(header.mode);
+    if(wordSize > 1 && needsSwap(getModeEndianess(header.byteOrder, header.mode)))
+    {
+        swapEndianess(output, result / wordSize, wordSize);
+    }
+
+    return result;
+}
+
+std::byte* allocateDataBlock(DataBlock& data, Mode mode, size_t count)
+{
+    return emplaceDataBlock(data, mode) ? resizeDataBlock(data, count) : nullptr;
+}
+
+std::byte* allocateDataBlock(DataBlock& data, const MainHeader& header, size_t count)
+{
+    return emplaceDataBlock(data, header) ? resizeDataBlock(data, count) : nullptr;
+}
+
+}
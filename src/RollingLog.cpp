@@ -0,0 +1,37 @@
+#include <RollingLog.h>
+
+#include <cstdio>
+
+namespace MrcInspector
+{
+
+/** PUBLIC FUNCTIONS **/
+
+RollingLog::RollingLog(std::string path, size_t maxSize)
+    : m_path(std::move(path))
+    , m_maxSize(maxSize)
+    , m_file(m_path, std::ios_base::out | std::ios_base::app)
+{
+    m_file.seekp(0, std::ios_base::end);
+    const auto position = m_file.tellp();
+    m_size = position > 0 ? static_cast<size_t>(position) : 0;
+}
+
+bool RollingLog::write(std::string_view line)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_maxSize > 0 && m_size > 0 && m_size + line.size() + 1 > m_maxSize)
+    {
+        m_file.close();
+        std::rename(m_path.c_str(), (m_path + ".1").c_str());
+        m_file.open(m_path, std::ios_base::out | std::ios_base::trunc);
+        m_size = 0;
+    }
+
+    m_file << line << '\n';
+    m_file.flush();
+    m_size += line.size() + 1;
+    return m_file.good();
+}
+
+}
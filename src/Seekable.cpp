@@ -0,0 +1,653 @@
+#include <Seekable.h>
+
+#include <Read.h>
+#include <Decompress.h>
+#include <ByteSwap.h>
+#include <Parallel.h>
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+#if defined(MRCINSPECTOR_WITH_ZLIB)
+    #include <zlib.h>
+#endif
+
+#if defined(MRCINSPECTOR_WITH_BZIP2)
+    #include <bzlib.h>
+#endif
+
+#if defined(MRCINSPECTOR_WITH_ZSTD)
+    #include <zstd.h>
+#endif
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr std::string_view SEEKABLE_MAGIC = "MRCZ";
+static constexpr size_t FRAME_HEADER_SIZE = 16;
+static constexpr size_t FRAMES_PER_THREAD = 4;
+static constexpr uint64 MAX_BATCH_SIZE = 64 << 20; ///< Compressed and decoded bytes held by a batch of more than one frame
+static constexpr uint64 MAX_FRAME_SIZE = uint64(1) << 32; ///< Decoded size of the largest frame, i.e. a 32768x32768 float32 section
+
+/** STATIC FUNCTIONS **/
+
+static void writeUint32(std::ostream& os, uint32 value)
+{
+    makeLittleEndian(value);
+    os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void writeUint64(std::ostream& os, uint64 value)
+{
+    makeLittleEndian(value);
+    os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<typename T>
+static T loadLittleEndian(const char* data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(value));
+    makeLittleEndian(value);
+    return value;
+}
+
+[[maybe_unused]] static unsigned clampToUInt(size_t value)
+{
+    return static_cast<unsigned>(std::min(value, static_cast<size_t>(UINT_MAX)));
+}
+
+#if defined(MRCINSPECTOR_WITH_ZLIB)
+
+static bool compressGzip(int level, const char* data, size_t size, std::vector<char>& output)
+{
+    z_stream stream = {};
+    if(deflateInit2(&stream, level, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return false;
+    }
+    output.resize(deflateBound(&stream, size));
+
+    //Feed it by pieces, as zlib counts with 32bit integers
+    size_t in = 0, out = 0;
+    int ret = Z_OK;
+    while(ret == Z_OK)
+    {
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + in));
+        stream.avail_in = clampToUInt(size - in);
+        stream.next_out = reinterpret_cast<Bytef*>(output.data() + out);
+        stream.avail_out = clampToUInt(output.size() - out);
+        const auto availIn = stream.avail_in;
+        const auto availOut = stream.avail_out;
+        ret = deflate(&stream, (in + availIn == size) ? Z_FINISH : Z_NO_FLUSH);
+        in += availIn - stream.avail_in;
+        out += availOut - stream.avail_out;
+    }
+    deflateEnd(&stream);
+
+    output.resize(out);
+    return ret == Z_STREAM_END;
+}
+
+static bool decompressGzip(const char* data, size_t size, char* output, size_t outputSize)
+{
+    z_stream stream = {};
+    if(inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+    {
+        return false;
+    }
+
+    size_t in = 0, out = 0;
+    int ret = Z_OK;
+    while(ret == Z_OK)
+    {
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + in));
+        stream.avail_in = clampToUInt(size - in);
+        stream.next_out = reinterpret_cast<Bytef*>(output + out);
+        stream.avail_out = clampToUInt(outputSize - out);
+        const auto availIn = stream.avail_in;
+        const auto availOut = stream.avail_out;
+        ret = inflate(&stream, Z_NO_FLUSH);
+        in += availIn - stream.avail_in;
+        out += availOut - stream.avail_out;
+    }
+    inflateEnd(&stream);
+
+    return ret == Z_STREAM_END && out == outputSize;
+}
+
+#endif
+
+#if defined(MRCINSPECTOR_WITH_BZIP2)
+
+static bool compressBzip2(int level, const char* data, size_t size, std::vector<char>& output)
+{
+    bz_stream stream = {};
+    if(BZ2_bzCompressInit(&stream, level, 0, 0) != BZ_OK)
+    {
+        return false;
+    }
+    output.resize(size + size / 100 + 600);
+
+    size_t in = 0, out = 0;
+    int ret = BZ_RUN_OK;
+    while(ret == BZ_RUN_OK || ret == BZ_FINISH_OK)
+    {
+        stream.next_in = const_cast<char*>(data + in);
+        stream.avail_in = clampToUInt(size - in);
+        stream.next_out = output.data() + out;
+        stream.avail_out = clampToUInt(output.size() - out);
+        const auto availIn = stream.avail_in;
+        const auto availOut = stream.avail_out;
+        ret = BZ2_bzCompress(&stream, (in + availIn == size) ? BZ_FINISH : BZ_RUN);
+        in += availIn - stream.avail_in;
+        out += availOut - stream.avail_out;
+    }
+    BZ2_bzCompressEnd(&stream);
+
+    output.resize(out);
+    return ret == BZ_STREAM_END;
+}
+
+static bool decompressBzip2(const char* data, size_t size, char* output, size_t outputSize)
+{
+    bz_stream stream = {};
+    if(BZ2_bzDecompressInit(&stream, 0, 0) != BZ_OK)
+    {
+        return false;
+    }
+
+    size_t in = 0, out = 0;
+    int ret = BZ_OK;
+    while(ret == BZ_OK)
+    {
+        stream.next_in = const_cast<char*>(data + in);
+        stream.avail_in = clampToUInt(size - in);
+        stream.next_out = output + out;
+        stream.avail_out = clampToUInt(outputSize - out);
+        const auto availIn = stream.avail_in;
+        const auto availOut = stream.avail_out;
+        ret = BZ2_bzDecompress(&stream);
+        in += availIn - stream.avail_in;
+        out += availOut - stream.avail_out;
+        if(ret == BZ_OK && availIn == stream.avail_in && availOut == stream.avail_out)
+        {
+            break; //No progress. Truncated
+        }
+    }
+    BZ2_bzDecompressEnd(&stream);
+
+    return ret == BZ_STREAM_END && out == outputSize;
+}
+
+#endif
+
+static bool compressFrame(Compression codec, int level, const char* data, size_t size, std::vector<char>& output)
+{
+    switch (codec)
+    {
+    case Compression::none:
+        output.assign(data, data + size);
+        return true;
+    #if defined(MRCINSPECTOR_WITH_ZLIB)
+        case Compression::gzip:
+            return compressGzip(level, data, size, output);
+    #endif
+    #if defined(MRCINSPECTOR_WITH_BZIP2)
+        case Compression::bzip2:
+            return compressBzip2(level, data, size, output);
+    #endif
+    #if defined(MRCINSPECTOR_WITH_ZSTD)
+        case Compression::zstd:
+        {
+            output.resize(ZSTD_compressBound(size));
+            const auto ret = ZSTD_compress(output.data(), output.size(), data, size, level);
+            output.resize(ZSTD_isError(ret) ? 0 : ret);
+            return !ZSTD_isError(ret);
+        }
+    #endif
+    default:
+        (void)level;
+        return false;
+    }
+}
+
+static bool decompressFrame(Compression codec, const std::vector<char>& frame, std::vector<char>& output)
+{
+    switch (codec)
+    {
+    case Compression::none:
+        if(frame.size() != output.size())
+        {
+            return false;
+        }
+        std::copy(frame.cbegin(), frame.cend(), output.begin());
+        return true;
+    #if defined(MRCINSPECTOR_WITH_ZLIB)
+        case Compression::gzip:
+            return decompressGzip(frame.data(), frame.size(), output.data(), output.size());
+    #endif
+    #if defined(MRCINSPECTOR_WITH_BZIP2)
+        case Compression::bzip2:
+            return decompressBzip2(frame.data(), frame.size(), output.data(), output.size());
+    #endif
+    #if defined(MRCINSPECTOR_WITH_ZSTD)
+        case Compression::zstd:
+        {
+            const auto ret = ZSTD_decompress(output.data(), output.size(), frame.data(), frame.size());
+            return !ZSTD_isError(ret) && ret == output.size();
+        }
+    #endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Reads count bytes from the stream into the buffer.
+ * Returns the amount of bytes read
+ */
+static size_t readChunk(std::istream& is, std::vector<char>& buffer, size_t count)
+{
+    buffer.resize(count);
+    is.read(buffer.data(), count);
+    buffer.resize(is.gcount());
+    return buffer.size();
+}
+
+/**
+ * @brief Compresses the given chunks in parallel and appends them to the
+ * container as frames, recording them in the index
+ */
+static bool writeFrames(std::ostream& os,
+                        const std::vector<std::vector<char>>& chunks,
+                        size_t count,
+                        Compression codec,
+                        int level,
+                        size_t threadCount,
+                        std::vector<std::vector<char>>& frames,
+                        SeekableIndex& index )
+{
+    std::vector<uint8> compressed(count, false);
+    frames.resize(std::max(frames.size(), count));
+    parallelFor(
+        count, threadCount,
+        [&chunks, &frames, &compressed, codec, level] (size_t i)
+        {
+            compressed[i] = compressFrame(codec, level, chunks[i].data(), chunks[i].size(), frames[i]);
+        }
+    );
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(!compressed[i])
+        {
+            return false;
+        }
+
+        writeUint64(os, frames[i].size());
+        writeUint64(os, chunks[i].size());
+        const auto offset = static_cast<uint64>(os.tellp());
+        os.write(frames[i].data(), frames[i].size());
+        index.frames.push_back(SeekableFrame{offset, frames[i].size(), chunks[i].size()});
+    }
+
+    return os.good();
+}
+
+/**
+ * @brief Stream buffer over the decompressed frames of a seekable container
+ */
+class SeekableStreambuf : public std::streambuf
+{
+public:
+    SeekableStreambuf(std::istream& source, SeekableIndex index, size_t threadCount)
+        : m_source(source)
+        , m_index(std::move(index))
+        , m_threadCount(std::max(threadCount, size_t(1)))
+    {
+        //Position of each frame in the decompressed file
+        m_starts.reserve(m_index.frames.size() + 1);
+        m_starts.push_back(0);
+        for(const auto& frame : m_index.frames)
+        {
+            m_starts.push_back(m_starts.back() + frame.size);
+        }
+    }
+
+protected:
+    int_type underflow() override
+    {
+        while(gptr() == egptr())
+        {
+            if(m_nextFrame >= m_index.frames.size() || !loadFrame(m_nextFrame))
+            {
+                return traits_type::eof();
+            }
+            ++m_nextFrame;
+        }
+
+        return traits_type::to_int_type(*gptr());
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+    {
+        off_type base = 0;
+        if(dir == std::ios_base::cur)
+        {
+            base = getPosition();
+        }
+        else if(dir == std::ios_base::end)
+        {
+            base = m_starts.back();
+        }
+
+        return seekpos(base + off, which);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        const auto position = static_cast<off_type>(pos);
+        if(!(which & std::ios_base::in) || position < 0 || static_cast<uint64>(position) > m_starts.back())
+        {
+            return pos_type(off_type(-1));
+        }
+        else if(static_cast<uint64>(position) == getPosition())
+        {
+            return pos; //Nothing to do. Keep the decoded frame
+        }
+
+        //Find the frame holding the position. The end is held by the last frame
+        const auto frameCount = m_index.frames.size();
+        auto frame = static_cast<size_t>(std::upper_bound(m_starts.cbegin(), m_starts.cend(), static_cast<uint64>(position)) - m_starts.cbegin()) - 1;
+        frame = std::min(frame, frameCount - 1);
+
+        //A new sequential run starts, so decode as little as possible
+        m_batchSize = 1;
+        if(!loadFrame(frame))
+        {
+            return pos_type(off_type(-1));
+        }
+        m_nextFrame = frame + 1;
+        setg(eback(), eback() + (position - m_starts[frame]), egptr());
+
+        return pos;
+    }
+
+private:
+    std::istream&                   m_source;
+    SeekableIndex                   m_index;
+    size_t                          m_threadCount;
+    std::vector<uint64>             m_starts;
+    size_t                          m_nextFrame = 0;
+    size_t                          m_batchSize = 1;
+    size_t                          m_batchFirst = 0;
+    std::vector<std::vector<char>>  m_frames;
+    std::vector<std::vector<char>>  m_outputs;
+
+    uint64 getPosition() const
+    {
+        return m_nextFrame == 0 ? 0 : m_starts[m_nextFrame - 1] + (gptr() - eback());
+    }
+
+    /**
+     * @brief Sets the get area to the decompressed frame. Decodes a new
+     * batch starting at it if it was not decoded already
+     */
+    bool loadFrame(size_t frame)
+    {
+        if(frame < m_batchFirst || frame >= m_batchFirst + m_outputs.size())
+        {
+            if(!decodeBatch(frame))
+            {
+                return false;
+            }
+        }
+
+        auto& output = m_outputs[frame - m_batchFirst];
+        setg(output.data(), output.data(), output.data() + output.size());
+        return true;
+    }
+
+    bool decodeBatch(size_t first)
+    {
+        //Take frames up to the batch size, as long as they fit in memory
+        size_t count = 0;
+        uint64 bytes = 0;
+        while(count < m_batchSize && first + count < m_index.frames.size())
+        {
+            const auto& frame = m_index.frames[first + count];
+            bytes += frame.compressedSize + frame.size;
+            if(count > 0 && bytes > MAX_BATCH_SIZE)
+            {
+                break;
+            }
+            ++count;
+        }
+
+        //Read the compressed frames sequentially
+        m_frames.resize(count);
+        m_outputs.resize(count);
+        m_source.clear();
+        m_source.seekg(m_index.frames[first].offset);
+        for(size_t i = 0; i < count; ++i)
+        {
+            const auto& frame = m_index.frames[first + i];
+            if(i > 0 && frame.offset != m_index.frames[first + i - 1].offset + m_index.frames[first + i - 1].compressedSize)
+            {
+                m_source.seekg(frame.offset);
+            }
+            if(readChunk(m_source, m_frames[i], frame.compressedSize) != frame.compressedSize)
+            {
+                m_outputs.clear();
+                return false;
+            }
+        }
+
+        //Decompress them in parallel
+        std::vector<uint8> decoded(count, false);
+        parallelFor(
+            count, m_threadCount,
+            [this, first, &decoded] (size_t i)
+            {
+                m_outputs[i].resize(m_index.frames[first + i].size);
+                decoded[i] = decompressFrame(m_index.codec, m_frames[i], m_outputs[i]);
+            }
+        );
+
+        //Keep the frames up to the first one that failed
+        const auto firstFailed = static_cast<size_t>(std::find(decoded.cbegin(), decoded.cend(), false) - decoded.cbegin());
+        m_outputs.resize(firstFailed);
+        m_batchFirst = first;
+        m_batchSize = std::min(m_batchSize * 2, m_threadCount * FRAMES_PER_THREAD);
+        return !m_outputs.empty();
+    }
+};
+
+/** PUBLIC FUNCTIONS **/
+
+int getDefaultCompressionLevel(Compression codec)
+{
+    switch (codec)
+    {
+    case Compression::gzip:     return 6;
+    case Compression::bzip2:    return 9;
+    case Compression::zstd:     return 3;
+    default:                    return 0;
+    }
+}
+
+size_t writeSeekable(   std::istream& is,
+                        std::ostream& os,
+                        Compression codec,
+                        int level,
+                        size_t threadCount )
+{
+    threadCount = std::max(threadCount, size_t(1));
+    std::vector<std::vector<char>> chunks(threadCount);
+    std::vector<std::vector<char>> frames;
+    SeekableIndex index = { codec, {} };
+
+    //Read the headers as they are stored, decoding a copy for the sizes
+    MainHeader header;
+    if(readChunk(is, chunks[0], sizeof(MainHeader)) != sizeof(MainHeader))
+    {
+        return 0;
+    }
+    std::memcpy(&header, chunks[0].data(), sizeof(MainHeader));
+    if(!decodeMainHeader(header) || !isCompressionSupported(codec))
+    {
+        return 0;
+    }
+    std::vector<char> extHeader;
+    readChunk(is, extHeader, header.extHeaderLen);
+    chunks[0].insert(chunks[0].end(), extHeader.cbegin(), extHeader.cend());
+    size_t result = chunks[0].size();
+
+    //File header and headers frame
+    os.write(SEEKABLE_MAGIC.data(), SEEKABLE_MAGIC.size());
+    writeUint32(os, SEEKABLE_VERSION);
+    writeUint32(os, static_cast<uint32>(codec));
+    writeUint32(os, 0);
+    if(!writeFrames(os, chunks, 1, codec, level, threadCount, frames, index))
+    {
+        return 0;
+    }
+
+    //Sections, by batches of one per thread
+    const auto sectionSize = getSectionSize(header);
+    const size_t sectionCount = header.dimensions[2];
+    bool eof = false;
+    for(size_t section = 0; section < sectionCount && !eof; section += threadCount)
+    {
+        size_t count = 0;
+        while(count < std::min(threadCount, sectionCount - section) && !eof)
+        {
+            const auto received = readChunk(is, chunks[count], sectionSize);
+            eof = received < sectionSize;
+            result += received;
+            count += (received > 0) ? 1 : 0;
+        }
+
+        if(!writeFrames(os, chunks, count, codec, level, threadCount, frames, index))
+        {
+            return 0;
+        }
+    }
+
+    //End marker, index and footer
+    writeUint64(os, 0);
+    writeUint64(os, 0);
+    const auto indexOffset = static_cast<uint64>(os.tellp());
+    writeUint64(os, index.frames.size());
+    for(const auto& frame : index.frames)
+    {
+        writeUint64(os, frame.offset);
+        writeUint64(os, frame.compressedSize);
+        writeUint64(os, frame.size);
+    }
+    writeUint64(os, indexOffset);
+    os.write(SEEKABLE_MAGIC.data(), SEEKABLE_MAGIC.size());
+    writeUint32(os, SEEKABLE_VERSION);
+
+    return os.good() ? result : 0;
+}
+
+bool readSeekableIndex(std::istream& is, SeekableIndex& index)
+{
+    std::vector<char> buffer;
+
+    //File header
+    is.clear();
+    is.seekg(0);
+    if( readChunk(is, buffer, SEEKABLE_HEADER_SIZE) != SEEKABLE_HEADER_SIZE ||
+        std::string_view(buffer.data(), SEEKABLE_MAGIC.size()) != SEEKABLE_MAGIC ||
+        loadLittleEndian<uint32>(buffer.data() + 4) != SEEKABLE_VERSION )
+    {
+        return false;
+    }
+    index.codec = static_cast<Compression>(loadLittleEndian<uint32>(buffer.data() + 8));
+
+    //Footer
+    is.seekg(0, std::ios_base::end);
+    const auto fileSize = static_cast<uint64>(is.tellg());
+    if(fileSize < SEEKABLE_HEADER_SIZE + SEEKABLE_FOOTER_SIZE)
+    {
+        return false;
+    }
+    is.seekg(fileSize - SEEKABLE_FOOTER_SIZE);
+    if( readChunk(is, buffer, SEEKABLE_FOOTER_SIZE) != SEEKABLE_FOOTER_SIZE ||
+        std::string_view(buffer.data() + 8, SEEKABLE_MAGIC.size()) != SEEKABLE_MAGIC ||
+        loadLittleEndian<uint32>(buffer.data() + 12) != SEEKABLE_VERSION )
+    {
+        return false; //Truncated or not finished
+    }
+    const auto indexOffset = loadLittleEndian<uint64>(buffer.data());
+
+    //Index
+    is.seekg(indexOffset);
+    if(indexOffset + sizeof(uint64) > fileSize || readChunk(is, buffer, sizeof(uint64)) != sizeof(uint64))
+    {
+        return false;
+    }
+    const auto frameCount = loadLittleEndian<uint64>(buffer.data());
+    constexpr size_t ENTRY_SIZE = 3 * sizeof(uint64);
+    if(frameCount == 0 || frameCount > (fileSize - indexOffset) / ENTRY_SIZE)
+    {
+        return false;
+    }
+    if(readChunk(is, buffer, frameCount * ENTRY_SIZE) != frameCount * ENTRY_SIZE)
+    {
+        return false;
+    }
+    index.frames.resize(frameCount);
+    uint64 totalSize = 0;
+    for(size_t i = 0; i < frameCount; ++i)
+    {
+        const auto* entry = buffer.data() + i*ENTRY_SIZE;
+        auto& frame = index.frames[i];
+        frame.offset = loadLittleEndian<uint64>(entry);
+        frame.compressedSize = loadLittleEndian<uint64>(entry + 8);
+        frame.size = loadLittleEndian<uint64>(entry + 16);
+        if( frame.offset < SEEKABLE_HEADER_SIZE + FRAME_HEADER_SIZE || 
+            frame.offset > indexOffset || 
+            frame.compressedSize > indexOffset - frame.offset )
+        {
+            return false;
+        }
+
+        //Sections share their size, only the last one may be truncated
+        const bool validSize = 
+            (i == 0) ? (frame.size >= sizeof(MainHeader) && frame.size <= MAX_FRAME_SIZE) :
+            (i == 1) ? (frame.size <= MAX_FRAME_SIZE) :
+            (i + 1 < frameCount) ? (frame.size == index.frames[1].size) : 
+            (frame.size <= index.frames[1].size);
+        if(!validSize || frame.size > static_cast<uint64>(std::numeric_limits<int64>::max()) - totalSize)
+        {
+            return false;
+        }
+        totalSize += frame.size;
+    }
+
+    return true;
+}
+
+std::unique_ptr<std::streambuf> makeSeekableStreambuf(std::istream& source, size_t threadCount)
+{
+    std::unique_ptr<std::streambuf> result;
+    SeekableIndex index;
+    if(readSeekableIndex(source, index) && index.codec != Compression::seekable && isCompressionSupported(index.codec))
+    {
+        result = std::make_unique<SeekableStreambuf>(source, std::move(index), threadCount);
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,618 @@
+#include <Serialize.h>
+
+#include <ByteSwap.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+namespace MrcInspector
+{
+
+/** STATIC FUNCTIONS **/
+
+static std::string_view trimLabel(std::string_view str)
+{
+    const auto end = str.find_last_not_of(std::string_view(" \0", 2));
+    return str.substr(0, end == std::string_view::npos ? 0 : end + 1);
+}
+
+/**
+ * @brief Returns the length of the well-formed UTF-8 sequence starting at
+ * position i, or 0 if it is not valid (overlong, surrogate or out of range)
+ */
+static size_t getUtf8SequenceLength(std::string_view str, size_t i)
+{
+    const auto lead = static_cast<uint8>(str[i]);
+    size_t length;
+    uint8 low = 0x80, high = 0xBF; //Range of the second byte
+    if(lead < 0x80)         { return 1; }
+    else if(lead < 0xC2)    { return 0; }
+    else if(lead < 0xE0)    { length = 2; }
+    else if(lead < 0xF0)    { length = 3; low = (lead == 0xE0) ? 0xA0 : 0x80; high = (lead == 0xED) ? 0x9F : 0xBF; }
+    else if(lead < 0xF5)    { length = 4; low = (lead == 0xF0) ? 0x90 : 0x80; high = (lead == 0xF4) ? 0x8F : 0xBF; }
+    else                    { return 0; }
+
+    if(str.size() - i < length)
+    {
+        return 0;
+    }
+    for(size_t j = 1; j < length; ++j)
+    {
+        const auto byte = static_cast<uint8>(str[i + j]);
+        if(byte < (j == 1 ? low : 0x80) || byte > (j == 1 ? high : 0xBF))
+        {
+            return 0;
+        }
+    }
+    return length;
+}
+
+static bool isValidUtf8(std::string_view str)
+{
+    for(size_t i = 0; i < str.size(); )
+    {
+        const auto length = getUtf8SequenceLength(str, i);
+        if(length == 0)
+        {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+template<typename Writer>
+static void serializeValue(Writer& writer, uint32 x)
+{
+    writer.value(static_cast<uint64>(x));
+}
+
+template<typename Writer>
+static void serializeValue(Writer& writer, uint16 x)
+{
+    writer.value(static_cast<uint64>(x));
+}
+
+template<typename Writer>
+static void serializeValue(Writer& writer, float32 x)
+{
+    writer.value(x);
+}
+
+template<typename Writer>
+static void serializeValue(Writer& writer, AxisMapping x)
+{
+    writer.value(static_cast<uint64>(x));
+}
+
+template<typename Writer, typename T, size_t N>
+static void serializeArray(Writer& writer, std::string_view name, const std::array<T, N>& values)
+{
+    writer.key(name);
+    writer.beginArray();
+    for(const auto& x : values)
+    {
+        serializeValue(writer, x);
+    }
+    writer.endArray();
+}
+
+template<typename Writer>
+static void serializeHeaderImpl(Writer& writer, const MainHeader& header)
+{
+    //Extended header type as its 4 characters and byte order as its stamp in hex
+    const auto type = static_cast<Word>(header.extHeaderType);
+    const char typeName[4] = { char(type >> 24), char(type >> 16), char(type >> 8), char(type) };
+    char byteOrder[8];
+    const auto stamp = static_cast<Word>(header.byteOrder);
+    for(size_t i = 0; i < sizeof(byteOrder); ++i)
+    {
+        byteOrder[i] = "0123456789abcdef"[(stamp >> (28 - 4*i)) & 0xF];
+    }
+
+    writer.beginObject();
+    serializeArray(writer, "dimensions", header.dimensions);
+    writer.key("mode");
+    writer.value(static_cast<uint64>(header.mode));
+    writer.key("modeName");
+    writer.value(hasUnsignedBytes(header) ? "unsigned int8" : toString(header.mode));
+    serializeArray(writer, "start", header.start);
+    serializeArray(writer, "sampling", header.sampling);
+    serializeArray(writer, "cellDimensions", header.cellDimensions);
+    serializeArray(writer, "cellAngles", header.cellAngles);
+    serializeArray(writer, "axisMapping", header.axisMapping);
+    writer.key("min");
+    writer.value(header.min);
+    writer.key("max");
+    writer.value(header.max);
+    writer.key("avg");
+    writer.value(header.avg);
+    writer.key("ispg");
+    writer.value(static_cast<uint64>(header.ispg));
+    writer.key("extHeaderLen");
+    writer.value(static_cast<uint64>(header.extHeaderLen));
+    writer.key("creatorId");
+    writer.value(static_cast<uint64>(header.creatorId));
+    writer.key("extHeaderType");
+    writer.value(trimLabel(std::string_view(typeName, sizeof(typeName))));
+    writer.key("version");
+    writer.value(static_cast<uint64>(header.version));
+    writer.key("nInt");
+    writer.value(static_cast<uint64>(header.nInt));
+    writer.key("nReal");
+    writer.value(static_cast<uint64>(header.nReal));
+    writer.key("imodStamp");
+    writer.value(static_cast<uint64>(header.imodStamp));
+    writer.key("imodFlags");
+    writer.value(static_cast<uint64>(header.imodFlags));
+    writer.key("dataType");
+    writer.value(static_cast<uint64>(header.dataType));
+    writer.key("lens");
+    writer.value(static_cast<uint64>(header.lens));
+    serializeArray(writer, "dataCounts", header.dataCounts);
+    serializeArray(writer, "dataValues", header.dataValues);
+    serializeArray(writer, "originalTilt", header.originalTilt);
+    serializeArray(writer, "currentTilt", header.currentTilt);
+    serializeArray(writer, "origin", header.origin);
+    writer.key("map");
+    writer.value(trimLabel(std::string_view(header.map.data(), header.map.size())));
+    writer.key("byteOrder");
+    writer.value(std::string_view(byteOrder, sizeof(byteOrder)));
+    writer.key("rms");
+    writer.value(header.rms);
+    writer.key("nLabels");
+    writer.value(static_cast<uint64>(header.nLabels));
+    writer.key("labels");
+    writer.beginArray();
+    for(size_t i = 0; i < std::min<size_t>(header.nLabels, header.labels.size()); ++i)
+    {
+        writer.value(trimLabel(std::string_view(header.labels[i].data(), header.labels[i].size())));
+    }
+    writer.endArray();
+    writer.endObject();
+}
+
+template<typename Writer>
+static void serializeStatisticsImpl(Writer& writer, const Statistics& statistics)
+{
+    writer.beginObject();
+    writer.key("count");
+    writer.value(static_cast<uint64>(statistics.count));
+    writer.key("min");
+    writer.value(statistics.min);
+    writer.key("max");
+    writer.value(statistics.max);
+    writer.key("mean");
+    writer.value(getMean(statistics));
+    writer.key("rms");
+    writer.value(getRms(statistics));
+    writer.endObject();
+}
+
+/**
+ * @brief Loads a value of type T stored at the given offset with the given endianess
+ */
+template<typename T>
+static T loadValue(const std::string& bytes, size_t offset, Endianess endianess)
+{
+    T result;
+    std::memcpy(&result, bytes.data() + offset, sizeof(T));
+    if(needsSwap(endianess))
+    {
+        swapEndianess(reinterpret_cast<std::byte*>(&result), 1, sizeof(T));
+    }
+    return result;
+}
+
+/**
+ * @brief Writes the Agard records: nInt integers followed by nReal
+ * reals for each section, stored as 32bit words
+ */
+template<typename Writer>
+static void serializeAgardRecords(Writer& writer, const MainHeader& header, const std::string& extHeader)
+{
+    const auto recordSize = (static_cast<size_t>(header.nInt) + header.nReal) * sizeof(uint32);
+    const auto count = recordSize ? std::min<size_t>(header.dimensions[2], extHeader.size() / recordSize) : 0;
+    const auto intEndianess = getIntEndianess(header.byteOrder);
+    const auto floatEndianess = getFloatEndianess(header.byteOrder);
+
+    writer.beginArray();
+    for(size_t i = 0; i < count; ++i)
+    {
+        const auto offset = i*recordSize;
+        writer.beginObject();
+        writer.key("ints");
+        writer.beginArray();
+        for(size_t j = 0; j < header.nInt; ++j)
+        {
+            writer.value(static_cast<int64>(loadValue<int32>(extHeader, offset + j*sizeof(int32), intEndianess)));
+        }
+        writer.endArray();
+        writer.key("reals");
+        writer.beginArray();
+        for(size_t j = 0; j < header.nReal; ++j)
+        {
+            writer.value(loadValue<float32>(extHeader, offset + (header.nInt + j)*sizeof(float32), floatEndianess));
+        }
+        writer.endArray();
+        writer.endObject();
+    }
+    writer.endArray();
+}
+
+/**
+ * @brief Writes the leading fields of the FEI1 and FEI2 records, which are 
+ * common to both versions and always little endian. Each record starts with
+ * its own size
+ */
+template<typename Writer>
+static void serializeFeiRecords(Writer& writer, const MainHeader& header, const std::string& extHeader)
+{
+    constexpr size_t FEI_COMMON_SIZE = 172;
+    constexpr std::array<std::pair<std::string_view, size_t>, 4> STRINGS = {{
+        { "microscopeType", 20 }, { "dNumber", 36 }, { "application", 52 }, { "applicationVersion", 68 }
+    }};
+    constexpr std::array<std::pair<std::string_view, size_t>, 11> REALS = {{
+        { "ht", 84 }, { "dose", 92 }, { "alphaTilt", 100 }, { "betaTilt", 108 }, 
+        { "xStage", 116 }, { "yStage", 124 }, { "zStage", 132 }, { "tiltAxisAngle", 140 }, 
+        { "dualAxisRotation", 148 }, { "pixelSizeX", 156 }, { "pixelSizeY", 164 }
+    }};
+
+    writer.beginArray();
+    size_t offset = 0;
+    for(size_t i = 0; i < header.dimensions[2] && offset + FEI_COMMON_SIZE <= extHeader.size(); ++i)
+    {
+        const auto recordSize = static_cast<size_t>(loadValue<int32>(extHeader, offset, Endianess::le));
+        if(recordSize < FEI_COMMON_SIZE || offset + recordSize > extHeader.size())
+        {
+            break; //Not a record
+        }
+
+        writer.beginObject();
+        writer.key("metadataSize");
+        writer.value(static_cast<uint64>(recordSize));
+        writer.key("metadataVersion");
+        writer.value(static_cast<int64>(loadValue<int32>(extHeader, offset + 4, Endianess::le)));
+        writer.key("bitmask1");
+        writer.value(static_cast<uint64>(loadValue<uint32>(extHeader, offset + 8, Endianess::le)));
+        writer.key("timestamp");
+        writer.value(loadValue<float64>(extHeader, offset + 12, Endianess::le));
+        for(const auto& field : STRINGS)
+        {
+            writer.key(field.first);
+            writer.value(trimLabel(std::string_view(extHeader.data() + offset + field.second, 16)));
+        }
+        for(const auto& field : REALS)
+        {
+            writer.key(field.first);
+            writer.value(loadValue<float64>(extHeader, offset + field.second, Endianess::le));
+        }
+        writer.endObject();
+        offset += recordSize;
+    }
+    writer.endArray();
+}
+
+template<typename Writer>
+static void serializeExtendedHeaderImpl(Writer& writer, const MainHeader& header, const std::string& extHeader)
+{
+    writer.beginObject();
+    writer.key("type");
+    writer.value(toString(header.extHeaderType));
+    writer.key("size");
+    writer.value(static_cast<uint64>(header.extHeaderLen));
+    if(header.extHeaderType == ExtendedHeaderType::agar)
+    {
+        writer.key("sections");
+        serializeAgardRecords(writer, header, extHeader);
+    }
+    else if(header.extHeaderType == ExtendedHeaderType::fei1 || header.extHeaderType == ExtendedHeaderType::fei2)
+    {
+        writer.key("sections");
+        serializeFeiRecords(writer, header, extHeader);
+    }
+    writer.endObject();
+}
+
+template<typename Writer>
+static void serializeValidationImpl(Writer& writer, Validity validity, const std::vector<const ValidationRule*>& issues)
+{
+    writer.beginObject();
+    writer.key("validity");
+    writer.value(toString(validity));
+    writer.key("issues");
+    writer.beginArray();
+    for(const auto* rule : issues)
+    {
+        writer.beginObject();
+        writer.key("rule");
+        writer.value(rule->name);
+        writer.key("severity");
+        writer.value(toString(rule->severity));
+        writer.key("message");
+        writer.value(rule->message);
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.endObject();
+}
+
+/** PUBLIC FUNCTIONS **/
+
+JsonWriter::JsonWriter(std::string& buffer)
+    : m_buffer(buffer)
+{
+}
+
+void JsonWriter::beginObject()
+{
+    separate();
+    m_buffer.push_back('{');
+    m_empty[m_depth++ % MAX_DEPTH] = true;
+}
+
+void JsonWriter::endObject()
+{
+    --m_depth;
+    m_buffer.push_back('}');
+}
+
+void JsonWriter::beginArray()
+{
+    separate();
+    m_buffer.push_back('[');
+    m_empty[m_depth++ % MAX_DEPTH] = true;
+}
+
+void JsonWriter::endArray()
+{
+    --m_depth;
+    m_buffer.push_back(']');
+}
+
+void JsonWriter::key(std::string_view name)
+{
+    value(name);
+    m_buffer.push_back(':');
+    m_afterKey = true;
+}
+
+void JsonWriter::value(uint64 x)
+{
+    number(x);
+}
+
+void JsonWriter::value(int64 x)
+{
+    number(x);
+}
+
+void JsonWriter::value(float32 x)
+{
+    number(x);
+}
+
+void JsonWriter::value(float64 x)
+{
+    number(x);
+}
+
+void JsonWriter::value(bool x)
+{
+    separate();
+    m_buffer.append(x ? "true" : "false");
+}
+
+void JsonWriter::value(std::string_view x)
+{
+    separate();
+    m_buffer.push_back('"');
+    size_t length;
+    for(size_t i = 0; i < x.size(); i += std::max(length, size_t(1)))
+    {
+        const auto c = x[i];
+        const auto byte = static_cast<uint8>(c);
+        length = getUtf8SequenceLength(x, i);
+        if(c == '"' || c == '\\')
+        {
+            m_buffer.push_back('\\');
+            m_buffer.push_back(c);
+        }
+        else if(byte < 0x20)
+        {
+            const char escaped[6] = { '\\', 'u', '0', '0', "0123456789abcdef"[byte >> 4], "0123456789abcdef"[byte & 0xF] };
+            m_buffer.append(escaped, sizeof(escaped));
+        }
+        else if(length == 0)
+        {
+            //Not UTF-8. Each byte is replaced by U+FFFD
+            m_buffer.append("\\ufffd");
+        }
+        else
+        {
+            m_buffer.append(x.data() + i, length);
+        }
+    }
+    m_buffer.push_back('"');
+}
+
+void JsonWriter::separate()
+{
+    if(m_afterKey)
+    {
+        m_afterKey = false;
+    }
+    else if(m_depth > 0)
+    {
+        auto& empty = m_empty[(m_depth - 1) % MAX_DEPTH];
+        if(!empty)
+        {
+            m_buffer.push_back(',');
+        }
+        empty = false;
+    }
+}
+
+template<typename T>
+void JsonWriter::number(T x)
+{
+    separate();
+    if constexpr (std::is_floating_point<T>::value)
+    {
+        if(!std::isfinite(x))
+        {
+            m_buffer.append("null"); //Not representable in JSON
+            return;
+        }
+    }
+
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), x);
+    m_buffer.append(buffer, result.ptr);
+}
+
+CborWriter::CborWriter(std::string& buffer)
+    : m_buffer(buffer)
+{
+}
+
+void CborWriter::beginObject()
+{
+    m_buffer.push_back(static_cast<char>(0xBF));
+}
+
+void CborWriter::endObject()
+{
+    m_buffer.push_back(static_cast<char>(0xFF));
+}
+
+void CborWriter::beginArray()
+{
+    m_buffer.push_back(static_cast<char>(0x9F));
+}
+
+void CborWriter::endArray()
+{
+    m_buffer.push_back(static_cast<char>(0xFF));
+}
+
+void CborWriter::key(std::string_view name)
+{
+    value(name);
+}
+
+void CborWriter::value(uint64 x)
+{
+    head(0, x);
+}
+
+void CborWriter::value(int64 x)
+{
+    if(x >= 0)
+    {
+        head(0, static_cast<uint64>(x));
+    }
+    else
+    {
+        head(1, ~static_cast<uint64>(x)); //-1 - x
+    }
+}
+
+void CborWriter::value(float32 x)
+{
+    uint32 bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    m_buffer.push_back(static_cast<char>(0xFA));
+    for(int shift = 24; shift >= 0; shift -= 8)
+    {
+        m_buffer.push_back(static_cast<char>(bits >> shift));
+    }
+}
+
+void CborWriter::value(float64 x)
+{
+    uint64 bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    m_buffer.push_back(static_cast<char>(0xFB));
+    for(int shift = 56; shift >= 0; shift -= 8)
+    {
+        m_buffer.push_back(static_cast<char>(bits >> shift));
+    }
+}
+
+void CborWriter::value(bool x)
+{
+    m_buffer.push_back(static_cast<char>(x ? 0xF5 : 0xF4));
+}
+
+void CborWriter::value(std::string_view x)
+{
+    //Text strings must be UTF-8. Anything else is written as a byte string
+    head(isValidUtf8(x) ? 3 : 2, x.size());
+    m_buffer.append(x);
+}
+
+void CborWriter::head(uint8 major, uint64 argument)
+{
+    const auto type = static_cast<char>(major << 5);
+    if(argument < 24)
+    {
+        m_buffer.push_back(type | static_cast<char>(argument));
+        return;
+    }
+
+    int size;
+    if(argument <= 0xFF)                { m_buffer.push_back(type | 24); size = 1; }
+    else if(argument <= 0xFFFF)         { m_buffer.push_back(type | 25); size = 2; }
+    else if(argument <= 0xFFFFFFFF)     { m_buffer.push_back(type | 26); size = 4; }
+    else                                { m_buffer.push_back(type | 27); size = 8; }
+    for(int shift = 8*(size - 1); shift >= 0; shift -= 8)
+    {
+        m_buffer.push_back(static_cast<char>(argument >> shift));
+    }
+}
+
+void serializeHeader(JsonWriter& writer, const MainHeader& header)
+{
+    serializeHeaderImpl(writer, header);
+}
+
+void serializeHeader(CborWriter& writer, const MainHeader& header)
+{
+    serializeHeaderImpl(writer, header);
+}
+
+void serializeExtendedHeader(JsonWriter& writer, const MainHeader& header, const std::string& extHeader)
+{
+    serializeExtendedHeaderImpl(writer, header, extHeader);
+}
+
+void serializeExtendedHeader(CborWriter& writer, const MainHeader& header, const std::string& extHeader)
+{
+    serializeExtendedHeaderImpl(writer, header, extHeader);
+}
+
+void serializeStatistics(JsonWriter& writer, const Statistics& statistics)
+{
+    serializeStatisticsImpl(writer, statistics);
+}
+
+void serializeStatistics(CborWriter& writer, const Statistics& statistics)
+{
+    serializeStatisticsImpl(writer, statistics);
+}
+
+void serializeValidation(JsonWriter& writer, Validity validity, const std::vector<const ValidationRule*>& issues)
+{
+    serializeValidationImpl(writer, validity, issues);
+}
+
+void serializeValidation(CborWriter& writer, Validity validity, const std::vector<const ValidationRule*>& issues)
+{
+    serializeValidationImpl(writer, validity, issues);
+}
+
+}
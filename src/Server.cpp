@@ -0,0 +1,586 @@
+#include <Server.h>
+
+#include <HeaderCache.h>
+#include <WorkQueue.h>
+#include <Read.h>
+#include <Print.h>
+#include <Region.h>
+#include <Brick.h>
+#include <Decompress.h>
+
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr size_t MAX_REQUEST_SIZE = 64 << 10;
+static constexpr size_t RECEIVE_SIZE = 4096;
+static constexpr size_t MAX_EVENTS = 64;
+static constexpr int SEND_TIMEOUT_MS = 30000;
+static constexpr auto ACCEPT_BACKOFF = std::chrono::milliseconds(100);
+
+/** STATIC FUNCTIONS **/
+
+struct Connection
+{
+    int                         fd;             ///< Socket of the client
+    std::string                 buffer;         ///< Received bytes of the requests not answered yet
+};
+
+struct ServerState
+{
+    const char*                 socketPath;     ///< Path the server listens on
+    HeaderCache                 cache;          ///< Headers of the files requested so far
+    std::atomic<bool>           stopping;       ///< Set by a shutdown request
+    int                         epoll;          ///< Readiness of the listener and the clients
+    std::mutex                  mutex;          ///< Guards clients
+    std::map<int, std::unique_ptr<Connection>> clients; ///< Connected clients by socket
+};
+
+static bool makeAddress(const char* path, sockaddr_un& address)
+{
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    const auto length = std::strlen(path);
+    if(length >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+
+    std::memcpy(address.sun_path, path, length);
+    return true;
+}
+
+static int connectTo(const char* path)
+{
+    sockaddr_un address;
+    if(!makeAddress(path, address))
+    {
+        return -1;
+    }
+
+    const auto fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd >= 0 && connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sendAll(int fd, std::string_view data)
+{
+    while(!data.empty())
+    {
+        const auto count = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if(count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            //Non-blocking server socket. Give up on clients that stop reading
+            pollfd writable = { fd, POLLOUT, 0 };
+            if(poll(&writable, 1, SEND_TIMEOUT_MS) <= 0)
+            {
+                return false;
+            }
+            continue;
+        }
+        else if(count <= 0)
+        {
+            return false;
+        }
+        data.remove_prefix(count);
+    }
+    return true;
+}
+
+/**
+ * @brief Receives more bytes into the buffer. False on error or hang up
+ */
+static bool receiveMore(int fd, std::string& buffer)
+{
+    char chunk[RECEIVE_SIZE];
+    ssize_t count;
+    do
+    {
+        count = recv(fd, chunk, sizeof(chunk), 0);
+    } while(count < 0 && errno == EINTR);
+
+    if(count <= 0)
+    {
+        return false;
+    }
+    buffer.append(chunk, count);
+    return true;
+}
+
+/**
+ * @brief Takes a line out of the buffer, receiving until one is complete
+ */
+static bool receiveLine(int fd, std::string& buffer, std::string& line)
+{
+    size_t end;
+    while((end = buffer.find('\n')) == std::string::npos)
+    {
+        if(buffer.size() > MAX_REQUEST_SIZE || !receiveMore(fd, buffer))
+        {
+            return false;
+        }
+    }
+
+    line.assign(buffer, 0, end);
+    buffer.erase(0, end + 1);
+    if(!line.empty() && line.back() == '\r')
+    {
+        line.pop_back();
+    }
+    return true;
+}
+
+/**
+ * @brief Takes the first space separated word out of the string
+ */
+static std::string_view takeWord(std::string_view& str)
+{
+    const auto begin = std::min(str.find_first_not_of(' '), str.size());
+    const auto end = std::min(str.find(' ', begin), str.size());
+    const auto result = str.substr(begin, end - begin);
+    str.remove_prefix(std::min(end + 1, str.size()));
+    return result;
+}
+
+static bool takeNumber(std::string_view& str, size_t& value)
+{
+    const auto word = takeWord(str);
+    const auto result = std::from_chars(word.data(), word.data() + word.size(), value);
+    return !word.empty() && result.ec == std::errc() && result.ptr == word.data() + word.size();
+}
+
+static bool takeAxis(std::string_view& str, AxisMapping& axis)
+{
+    const auto word = takeWord(str);
+    if(word == "x") axis = AxisMapping::x;
+    else if(word == "y") axis = AxisMapping::y;
+    else if(word == "z") axis = AxisMapping::z;
+    else return false;
+    return true;
+}
+
+/**
+ * @brief Opens the file at the start of its data block
+ */
+static std::unique_ptr<std::istream> openData(const std::string& path, const MainHeader& header)
+{
+    Compression compression;
+    auto result = openInputFile(path.c_str(), 1, compression);
+    const auto offset = getDataOffset(header);
+    if(result && !result->seekg(offset))
+    {
+        result->clear();
+        result->ignore(offset);
+        if(static_cast<size_t>(result->gcount()) != offset)
+        {
+            return nullptr;
+        }
+    }
+    return result;
+}
+
+static bool handleHeader(ServerState& state, const std::string& path, std::ostream& os)
+{
+    const auto entry = state.cache.get(path);
+    if(!entry)
+    {
+        os << "Error reading the headers of " << path;
+        return false;
+    }
+
+    printHeaders(os, entry->header, entry->extHeader);
+    return true;
+}
+
+static bool handleStatistics(ServerState& state, const std::string& path, std::ostream& os)
+{
+    const auto entry = state.cache.get(path);
+    if(!entry)
+    {
+        os << "Error reading the headers of " << path;
+        return false;
+    }
+    else if(entry->statistics)
+    {
+        printStatistics(os, *entry->statistics);
+        return true;
+    }
+
+    const auto& header = entry->header;
+    const auto is = openData(path, header);
+    Statistics statistics;
+    if(!is || computeStreamStatistics(*is, header, 1, statistics) != header.dimensions[2])
+    {
+        os << "Error reading the data block of " << path;
+        return false;
+    }
+
+    state.cache.setStatistics(path, entry->stamp, statistics);
+    printStatistics(os, statistics);
+    return true;
+}
+
+static bool handleRegion(ServerState& state, const std::string& path, const Region* region, AxisMapping axis, size_t index, std::ostream& os)
+{
+    const auto entry = state.cache.get(path);
+    if(!entry)
+    {
+        os << "Error reading the headers of " << path;
+        return false;
+    }
+
+    const auto& header = entry->header;
+    const auto bounds = region ? *region : getSliceRegion(header, axis, index);
+    if(!isValidRegion(header, bounds))
+    {
+        os << "Region out of the bounds of the volume";
+        return false;
+    }
+
+    DataBlock data;
+    const auto is = openData(path, header);
+    const auto expected = bounds.size[0] * bounds.size[1] * bounds.size[2] * getModeSize(header.mode);
+    if(!is || readCachedRegion(path.c_str(), *is, header, bounds, data) != expected)
+    {
+        os << "Error reading the region of " << path;
+        return false;
+    }
+
+    printAll(os, makeRegionHeader(header, bounds), std::string(), data);
+    return true;
+}
+
+static void stopServer(ServerState& state)
+{
+    state.stopping = true;
+
+    //Wake up the listener, which is waiting for events
+    const auto fd = connectTo(state.socketPath);
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+static bool handleRequest(ServerState& state, std::string_view request, std::ostream& os)
+{
+    const auto command = takeWord(request);
+    if(command == "header" && !request.empty())
+    {
+        return handleHeader(state, std::string(request), os);
+    }
+    else if(command == "stats" && !request.empty())
+    {
+        return handleStatistics(state, std::string(request), os);
+    }
+
+    AxisMapping axis;
+    size_t index;
+    if(command == "slice" && takeAxis(request, axis) && takeNumber(request, index) && !request.empty())
+    {
+        return handleRegion(state, std::string(request), nullptr, axis, index, os);
+    }
+
+    Region region;
+    if( command == "region" &&
+        takeNumber(request, region.origin[0]) && takeNumber(request, region.origin[1]) && takeNumber(request, region.origin[2]) &&
+        takeNumber(request, region.size[0]) && takeNumber(request, region.size[1]) && takeNumber(request, region.size[2]) &&
+        !request.empty() )
+    {
+        return handleRegion(state, std::string(request), &region, AxisMapping::z, 0, os);
+    }
+    else if(command == "status")
+    {
+        os << "hits " << state.cache.getHitCount() << '\n';
+        os << "misses " << state.cache.getMissCount() << '\n';
+        return true;
+    }
+    else if(command == "shutdown")
+    {
+        return true; //Stopped once answered
+    }
+
+    os << "Malformed request: " << command;
+    return false;
+}
+
+/**
+ * @brief Takes what the client has sent so far, without waiting for more, and
+ * answers every complete request in it. Returns false once the connection is
+ * to be closed
+ */
+static bool serveRequests(ServerState& state, Connection& connection)
+{
+    bool open = true;
+    char chunk[RECEIVE_SIZE];
+    while(true)
+    {
+        const auto count = recv(connection.fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+        if(count > 0)
+        {
+            connection.buffer.append(chunk, count);
+        }
+        else if(count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            open = count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+            break; //Drained, hung up or failed
+        }
+    }
+
+    size_t end;
+    while(!state.stopping && (end = connection.buffer.find('\n')) != std::string::npos)
+    {
+        std::string line(connection.buffer, 0, end);
+        connection.buffer.erase(0, end + 1);
+        if(!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+
+        std::ostringstream os;
+        const auto success = handleRequest(state, line, os);
+        const auto text = os.str();
+        const auto status = std::string(success ? "OK " : "ERROR ") + std::to_string(text.size()) + '\n';
+        if(!sendAll(connection.fd, status) || !sendAll(connection.fd, text))
+        {
+            return false;
+        }
+        else if(line == "shutdown")
+        {
+            stopServer(state);
+            return false;
+        }
+    }
+
+    return open && !state.stopping && connection.buffer.size() <= MAX_REQUEST_SIZE;
+}
+
+static void closeClient(ServerState& state, int fd)
+{
+    std::lock_guard<std::mutex> lock(state.mutex);
+    close(fd); //Also leaves the epoll set
+    state.clients.erase(fd);
+}
+
+/**
+ * @brief Accepts every pending connection. Returns false on an error other than
+ * running out of descriptors, which is waited out instead of retried at once
+ */
+static bool acceptClients(ServerState& state, int listener)
+{
+    while(true)
+    {
+        const auto fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if(fd < 0)
+        {
+            switch (errno)
+            {
+            case EAGAIN:
+            #if EAGAIN != EWOULDBLOCK
+                case EWOULDBLOCK:
+            #endif
+                return true;
+            case EINTR:
+            case ECONNABORTED:
+            case EPROTO:
+                continue;
+            case EMFILE:
+            case ENFILE:
+            case ENOBUFS:
+            case ENOMEM:
+                std::this_thread::sleep_for(ACCEPT_BACKOFF);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        auto& connection = state.clients[fd];
+        connection = std::make_unique<Connection>(Connection{fd, std::string()});
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+        event.data.ptr = connection.get();
+        if(epoll_ctl(state.epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            close(fd);
+            state.clients.erase(fd);
+        }
+    }
+}
+
+/** PUBLIC FUNCTIONS **/
+
+bool runServer(const char* socketPath, const ServerOptions& options)
+{
+    sockaddr_un address;
+    if(!makeAddress(socketPath, address))
+    {
+        return false;
+    }
+
+    //Replace stale sockets, but not live servers or other files
+    struct stat status;
+    if(lstat(socketPath, &status) == 0)
+    {
+        const auto fd = connectTo(socketPath);
+        if(!S_ISSOCK(status.st_mode) || fd >= 0)
+        {
+            if(fd >= 0) close(fd);
+            return false;
+        }
+        unlink(socketPath);
+    }
+
+    const auto listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if( listener < 0 ||
+        bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0 )
+    {
+        if(listener >= 0) close(listener);
+        return false;
+    }
+
+    const auto epoll = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event listenerEvent = {};
+    listenerEvent.events = EPOLLIN;
+    listenerEvent.data.ptr = nullptr;
+    if(epoll < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &listenerEvent) != 0)
+    {
+        if(epoll >= 0) close(epoll);
+        close(listener);
+        unlink(socketPath);
+        return false;
+    }
+
+    ServerState state{socketPath, HeaderCache(options.cacheSize), false, epoll, {}, {}};
+
+    //Connections are handed to a worker only when a request arrives, and go
+    //back to waiting (one-shot, re-armed by the worker) once it is answered.
+    //Idle connections therefore do not hold a thread
+    const auto threadCount = std::max<size_t>(options.threadCount, 1);
+    WorkQueue<Connection*> queue(threadCount);
+    std::vector<std::thread> workers;
+    for(size_t i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back(
+            [&state, &queue] ()
+            {
+                while(const auto connection = queue.pop())
+                {
+                    const auto fd = (*connection)->fd;
+                    epoll_event event = {};
+                    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+                    event.data.ptr = *connection;
+                    if(!serveRequests(state, **connection) || epoll_ctl(state.epoll, EPOLL_CTL_MOD, fd, &event) != 0)
+                    {
+                        closeClient(state, fd);
+                    }
+                }
+            }
+        );
+    }
+
+    bool result = true;
+    std::array<epoll_event, MAX_EVENTS> events;
+    while(!state.stopping && result)
+    {
+        const auto count = epoll_wait(epoll, events.data(), events.size(), -1);
+        if(count < 0 && errno != EINTR)
+        {
+            result = false;
+        }
+        for(int i = 0; i < count && !state.stopping; ++i)
+        {
+            if(events[i].data.ptr)
+            {
+                queue.push(static_cast<Connection*>(events[i].data.ptr));
+            }
+            else
+            {
+                result = acceptClients(state, listener);
+            }
+        }
+    }
+
+    queue.close();
+    for(auto& worker : workers)
+    {
+        worker.join();
+    }
+    for(const auto& client : state.clients)
+    {
+        close(client.first);
+    }
+    close(epoll);
+    close(listener);
+    unlink(socketPath);
+    return result;
+}
+
+bool sendRequest(const char* socketPath, std::string_view request, ServerResponse& response)
+{
+    const auto fd = connectTo(socketPath);
+    if(fd < 0)
+    {
+        return false;
+    }
+
+    std::string buffer;
+    std::string line;
+    auto result = sendAll(fd, std::string(request) + '\n') && receiveLine(fd, buffer, line);
+
+    //Status line, then the text
+    std::string_view status = line;
+    const auto word = takeWord(status);
+    size_t size;
+    result = result && (word == "OK" || word == "ERROR") && takeNumber(status, size);
+    while(result && buffer.size() < size)
+    {
+        result = receiveMore(fd, buffer);
+    }
+    close(fd);
+
+    if(result)
+    {
+        response.success = word == "OK";
+        response.text = buffer.substr(0, size);
+    }
+    return result;
+}
+
+}
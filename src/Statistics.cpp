@@ -0,0 +1,281 @@
+#include <Statistics.h>
+
+#include <Read.h>
+#include <FileRead.h>
+#include <ByteSwap.h>
+#include <Parallel.h>
+
+#include <array>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr size_t BAND_SIZE = 1 << 16;
+static constexpr size_t STREAM_SECTION_COUNT = 16;
+static constexpr size_t STREAM_BAND_COUNT = 64;
+static constexpr size_t FUSED_CHUNK_SIZE = 4096;
+
+/** STATIC FUNCTIONS **/
+
+/**
+ * @brief Accumulates count values of type T as stored in the file. They are
+ * taken a chunk at a time into a buffer that fits in L1, matched to the native
+ * byte order there and accumulated right away, so the stored bytes are only
+ * traversed once
+ */
+template<typename T>
+static void accumulateStoredStatistics(Statistics& statistics, const std::byte* stored, size_t count, size_t wordSize, bool swap)
+{
+    std::array<T, FUSED_CHUNK_SIZE> values;
+    auto* bytes = reinterpret_cast<std::byte*>(values.data());
+    for(size_t begin = 0; begin < count; begin += values.size())
+    {
+        const auto n = std::min(values.size(), count - begin);
+        std::memcpy(bytes, stored + begin*sizeof(T), n*sizeof(T));
+        if(swap)
+        {
+            swapEndianess(bytes, n*sizeof(T) / wordSize, wordSize);
+        }
+        accumulateStatistics(statistics, values.data(), n);
+    }
+}
+
+/**
+ * @brief Reads the data block in chunks of whole bands straight into a byte
+ * buffer and accumulates each band in parallel from it. Chunks are made of
+ * whole bands, so the result does not depend on the thread count. They end
+ * on section boundaries when there is one within reach, and sections only 
+ * reach the statistics once complete, so a truncated data block leaves them
+ * with exactly the returned amount of sections
+ */
+template<typename T>
+static size_t computeFusedStatistics(std::istream& is, const MainHeader& header, size_t threadCount, Statistics& statistics)
+{
+    const auto wordSize = getModeWordSize(header.mode);
+    const auto endianess = getModeEndianess(header.byteOrder, header.mode);
+    if(wordSize > 1 && endianess != Endianess::be && endianess != Endianess::le)
+    {
+        return 0;
+    }
+    const auto swap = wordSize > 1 && needsSwap(endianess);
+
+    const auto elementCount = getElementCount(header);
+    const auto sectionElementCount = std::max<size_t>(getSectionElementCount(header), 1);
+    const auto chunkSize = std::min(STREAM_BAND_COUNT * BAND_SIZE, elementCount);
+    std::vector<std::byte> stored(chunkSize * sizeof(T));
+    std::vector<Statistics> bands(STREAM_BAND_COUNT);
+    auto pending = makeStatistics(); //Sections not completed yet
+
+    size_t processed = 0;
+    bool truncated = false;
+    while(processed < elementCount && !truncated)
+    {
+        auto end = std::min(processed + chunkSize, elementCount);
+        const auto boundary = end / sectionElementCount * sectionElementCount;
+        end = boundary > processed ? boundary : end;
+        auto count = end - processed;
+
+        is.read(reinterpret_cast<char*>(stored.data()), count * sizeof(T));
+        const auto received = static_cast<size_t>(is.gcount()) / sizeof(T);
+        if(received != count)
+        {
+            //Keep the sections that were completed, if any
+            truncated = true;
+            const auto completed = (processed + received) / sectionElementCount * sectionElementCount;
+            count = completed > processed ? completed - processed : 0;
+        }
+
+        const auto bandCount = (count + BAND_SIZE - 1) / BAND_SIZE;
+        std::fill_n(bands.begin(), bandCount, makeStatistics());
+        parallelFor(
+            bandCount, threadCount,
+            [&stored, &bands, count, wordSize, swap] (size_t i)
+            {
+                const auto begin = i * BAND_SIZE;
+                const auto end = std::min(begin + BAND_SIZE, count);
+                accumulateStoredStatistics<T>(bands[i], stored.data() + begin*sizeof(T), end - begin, wordSize, swap);
+            }
+        );
+        for(size_t i = 0; i < bandCount; ++i)
+        {
+            mergeStatistics(pending, bands[i]);
+        }
+
+        processed += count;
+        if(processed % sectionElementCount == 0)
+        {
+            mergeStatistics(statistics, pending);
+            pending = makeStatistics();
+        }
+    }
+
+    return processed / sectionElementCount;
+}
+
+/**
+ * @brief Accumulates the chunks handed by the file reader as they complete,
+ * in any order, split in bands within each section. The bands are merged in
+ * order once all of them are read, so the result does not depend on the order
+ * of completion, and only the sections read completely are merged
+ */
+template<typename T>
+static size_t computeChunkedStatistics( const char* path, 
+                                        const MainHeader& header, 
+                                        const FileReadOptions& options, 
+                                        Statistics& statistics )
+{
+    const auto wordSize = getModeWordSize(header.mode);
+    const auto endianess = getModeEndianess(header.byteOrder, header.mode);
+    if(wordSize > 1 && endianess != Endianess::be && endianess != Endianess::le)
+    {
+        return 0;
+    }
+    const auto swap = wordSize > 1 && needsSwap(endianess);
+    const auto sectionSize = std::max<size_t>(getSectionSize(header), 1);
+
+    //Statistics of the pieces of each chunk, one per section it spans
+    std::mutex mutex;
+    std::map<size_t, std::vector<Statistics>> chunkPieces;
+    const auto count = readDataChunks(
+        path, header, options,
+        [&mutex, &chunkPieces, sectionSize, wordSize, swap] (std::byte* data, size_t offset, size_t size)
+        {
+            std::vector<Statistics> pieces;
+            for(auto begin = offset; begin < offset + size; )
+            {
+                const auto end = std::min((begin / sectionSize + 1) * sectionSize, offset + size);
+                auto piece = makeStatistics();
+                for(auto band = begin; band < end; band += BAND_SIZE*sizeof(T))
+                {
+                    auto bandStatistics = makeStatistics();
+                    const auto bandEnd = std::min(band + BAND_SIZE*sizeof(T), end);
+                    accumulateStoredStatistics<T>(bandStatistics, data + (band - offset), (bandEnd - band) / sizeof(T), wordSize, swap);
+                    mergeStatistics(piece, bandStatistics);
+                }
+                pieces.push_back(piece);
+                begin = end;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            chunkPieces.emplace(offset, std::move(pieces));
+        }
+    );
+
+    const auto result = count / sectionSize;
+    for(const auto& chunk : chunkPieces)
+    {
+        for(size_t i = 0; i < chunk.second.size(); ++i)
+        {
+            if(chunk.first / sectionSize + i < result)
+            {
+                mergeStatistics(statistics, chunk.second[i]);
+            }
+        }
+    }
+
+    return result;
+}
+
+/** PUBLIC FUNCTIONS **/
+
+Statistics computeStatistics(const DataBlock& data, size_t threadCount)
+{
+    return std::visit(
+        [threadCount] (const auto& values)
+        {
+            //Accumulate fixed-size bands in parallel, so that the 
+            //result does not depend on the thread count
+            std::vector<Statistics> bands((values.size() + BAND_SIZE - 1) / BAND_SIZE, makeStatistics());
+            parallelFor(
+                bands.size(), threadCount,
+                [&values, &bands] (size_t i)
+                {
+                    const auto begin = i * BAND_SIZE;
+                    const auto end = std::min(begin + BAND_SIZE, values.size());
+                    accumulateStatistics(bands[i], values.data() + begin, end - begin);
+                }
+            );
+
+            auto result = makeStatistics();
+            for(const auto& band : bands)
+            {
+                mergeStatistics(result, band);
+            }
+            return result;
+        },
+        data
+    );
+}
+
+size_t computeStreamStatistics(std::istream& is, const MainHeader& header, size_t threadCount, Statistics& statistics)
+{
+    statistics = makeStatistics();
+    DataBlock data;
+    if(!isPackedMode(header.mode) && emplaceDataBlock(data, header))
+    {
+        //Only the type of the values is needed, the block stays empty
+        return std::visit(
+            [&is, &header, threadCount, &statistics] (const auto& values)
+            {
+                using T = typename std::decay<decltype(values)>::type::value_type;
+                return computeFusedStatistics<T>(is, header, threadCount, statistics);
+            },
+            data
+        );
+    }
+
+    //Packed modes are expanded in cache-sized chunks as they are read
+    const auto sectionSize = getSectionSize(header);
+    size_t result = 0;
+    while(result < header.dimensions[2])
+    {
+        const auto count = std::min<size_t>(STREAM_SECTION_COUNT, header.dimensions[2] - result);
+        if(readSections(is, header, count, data) != count*sectionSize)
+        {
+            break;
+        }
+        mergeStatistics(statistics, computeStatistics(data, threadCount));
+        result += count;
+    }
+
+    return result;
+}
+
+size_t computeFileStatistics(const char* path, const MainHeader& header, const FileReadOptions& options, Statistics& statistics)
+{
+    statistics = makeStatistics();
+    DataBlock data;
+    if(isPackedMode(header.mode) || !emplaceDataBlock(data, header))
+    {
+        return 0;
+    }
+
+    return std::visit(
+        [path, &header, &options, &statistics] (const auto& values)
+        {
+            using T = typename std::decay<decltype(values)>::type::value_type;
+            return computeChunkedStatistics<T>(path, header, options, statistics);
+        },
+        data
+    );
+}
+
+void updateHeaderStatistics(MainHeader& header, const Statistics& statistics)
+{
+    if(statistics.count)
+    {
+        header.min = static_cast<float32>(statistics.min);
+        header.max = static_cast<float32>(statistics.max);
+        header.avg = static_cast<float32>(getMean(statistics));
+        header.rms = static_cast<float32>(getRms(statistics));
+    }
+}
+
+}
@@ -0,0 +1,135 @@
+#include <Transpose.h>
+
+#include <Parallel.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr size_t TILE_SIZE = 16;
+
+/** STATIC FUNCTIONS **/
+
+static size_t getAxisIndex(AxisMapping axis)
+{
+    return static_cast<size_t>(axis) - 1;
+}
+
+template<typename T>
+static void transposeImpl(  const std::vector<T>& src, 
+                            std::vector<T>& dst, 
+                            const std::array<size_t, 3>& dimensions,
+                            const std::array<size_t, 3>& srcStrides,
+                            size_t threadCount )
+{
+    //dimensions and srcStrides are given along the destination axes
+    const auto [nx, ny, nz] = dimensions;
+    const auto [sx, sy, sz] = srcStrides;
+    dst.resize(src.size());
+
+    const auto nTilesX = (nx + TILE_SIZE - 1) / TILE_SIZE;
+    const auto nTilesY = (ny + TILE_SIZE - 1) / TILE_SIZE;
+    const auto nTilesZ = (nz + TILE_SIZE - 1) / TILE_SIZE;
+
+    //Tiles write disjoint regions of the destination, so they are processed in parallel
+    parallelFor(
+        nTilesX * nTilesY * nTilesZ, threadCount,
+        [&src, &dst, nx, ny, nz, sx, sy, sz, nTilesX, nTilesY] (size_t tile)
+        {
+            const auto x0 = (tile % nTilesX) * TILE_SIZE;
+            const auto y0 = ((tile / nTilesX) % nTilesY) * TILE_SIZE;
+            const auto z0 = (tile / (nTilesX * nTilesY)) * TILE_SIZE;
+            const auto x1 = std::min(x0 + TILE_SIZE, nx);
+            const auto y1 = std::min(y0 + TILE_SIZE, ny);
+            const auto z1 = std::min(z0 + TILE_SIZE, nz);
+
+            for(size_t z = z0; z < z1; ++z)
+            {
+                for(size_t y = y0; y < y1; ++y)
+                {
+                    const auto* srcRow = src.data() + y*sy + z*sz;
+                    auto* dstRow = dst.data() + (z*ny + y)*nx;
+                    for(size_t x = x0; x < x1; ++x)
+                    {
+                        dstRow[x] = srcRow[x*sx];
+                    }
+                }
+            }
+        }
+    );
+}
+
+/** PUBLIC FUNCTIONS **/
+
+bool isValidAxisMapping(const std::array<AxisMapping, 3>& axisMapping)
+{
+    auto sorted = axisMapping;
+    std::sort(sorted.begin(), sorted.end());
+    return sorted == std::array<AxisMapping, 3>{ AxisMapping::x, AxisMapping::y, AxisMapping::z };
+}
+
+bool isCanonicalAxisMapping(const std::array<AxisMapping, 3>& axisMapping)
+{
+    return axisMapping == std::array<AxisMapping, 3>{ AxisMapping::x, AxisMapping::y, AxisMapping::z };
+}
+
+MainHeader makeCanonicalHeader(const MainHeader& header)
+{
+    auto result = header;
+    if(isValidAxisMapping(header.axisMapping))
+    {
+        for(size_t i = 0; i < 3; ++i)
+        {
+            const auto axis = getAxisIndex(header.axisMapping[i]);
+            result.dimensions[axis] = header.dimensions[i];
+            result.start[axis] = header.start[i];
+            result.axisMapping[i] = static_cast<AxisMapping>(i + 1);
+        }
+        if(!isCanonicalAxisMapping(header.axisMapping))
+        {
+            clearExtendedHeader(result); //Per-section metadata does not apply anymore
+        }
+    }
+    return result;
+}
+
+bool transposeToCanonical(const MainHeader& header, const DataBlock& src, DataBlock& dst, size_t threadCount)
+{
+    if(!isValidAxisMapping(header.axisMapping))
+    {
+        return false;
+    }
+
+    //Obtain the strides of the source along each of the destination axes
+    const std::array<size_t, 3> storageStrides = {
+        1,
+        header.dimensions[0],
+        static_cast<size_t>(header.dimensions[0]) * header.dimensions[1]
+    };
+    std::array<size_t, 3> dimensions;
+    std::array<size_t, 3> srcStrides;
+    for(size_t i = 0; i < 3; ++i)
+    {
+        const auto axis = getAxisIndex(header.axisMapping[i]);
+        dimensions[axis] = header.dimensions[i];
+        srcStrides[axis] = storageStrides[i];
+    }
+
+    std::visit(
+        [&dst, &dimensions, &srcStrides, threadCount] (const auto& srcValues)
+        {
+            using Vector = typename std::decay<decltype(srcValues)>::type;
+            auto& dstValues = dst.emplace<Vector>();
+            transposeImpl(srcValues, dstValues, dimensions, srcStrides, threadCount);
+        },
+        src
+    );
+
+    return true;
+}
+
+}
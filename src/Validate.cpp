@@ -0,0 +1,183 @@
+#include <Validate.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr uint32 MAX_LABEL_COUNT = 10;
+
+/** STATIC FUNCTIONS **/
+
+static uint64 getExpectedFileSize(const MainHeader& header)
+{
+    //Saturates instead of wrapping around, as the dimensions may be anything
+    constexpr auto MAX_SIZE = std::numeric_limits<uint64>::max() / 2;
+    const uint64 nColumns = header.dimensions[0];
+    uint64 result = isPackedMode(header.mode) ? (nColumns + 1) / 2 : nColumns * getModeSize(header.mode);
+    for(size_t i = 1; i < header.dimensions.size(); ++i)
+    {
+        const auto dimension = header.dimensions[i];
+        if(dimension != 0 && result > MAX_SIZE / dimension)
+        {
+            return MAX_SIZE;
+        }
+        result *= dimension;
+    }
+    return result + sizeof(MainHeader) + header.extHeaderLen;
+}
+
+static bool checkMode(const MainHeader& header, const ValidationContext&)
+{
+    return getModeSize(header.mode) != 0;
+}
+
+static bool checkDimensions(const MainHeader& header, const ValidationContext&)
+{
+    //Stored as signed integers
+    return std::all_of(
+        header.dimensions.cbegin(), header.dimensions.cend(),
+        [] (uint32 x)
+        {
+            return static_cast<int32>(x) > 0;
+        }
+    );
+}
+
+static bool checkExtHeaderLen(const MainHeader& header, const ValidationContext& context)
+{
+    if(static_cast<int32>(header.extHeaderLen) < 0)
+    {
+        return false;
+    }
+    return context.fileSize == 0 || sizeof(MainHeader) + static_cast<uint64>(header.extHeaderLen) <= context.fileSize;
+}
+
+static bool checkDataSize(const MainHeader& header, const ValidationContext& context)
+{
+    const auto expected = getExpectedFileSize(header);
+    return context.fileSize == 0 ? expected - sizeof(MainHeader) <= MAX_UNKNOWN_DATA_SIZE : expected <= context.fileSize;
+}
+
+static bool checkTrailingData(const MainHeader& header, const ValidationContext& context)
+{
+    return context.fileSize == 0 || getExpectedFileSize(header) >= context.fileSize;
+}
+
+static bool checkMap(const MainHeader& header, const ValidationContext&)
+{
+    //Older writers leave the last character as a null
+    return header.map[0] == 'M' && header.map[1] == 'A' && header.map[2] == 'P' && (header.map[3] == ' ' || header.map[3] == '\0');
+}
+
+static bool checkLabelCount(const MainHeader& header, const ValidationContext&)
+{
+    return header.nLabels <= MAX_LABEL_COUNT;
+}
+
+static bool checkAxisMapping(const MainHeader& header, const ValidationContext&)
+{
+    //A permutation of x, y and z
+    uint32 mask = 0;
+    for(const auto axis : header.axisMapping)
+    {
+        const auto value = static_cast<uint32>(axis);
+        if(value < 1 || value > 3)
+        {
+            return false;
+        }
+        mask |= 1U << value;
+    }
+    return mask == 0b1110;
+}
+
+static bool checkSampling(const MainHeader& header, const ValidationContext&)
+{
+    return std::all_of(
+        header.sampling.cbegin(), header.sampling.cend(),
+        [] (uint32 x)
+        {
+            return static_cast<int32>(x) > 0;
+        }
+    );
+}
+
+static bool checkCell(const MainHeader& header, const ValidationContext&)
+{
+    const auto validDimension = [] (float32 x) { return std::isfinite(x) && x >= 0.0f; };
+    const auto validAngle = [] (float32 x) { return x == 0.0f || (x > 0.0f && x < 180.0f); };
+    return  std::all_of(header.cellDimensions.cbegin(), header.cellDimensions.cend(), validDimension) &&
+            std::all_of(header.cellAngles.cbegin(), header.cellAngles.cend(), validAngle);
+}
+
+static bool checkDensity(const MainHeader& header, const ValidationContext&)
+{
+    return  std::isfinite(header.min) && std::isfinite(header.max) &&
+            std::isfinite(header.avg) && std::isfinite(header.rms);
+}
+
+/** PUBLIC FUNCTIONS **/
+
+ValidationContext getValidationContext(std::istream& is)
+{
+    ValidationContext result = { 0 };
+    const auto position = is.tellg();
+    if(position == std::istream::pos_type(-1))
+    {
+        return result; //Not seekable. Seeking back would fail the stream
+    }
+    else if(is.seekg(0, std::ios_base::end))
+    {
+        const auto end = is.tellg();
+        result.fileSize = end != std::istream::pos_type(-1) ? static_cast<uint64>(end) : 0;
+    }
+    is.clear();
+    is.seekg(position);
+    return result;
+}
+
+const std::vector<ValidationRule>& getValidationRules()
+{
+    static const std::vector<ValidationRule> rules = {
+        { "mode",           Validity::corrupt,      "unknown data mode",                                        checkMode },
+        { "dimensions",     Validity::corrupt,      "dimensions are not positive",                              checkDimensions },
+        { "extHeaderLen",   Validity::corrupt,      "extended header length is negative or past the end of the file", checkExtHeaderLen },
+        { "dataSize",       Validity::corrupt,      "data block is larger than the file",                       checkDataSize },
+        { "map",            Validity::suspicious,   "'MAP ' identifier is missing",                             checkMap },
+        { "nLabels",        Validity::suspicious,   "more than 10 labels",                                      checkLabelCount },
+        { "axisMapping",    Validity::suspicious,   "axis mapping is not a permutation of 1, 2 and 3",          checkAxisMapping },
+        { "sampling",       Validity::suspicious,   "sampling is not positive",                                 checkSampling },
+        { "cell",           Validity::suspicious,   "cell dimensions or angles out of range",                   checkCell },
+        { "density",        Validity::suspicious,   "density statistics are not finite",                        checkDensity },
+        { "trailingData",   Validity::suspicious,   "file is larger than the header describes",                 checkTrailingData },
+    };
+    return rules;
+}
+
+Validity validateHeader(const MainHeader& header, const ValidationContext& context, std::vector<const ValidationRule*>* issues)
+{
+    auto result = Validity::valid;
+    for(const auto& rule : getValidationRules())
+    {
+        if(!rule.check(header, context))
+        {
+            result = std::max(result, rule.severity);
+            if(issues)
+            {
+                issues->push_back(&rule);
+            }
+            else if(result == Validity::corrupt)
+            {
+                break; //Nothing worse to find
+            }
+        }
+    }
+
+    return result;
+}
+
+}
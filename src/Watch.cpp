@@ -0,0 +1,316 @@
+#include <Watch.h>
+
+#include <Read.h>
+#include <Decompress.h>
+#include <Catalog.h>
+#include <WorkQueue.h>
+
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/** STATIC CONSTANTS **/
+
+static constexpr size_t EVENT_BUFFER_SIZE = 1 << 16;
+static constexpr uint32 WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE_SELF | IN_MOVE_SELF;
+static constexpr int SETTLE_TIME = 1000; ///< ms a file found by a scan must stay unchanged before it is inspected
+
+/** STATIC FUNCTIONS **/
+
+using Clock = std::chrono::steady_clock;
+
+struct WatchItem
+{
+    std::string                 path;           ///< File to be inspected
+    Clock::time_point           notified;       ///< When its notification was read
+};
+
+struct SettlingFile
+{
+    std::uintmax_t              size;           ///< Size when last checked
+    std::filesystem::file_time_type modified;   ///< Modification time when last checked
+    Clock::time_point           checked;        ///< When it was last checked
+};
+
+/**
+ * @brief Records the size and modification time of the file. Returns false 
+ * if it is gone
+ */
+static bool checkFile(const std::string& path, SettlingFile& file)
+{
+    std::error_code error;
+    file.size = std::filesystem::file_size(path, error);
+    file.modified = error ? file.modified : std::filesystem::last_write_time(path, error);
+    file.checked = Clock::now();
+    return !error;
+}
+
+/**
+ * @brief Moves the files that have not changed since they were last checked, 
+ * at least SETTLE_TIME ago, from settling to files. Those that are gone are 
+ * dropped
+ */
+static void settleFiles(std::unordered_map<std::string, SettlingFile>& settling, std::vector<std::string>& files)
+{
+    const auto now = Clock::now();
+    for(auto ite = settling.begin(); ite != settling.end(); )
+    {
+        auto& file = ite->second;
+        if(now - file.checked < std::chrono::milliseconds(SETTLE_TIME))
+        {
+            ++ite;
+            continue;
+        }
+
+        auto current = file;
+        if(!checkFile(ite->first, current))
+        {
+            ite = settling.erase(ite);
+        }
+        else if(current.size == file.size && current.modified == file.modified)
+        {
+            files.push_back(ite->first);
+            ite = settling.erase(ite);
+        }
+        else
+        {
+            file = current;
+            ++ite;
+        }
+    }
+}
+
+/**
+ * @brief Watches the directory and its subdirectories. The MRC files that are
+ * already in them are appended to files. Returns the watch of the directory
+ */
+static int addWatches(  int notify,
+                        const std::string& path,
+                        std::unordered_map<int, std::string>& directories,
+                        std::vector<std::string>* files )
+{
+    namespace fs = std::filesystem;
+
+    const auto addWatch = [notify, &directories] (const std::string& directory)
+    {
+        const auto wd = inotify_add_watch(notify, directory.c_str(), WATCH_MASK | IN_ONLYDIR);
+        if(wd >= 0)
+        {
+            directories[wd] = directory;
+        }
+        return wd;
+    };
+
+    const auto result = addWatch(path);
+    if(result < 0)
+    {
+        return result;
+    }
+
+    std::error_code error;
+    for(auto it = fs::recursive_directory_iterator(path, fs::directory_options::skip_permission_denied, error);
+        it != fs::recursive_directory_iterator(); it.increment(error) )
+    {
+        if(it->is_directory(error))
+        {
+            addWatch(it->path().string());
+        }
+        else if(files && it->is_regular_file(error) && isCatalogPath(it->path().native()))
+        {
+            files->push_back(it->path().string());
+        }
+    }
+
+    return result;
+}
+
+/** PUBLIC FUNCTIONS **/
+
+Inspection inspectFile(const std::string& path)
+{
+    Inspection result = {};
+    result.path = path;
+    result.valid = false;
+    result.validity = Validity::corrupt;
+    result.statistics = makeStatistics();
+
+    Compression compression;
+    std::string extHeader;
+    const auto is = openInputFile(path.c_str(), 1, compression);
+    if(!is)
+    {
+        result.error = "unreadable or unsupported compression";
+    }
+    else if(readMainHeader(*is, result.header) != sizeof(MainHeader))
+    {
+        result.error = "invalid header";
+    }
+    else if(validateHeader(result.header, getValidationContext(*is), &result.issues) == Validity::corrupt)
+    {
+        for(const auto* rule : result.issues)
+        {
+            if(rule->severity == Validity::corrupt)
+            {
+                result.error += result.error.empty() ? "" : "; ";
+                result.error += rule->message;
+            }
+        }
+    }
+    else if(readExtendedHeader(*is, result.header, extHeader) != extHeader.size())
+    {
+        result.error = "truncated extended header";
+    }
+    else if(computeStreamStatistics(*is, result.header, 1, result.statistics) != result.header.dimensions[2])
+    {
+        result.error = "truncated data block";
+    }
+    else
+    {
+        result.valid = true;
+        result.validity = result.issues.empty() ? Validity::valid : Validity::suspicious;
+    }
+
+    result.time = std::time(nullptr);
+    return result;
+}
+
+bool watchDirectory(const char* path, const WatchOptions& options, const InspectionCallback& callback, WatchSummary& summary)
+{
+    const auto notify = inotify_init1(IN_CLOEXEC);
+    if(notify < 0)
+    {
+        return false;
+    }
+
+    std::unordered_map<int, std::string> directories;
+    const auto root = addWatches(notify, path, directories, nullptr);
+    if(root < 0)
+    {
+        close(notify);
+        return false;
+    }
+
+    //Workers inspect the files handed by this thread. When the backlog is full,
+    //pushing blocks and notifications pile up in the kernel until there is room
+    std::atomic<size_t> fileCount = 0;
+    const auto threadCount = std::max<size_t>(options.threadCount, 1);
+    WorkQueue<WatchItem> queue(std::max<size_t>(options.backlog, 1));
+    std::vector<std::thread> workers;
+    for(size_t i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back(
+            [&queue, &callback, &fileCount] ()
+            {
+                while(const auto item = queue.pop())
+                {
+                    auto inspection = inspectFile(item->path);
+                    inspection.latency = std::chrono::duration<float64>(Clock::now() - item->notified).count();
+                    callback(inspection);
+                    ++fileCount;
+                }
+            }
+        );
+    }
+
+    //Files that were already in a new directory when it was watched may still
+    //be being written. They are inspected on their close event or, if none
+    //comes, once they stop changing
+    std::unordered_map<std::string, SettlingFile> settling;
+    std::vector<std::string> found;
+
+    summary.overflowCount = 0;
+    bool gone = false;
+    std::vector<std::string> files;
+    while(!gone)
+    {
+        pollfd request = { notify, POLLIN, 0 };
+        const auto ready = poll(&request, 1, settling.empty() ? options.idleTimeout : SETTLE_TIME);
+        if(ready < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if(ready < 0 || (ready == 0 && settling.empty()))
+        {
+            break; //Idle
+        }
+
+        alignas(inotify_event) char buffer[EVENT_BUFFER_SIZE];
+        const auto length = ready > 0 ? read(notify, buffer, sizeof(buffer)) : 0;
+        const auto notified = Clock::now();
+        for(ssize_t i = 0; i < length; )
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + i);
+            i += sizeof(inotify_event) + event->len;
+
+            const auto ite = directories.find(event->wd);
+            if(event->mask & IN_Q_OVERFLOW)
+            {
+                ++summary.overflowCount;
+            }
+            else if(ite == directories.cend())
+            {
+                continue;
+            }
+            else if(event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED))
+            {
+                gone = gone || event->wd == root;
+                if(event->mask & IN_IGNORED)
+                {
+                    directories.erase(ite);
+                }
+            }
+            else if((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+            {
+                //Files may have landed in it before it was watched
+                addWatches(notify, ite->second + '/' + event->name, directories, &found);
+                for(auto& file : found)
+                {
+                    SettlingFile state = {};
+                    if(checkFile(file, state))
+                    {
+                        settling.emplace(std::move(file), state);
+                    }
+                }
+                found.clear();
+            }
+            else if((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) && isCatalogPath(event->name))
+            {
+                files.push_back(ite->second + '/' + event->name);
+                settling.erase(files.back());
+            }
+        }
+
+        settleFiles(settling, files);
+
+        for(auto& file : files)
+        {
+            queue.push(WatchItem{std::move(file), notified});
+        }
+        files.clear();
+    }
+
+    queue.close();
+    for(auto& worker : workers)
+    {
+        worker.join();
+    }
+    close(notify);
+
+    summary.fileCount = fileCount;
+    return true;
+}
+
+}
@@ -0,0 +1,82 @@
+#include <Write.h>
+
+#include <ByteSwap.h>
+#include <Packed.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace MrcInspector
+{
+
+/** PUBLIC FUNCTIONS **/
+
+size_t writeMainHeader(std::ostream& os, const MainHeader& header)
+{
+    //Fields are already in native order. Only the stamp and the 
+    //exttype need to be stored as BE
+    auto encoded = header;
+    encoded.byteOrder = getNativeEndianess();
+    makeBigEndian(encoded.byteOrder);
+    makeBigEndian(encoded.extHeaderType);
+
+    os.write(reinterpret_cast<const char*>(&encoded), sizeof(encoded));
+    return os.good() ? sizeof(encoded) : 0;
+}
+
+size_t writeExtendedHeader(std::ostream& os, const std::string& extHeader)
+{
+    os.write(extHeader.data(), extHeader.size());
+    return os.good() ? extHeader.size() : 0;
+}
+
+size_t writeData(std::ostream& os, const DataBlock& data)
+{
+    return std::visit(
+        [&os] (const auto& values) -> size_t
+        {
+            const auto nBytes = values.size() * sizeof(typename std::decay<decltype(values)>::type::value_type);
+            os.write(reinterpret_cast<const char*>(values.data()), nBytes);
+            return os.good() ? nBytes : 0;
+        },
+        data
+    );
+}
+
+size_t writeData(std::ostream& os, const MainHeader& header, const DataBlock& data)
+{
+    if(!isPackedMode(header.mode))
+    {
+        return writeData(os, data);
+    }
+
+    const auto* values = std::get_if<std::vector<uint8>>(&data);
+    const size_t nColumns = header.dimensions[0];
+    const auto nRows = getElementCount(header) / std::max<size_t>(nColumns, 1);
+    const auto rowSize = getRowSize(header);
+    if(!values || values->size() != nRows * nColumns)
+    {
+        return 0;
+    }
+
+    std::vector<uint8> packed(rowSize);
+    for(size_t r = 0; r < nRows; ++r)
+    {
+        packNibbles(values->data() + r*nColumns, nColumns, packed.data());
+        os.write(reinterpret_cast<const char*>(packed.data()), rowSize);
+    }
+    return os.good() ? nRows * rowSize : 0;
+}
+
+void appendLabel(MainHeader& header, std::string_view text)
+{
+    if(header.nLabels < header.labels.size())
+    {
+        auto& label = header.labels[header.nLabels++];
+        label.fill(' ');
+        std::memcpy(label.data(), text.data(), std::min(text.size(), label.size()));
+    }
+}
+
+}
@@ -1,13 +1,99 @@
 #include <Read.h>
 #include <Print.h>
+#include <Checksum.h>
+#include <Diff.h>
+#include <Convert.h>
+#include <Write.h>
+#include <Bin.h>
+#include <Npy.h>
+#include <Pgm.h>
+#include <Project.h>
+#include <Transpose.h>
+#include <FileRead.h>
+#include <Parallel.h>
+#include <Decompress.h>
+#include <Seekable.h>
+#include <Region.h>
+#include <Brick.h>
+#include <Pyramid.h>
+#include <Catalog.h>
+#include <Server.h>
+#include <Follow.h>
+#include <Watch.h>
+#include <RollingLog.h>
+#include <MrcFile.h>
+#include <Serialize.h>
+#include <Validate.h>
 
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string_view>
 #include <vector>
 
 using namespace MrcInspector;
 
-static void readAll(std::istream& is, MainHeader& header, std::string& extHeader, DataBlock& data)
+enum class Command
+{
+    dump,
+    header,
+    stats,
+    validate,
+    checksum,
+    diff,
+    convert,
+    bin,
+    project,
+    compress,
+    bricks,
+    region,
+    pyramid,
+    overview,
+    index,
+    query,
+    serve,
+    request,
+    follow,
+    watch,
+};
+
+struct Options
+{
+    Command     command = Command::dump;
+    bool        normalize = false;
+    DiffOptions diffOptions = { 0.0, 0.0, 10, getDefaultThreadCount(), false };
+    ConversionOptions conversionOptions = { Mode::float32, 1.0, 0.0, false, 0.0, 0.0, Rounding::nearest, getDefaultThreadCount() };
+    bool        fit = false;
+    size_t      binFactor = 1;
+    bool        canonical = false;
+    ProjectionOptions projectionOptions = { AxisMapping::z, ProjectionType::sum, getDefaultThreadCount() };
+    Compression codec = Compression::gzip;
+    int         level = -1;
+    size_t      section = std::numeric_limits<size_t>::max();
+    size_t      brickSize = DEFAULT_BRICK_SIZE;
+    bool        slice = false;
+    AxisMapping sliceAxis = AxisMapping::z;
+    size_t      sliceIndex = 0;
+    Region      region = { { 0, 0, 0 }, { 0, 0, 0 } };
+    size_t      levelCount = DEFAULT_PYRAMID_LEVEL_COUNT;
+    float64     resolution = 0.0;
+    size_t      cacheSize = DEFAULT_HEADER_CACHE_SIZE;
+    float64     idleTimeout = -1.0;
+    const char* log = nullptr;
+    size_t      logSize = 64 << 20;
+    size_t      backlog = 0;
+    OutputFormat format = OutputFormat::text;
+    const char* output = nullptr;
+    FileReadOptions fileReadOptions = { ReadBackend::stream, 1 << 20, 32, false, getDefaultThreadCount() };
+    size_t      threadCount = getDefaultThreadCount();
+    std::vector<const char*> files;
+};
+
+static void readHeaders(std::istream& is, MainHeader& header, std::string& extHeader)
 {
     size_t count;
 
@@ -18,7 +104,20 @@ static void readAll(std::istream& is, MainHeader& header, std::string& extHeader
         std::cerr << "Error reading header. Expected 1024B. Read " << count << "B" << std::endl;
         std::terminate();
     }
-    
+
+    //Validate it before its lengths are trusted
+    std::vector<const ValidationRule*> issues;
+    const auto validity = validateHeader(header, getValidationContext(is), &issues);
+    for(const auto* rule : issues)
+    {
+        std::cerr << (rule->severity == Validity::corrupt ? "Error in header: " : "WARNING: ") << rule->message << '\n';
+    }
+    if(validity == Validity::corrupt)
+    {
+        std::cerr << "Refusing to read a corrupt file" << std::endl;
+        std::terminate();
+    }
+
     //Read the extended header
     count = readExtendedHeader(is, header, extHeader);
     if(count != extHeader.size())
@@ -26,21 +125,73 @@ static void readAll(std::istream& is, MainHeader& header, std::string& extHeader
         std::cerr << "Error reading the extended header. Expected " << extHeader.size() << "B. Read " << count << "B" << std::endl;
         std::terminate();
     }
+}
 
-    //Read the data block
-    count = readData(is, header, data);
-    std::visit(
-        [count] (const auto& x)
-        {
-            const auto size = sizeof(typename std::decay<decltype(x)>::type::value_type) * x.size();
-            if(size != count)
-            {
-                std::cerr << "Error reading the data block. Expected " << size << "B. Read " << count << "B" << std::endl;
-                std::terminate();
-            }
-        },
-        data
-    );
+static std::unique_ptr<std::istream> openInput(const char* path, const Options& options, Compression& compression)
+{
+    auto result = openInputFile(path, options.threadCount, compression);
+    if(!result)
+    {
+        std::cerr << "Error opening " << path << ": " << toString(compression) << " compressed files are not supported by this build or are corrupt" << std::endl;
+        std::terminate();
+    }
+
+    return result;
+}
+
+static bool usesFileReader(const Options& options)
+{
+    return options.fileReadOptions.backend != ReadBackend::stream || options.fileReadOptions.direct;
+}
+
+/**
+ * @brief Whether the data block is read by the file readers of --reader and
+ * --direct. The rest of the commands read it from the stream
+ */
+static bool supportsFileReader(const Options& options)
+{
+    switch (options.command)
+    {
+    case Command::dump:
+        return options.section == std::numeric_limits<size_t>::max();
+    case Command::stats:
+    case Command::checksum:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void readAll(std::istream& is, const char* path, Compression compression, MainHeader& header, std::string& extHeader, DataBlock& data, const Options& options)
+{
+    readHeaders(is, header, extHeader);
+
+    //Read the data block. File readers need random access to the raw data
+    size_t count;
+    const bool fileReader = usesFileReader(options);
+    if(fileReader && compression != Compression::none)
+    {
+        std::cerr << "WARNING: " << toString(compression) << " compressed input. Using the stream reader\n";
+    }
+    else if(fileReader && isPackedMode(header.mode))
+    {
+        std::cerr << "WARNING: " << toString(header.mode) << " input. Using the stream reader\n";
+    }
+
+    if(!fileReader || compression != Compression::none || isPackedMode(header.mode))
+    {
+        count = readData(is, header, data);
+    }
+    else
+    {
+        count = readDataFile(path, header, data, options.fileReadOptions);
+        is.seekg(getDataOffset(header) + count);
+    }
+    if(count != getDataSize(header))
+    {
+        std::cerr << "Error reading the data block. Expected " << getDataSize(header) << "B. Read " << count << "B" << std::endl;
+        std::terminate();
+    }
 
     //Check if the EOF was reached
     auto remaining = std::vector<char>(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
@@ -50,34 +201,1381 @@ static void readAll(std::istream& is, MainHeader& header, std::string& extHeader
     }
 }
 
-static void printAll(std::ostream& os, const MainHeader& header, const std::string& extHeader, const DataBlock& data)
+static bool requiresOutput(Command command)
+{
+    switch (command)
+    {
+    case Command::convert:
+    case Command::bin:
+    case Command::project:
+    case Command::compress:
+    case Command::index:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static Rounding parseRounding(std::string_view str)
 {
-    os << "==================== HEADER ====================\n";
-    printHeader(os, header);
-    os << "================ EXTENDED HEADER ===============\n";
-    os << extHeader << '\n';
-    os << "================== DATA BLOCK ==================\n";
-    printData(os, header, data);
+    if(str == "nearest") return Rounding::nearest;
+    if(str == "floor") return Rounding::floor;
+    if(str == "ceil") return Rounding::ceil;
+    if(str == "trunc") return Rounding::truncate;
+
+    std::cerr << "Unknown rounding: " << str << std::endl;
+    std::terminate();
 }
 
-int main(int argc, const char* argv[]) {
-    if(argc < 2) 
+static ReadBackend parseReadBackend(std::string_view str)
+{
+    if(str == "stream") return ReadBackend::stream;
+    if(str == "pread") return ReadBackend::pread;
+    if(str == "uring") return ReadBackend::uring;
+    if(str == "parallel") return ReadBackend::parallel;
+
+    std::cerr << "Unknown reader: " << str << std::endl;
+    std::terminate();
+}
+
+static Compression parseCompression(std::string_view str)
+{
+    if(str == "none") return Compression::none;
+    if(str == "gzip") return Compression::gzip;
+    if(str == "bzip2") return Compression::bzip2;
+    if(str == "zstd") return Compression::zstd;
+
+    std::cerr << "Unknown compression: " << str << std::endl;
+    std::terminate();
+}
+
+static OutputFormat parseOutputFormat(std::string_view str)
+{
+    if(str == "text") return OutputFormat::text;
+    if(str == "json") return OutputFormat::json;
+    if(str == "cbor") return OutputFormat::cbor;
+
+    std::cerr << "Unknown format: " << str << std::endl;
+    std::terminate();
+}
+
+static AxisMapping parseAxis(std::string_view str)
+{
+    if(str == "x") return AxisMapping::x;
+    if(str == "y") return AxisMapping::y;
+    if(str == "z") return AxisMapping::z;
+
+    std::cerr << "Unknown axis: " << str << std::endl;
+    std::terminate();
+}
+
+static ProjectionType parseProjectionType(std::string_view str)
+{
+    if(str == "sum") return ProjectionType::sum;
+    if(str == "mean") return ProjectionType::mean;
+    if(str == "max") return ProjectionType::max;
+
+    std::cerr << "Unknown projection: " << str << std::endl;
+    std::terminate();
+}
+
+static void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options] [mrc file]\n";
+    std::cerr << "       " << program << " --header|--stats|--validate [--format FORMAT] [options] [mrc files]\n";
+    std::cerr << "       " << program << " --checksum [--normalize] [options] [mrc files]\n";
+    std::cerr << "       " << program << " --diff [options] [mrc file] [mrc file]\n";
+    std::cerr << "       " << program << " --convert MODE --output [mrc file] [options] [mrc file]\n";
+    std::cerr << "       " << program << " --bin K --output [mrc|npy file] [options] [mrc file]\n";
+    std::cerr << "       " << program << " --canonical [--output [mrc|npy file]] [options] [mrc file]\n";
+    std::cerr << "       " << program << " --compress CODEC --output [mrcz file] [options] [mrc file]\n";
+    std::cerr << "       " << program << " --build-bricks [--brick-size N] [options] [mrc file]\n";
+    std::cerr << "       " << program << " --slice AXIS INDEX [--output [mrc|npy file]] [options] [mrc file]\n";
+    std::cerr << "       " << program << " --roi X Y Z W H D [--output [mrc|npy file]] [options] [mrc file]\n";
+    std::cerr << "       " << program << " --build-pyramid [--levels N] [options] [mrc file]\n";
+    std::cerr << "       " << program << " --resolution A [--output [mrc|npy file]] [options] [mrc file]\n";
+    std::cerr << "       " << program << " --index --output [catalog file] [options] [files and directories]\n";
+    std::cerr << "       " << program << " --query [catalog file] [FIELD=VALUE, FIELD<VALUE...]\n";
+    std::cerr << "       " << program << " --serve [--cache-size N] [options] [socket]\n";
+    std::cerr << "       " << program << " --request [socket] [header|stats|slice AXIS INDEX|region X Y Z W H D] [mrc file]\n";
+    std::cerr << "       " << program << " --follow [--idle S] [options] [mrc file]\n";
+    std::cerr << "       " << program << " --watch [--log FILE] [--idle S] [options] [directory]\n";
+    std::cerr << "       " << program << " --project AXIS --output [mrc|npy|pgm file] [options] [mrc file]\n";
+    std::cerr << "Options:\n";
+    std::cerr << "  --header            Print only the header and extended header\n";
+    std::cerr << "  --stats             Print the statistics of the data block\n";
+    std::cerr << "  --validate          Classify each file as valid, suspicious or corrupt from its header alone\n";
+    std::cerr << "  --format FORMAT     Output of --header, --stats and --validate: text, json or cbor\n";
+    std::cerr << "  --section Z         Print only the header and the given section\n";
+    std::cerr << "  --compress CODEC    Write a seekable container compressed by sections: none, gzip, bzip2 or zstd\n";
+    std::cerr << "  --level N           Compression level for --compress\n";
+    std::cerr << "  --build-bricks      Build a brick cache next to the file for fast slices and regions\n";
+    std::cerr << "  --brick-size N      Voxels along each side of the bricks of --build-bricks\n";
+    std::cerr << "  --slice AXIS INDEX  Read the plane orthogonal to the x, y or z axis at INDEX\n";
+    std::cerr << "  --roi X Y Z W H D   Read the WxHxD region starting at X, Y, Z\n";
+    std::cerr << "  --build-pyramid     Build a sidecar with 2x, 4x, 8x... downsampled levels\n";
+    std::cerr << "  --levels N          Number of levels of --build-pyramid\n";
+    std::cerr << "  --resolution A      Read the coarsest pyramid level with voxels of at most A angstroms\n";
+    std::cerr << "  --index             Catalog the headers of the given files and directories, refreshing --output\n";
+    std::cerr << "  --query             List the files of a catalog that meet all the conditions\n";
+    std::cerr << "  --serve             Answer header, stats, slice and region requests on a Unix socket\n";
+    std::cerr << "  --cache-size N      Number of files whose headers --serve keeps in memory\n";
+    std::cerr << "  --request           Send a request to a --serve process and print its answer\n";
+    std::cerr << "  --follow            Print the statistics of each section appended to a growing file, then a summary\n";
+    std::cerr << "  --idle S            Stop --follow after S seconds without changes\n";
+    std::cerr << "  --watch             Inspect each MRC file written into a directory tree as it lands\n";
+    std::cerr << "  --log FILE          Append the results of --watch to FILE instead of stdout\n";
+    std::cerr << "  --log-size N        Roll --log over to FILE.1 when it reaches N bytes\n";
+    std::cerr << "  --backlog N         Files --watch queues for its workers before it stops reading notifications\n";
+    std::cerr << "  --canonical         Permute the data to x, y, z order according to the axis mapping\n";
+    std::cerr << "  --checksum          Print a content hash of the header and data block\n";
+    std::cerr << "  --normalize         Hash byte-order-normalized contents, so BE and LE copies match\n";
+    std::cerr << "  --diff              Compare the headers and data blocks of two files\n";
+    std::cerr << "  --atol X            Absolute tolerance for --diff\n";
+    std::cerr << "  --rtol X            Relative tolerance for --diff\n";
+    std::cerr << "  --mismatches N      Number of mismatching voxels reported by --diff\n";
+    std::cerr << "  --equal-nan         Make --diff take NaNs at the same voxel as equal\n";
+    std::cerr << "  --convert MODE      Convert the data block to the given mode number\n";
+    std::cerr << "  --bin K             Average KxKxK blocks into a smaller volume\n";
+    std::cerr << "  --project AXIS      Project the volume along the x, y or z axis\n";
+    std::cerr << "  --reduce OP         Reduction for --project: sum, mean or max\n";
+    std::cerr << "  --output FILE       Output file. NPY or PGM depending on its extension, MRC otherwise\n";
+    std::cerr << "  --scale X           Multiply values by X before converting\n";
+    std::cerr << "  --offset X          Add X to values before converting\n";
+    std::cerr << "  --fit               Scale the header's min/max range to the range of an integer mode\n";
+    std::cerr << "  --clamp LO HI       Clamp values to [LO, HI] before converting\n";
+    std::cerr << "  --round MODE        Rounding for integer modes: nearest, floor, ceil or trunc\n";
+    std::cerr << "  --reader BACKEND    Data block reader: stream, pread, uring or parallel\n";
+    std::cerr << "  --chunk-size N      Size in bytes of each read request of the pread, uring and parallel readers\n";
+    std::cerr << "  --direct            Read the data block bypassing the page cache\n";
+    std::cerr << "  --queue-depth N     Number of reads in flight for the uring reader\n";
+    std::cerr << "  --threads N         Number of worker threads\n";
+}
+
+static Options parseOptions(int argc, const char* argv[])
+{
+    Options result;
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if(arg == "--header")
+        {
+            result.command = Command::header;
+        }
+        else if(arg == "--stats")
+        {
+            result.command = Command::stats;
+        }
+        else if(arg == "--validate")
+        {
+            result.command = Command::validate;
+        }
+        else if(arg == "--format" && i + 1 < argc)
+        {
+            result.format = parseOutputFormat(argv[++i]);
+        }
+        else if(arg == "--section" && i + 1 < argc)
+        {
+            result.section = std::stoul(argv[++i]);
+        }
+        else if(arg == "--compress" && i + 1 < argc)
+        {
+            result.command = Command::compress;
+            result.codec = parseCompression(argv[++i]);
+        }
+        else if(arg == "--level" && i + 1 < argc)
+        {
+            result.level = std::stoi(argv[++i]);
+        }
+        else if(arg == "--build-bricks")
+        {
+            result.command = Command::bricks;
+        }
+        else if(arg == "--brick-size" && i + 1 < argc)
+        {
+            result.brickSize = std::max(std::stoul(argv[++i]), 1UL);
+        }
+        else if(arg == "--slice" && i + 2 < argc)
+        {
+            result.command = Command::region;
+            result.slice = true;
+            result.sliceAxis = parseAxis(argv[++i]);
+            result.sliceIndex = std::stoul(argv[++i]);
+        }
+        else if(arg == "--roi" && i + 6 < argc)
+        {
+            result.command = Command::region;
+            result.slice = false;
+            for(auto& x : result.region.origin) x = std::stoul(argv[++i]);
+            for(auto& x : result.region.size) x = std::stoul(argv[++i]);
+        }
+        else if(arg == "--build-pyramid")
+        {
+            result.command = Command::pyramid;
+        }
+        else if(arg == "--levels" && i + 1 < argc)
+        {
+            result.levelCount = std::max(std::stoul(argv[++i]), 1UL);
+        }
+        else if(arg == "--resolution" && i + 1 < argc)
+        {
+            result.command = Command::overview;
+            result.resolution = std::stod(argv[++i]);
+        }
+        else if(arg == "--index")
+        {
+            result.command = Command::index;
+        }
+        else if(arg == "--query")
+        {
+            result.command = Command::query;
+        }
+        else if(arg == "--serve")
+        {
+            result.command = Command::serve;
+        }
+        else if(arg == "--cache-size" && i + 1 < argc)
+        {
+            result.cacheSize = std::max(std::stoul(argv[++i]), 1UL);
+        }
+        else if(arg == "--request")
+        {
+            result.command = Command::request;
+        }
+        else if(arg == "--follow")
+        {
+            result.command = Command::follow;
+        }
+        else if(arg == "--idle" && i + 1 < argc)
+        {
+            result.idleTimeout = std::stod(argv[++i]);
+        }
+        else if(arg == "--watch")
+        {
+            result.command = Command::watch;
+        }
+        else if(arg == "--log" && i + 1 < argc)
+        {
+            result.log = argv[++i];
+        }
+        else if(arg == "--log-size" && i + 1 < argc)
+        {
+            result.logSize = std::stoul(argv[++i]);
+        }
+        else if(arg == "--backlog" && i + 1 < argc)
+        {
+            result.backlog = std::max(std::stoul(argv[++i]), 1UL);
+        }
+        else if(arg == "--canonical")
+        {
+            result.canonical = true;
+        }
+        else if(arg == "--checksum")
+        {
+            result.command = Command::checksum;
+        }
+        else if(arg == "--normalize")
+        {
+            result.normalize = true;
+        }
+        else if(arg == "--diff")
+        {
+            result.command = Command::diff;
+        }
+        else if(arg == "--atol" && i + 1 < argc)
+        {
+            result.diffOptions.absTolerance = std::stod(argv[++i]);
+        }
+        else if(arg == "--rtol" && i + 1 < argc)
+        {
+            result.diffOptions.relTolerance = std::stod(argv[++i]);
+        }
+        else if(arg == "--mismatches" && i + 1 < argc)
+        {
+            result.diffOptions.maxMismatches = std::stoul(argv[++i]);
+        }
+        else if(arg == "--equal-nan")
+        {
+            result.diffOptions.equalNan = true;
+        }
+        else if(arg == "--convert" && i + 1 < argc)
+        {
+            result.command = Command::convert;
+            result.conversionOptions.mode = static_cast<Mode>(std::stoi(argv[++i]));
+        }
+        else if(arg == "--bin" && i + 1 < argc)
+        {
+            result.command = Command::bin;
+            result.binFactor = std::max(std::stoul(argv[++i]), 1UL);
+        }
+        else if(arg == "--project" && i + 1 < argc)
+        {
+            result.command = Command::project;
+            result.projectionOptions.axis = parseAxis(argv[++i]);
+        }
+        else if(arg == "--reduce" && i + 1 < argc)
+        {
+            result.projectionOptions.type = parseProjectionType(argv[++i]);
+        }
+        else if(arg == "--output" && i + 1 < argc)
+        {
+            result.output = argv[++i];
+        }
+        else if(arg == "--scale" && i + 1 < argc)
+        {
+            result.conversionOptions.scale = std::stod(argv[++i]);
+        }
+        else if(arg == "--offset" && i + 1 < argc)
+        {
+            result.conversionOptions.offset = std::stod(argv[++i]);
+        }
+        else if(arg == "--fit")
+        {
+            result.fit = true;
+        }
+        else if(arg == "--clamp" && i + 2 < argc)
+        {
+            result.conversionOptions.clamp = true;
+            result.conversionOptions.clampMin = std::stod(argv[++i]);
+            result.conversionOptions.clampMax = std::stod(argv[++i]);
+        }
+        else if(arg == "--round" && i + 1 < argc)
+        {
+            result.conversionOptions.rounding = parseRounding(argv[++i]);
+        }
+        else if(arg == "--reader" && i + 1 < argc)
+        {
+            result.fileReadOptions.backend = parseReadBackend(argv[++i]);
+        }
+        else if(arg == "--chunk-size" && i + 1 < argc)
+        {
+            result.fileReadOptions.chunkSize = std::max(std::stoul(argv[++i]), 1UL);
+        }
+        else if(arg == "--direct")
+        {
+            result.fileReadOptions.direct = true;
+        }
+        else if(arg == "--queue-depth" && i + 1 < argc)
+        {
+            result.fileReadOptions.queueDepth = std::max(std::stoul(argv[++i]), 1UL);
+        }
+        else if(arg == "--threads" && i + 1 < argc)
+        {
+            result.threadCount = std::max(std::stoul(argv[++i]), 1UL);
+        }
+        else if(arg.size() > 2 && arg.substr(0, 2) == "--")
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            std::terminate();
+        }
+        else
+        {
+            result.files.push_back(argv[i]);
+        }
+    }
+
+    result.diffOptions.threadCount = result.threadCount;
+    result.conversionOptions.threadCount = result.threadCount;
+    result.projectionOptions.threadCount = result.threadCount;
+    result.fileReadOptions.threadCount = result.threadCount;
+    if( result.files.empty() || 
+        (result.command == Command::diff && result.files.size() != 2) ||
+        (result.command == Command::request && result.files.size() < 2) ||
+        (requiresOutput(result.command) && !result.output) )
     {
-        std::cerr << "Usage: " << argv[0] << " [mrc file]" << std::endl;
+        printUsage(argv[0]);
         std::terminate();
     }
+    if(usesFileReader(result) && !supportsFileReader(result))
+    {
+        std::cerr << "WARNING: --reader and --direct only apply to dumps, --stats and --checksum. Using the stream reader\n";
+    }
 
-    // Open input file
-    std::ifstream file(argv[1], std::ios_base::in | std::ios_base::binary);
+    return result;
+}
 
-    //Read from file
+/**
+ * @brief Prints the checksum of each file. False if any of them is unreadable
+ * or truncated
+ */
+static bool checksumAll(const Options& options)
+{
+    bool result = true;
+    for(const auto* path : options.files)
+    {
+        Compression compression;
+        const auto input = openInput(path, options, compression);
+        const bool fileReader = usesFileReader(options);
+        if(fileReader && compression != Compression::none)
+        {
+            std::cerr << "WARNING: " << toString(compression) << " compressed input. Using the stream reader\n";
+        }
+
+        Checksum checksum;
+        const auto count =  fileReader && compression == Compression::none ?
+                            computeChecksum(*input, path, options.fileReadOptions, checksum, options.normalize) :
+                            computeChecksum(*input, checksum, options.normalize, options.threadCount);
+        if(count == 0)
+        {
+            std::cerr << "Error reading " << path << ": unreadable or corrupt header" << std::endl;
+            result = false;
+            continue;
+        }
+        else if(!checksum.complete)
+        {
+            std::cerr << "Error reading " << path << ": truncated extended header or data block. Read " << count << "B" << std::endl;
+            result = false;
+            continue;
+        }
+
+        if(options.files.size() > 1)
+        {
+            std::cout << path << ":\n";
+        }
+        printChecksum(std::cout, checksum);
+    }
+    return result;
+}
+
+static bool diffAll(std::istream& lhsIs, std::istream& rhsIs, const Options& options)
+{
+    MainHeader lhsHeader, rhsHeader;
+    std::string lhsExtHeader, rhsExtHeader;
+    readHeaders(lhsIs, lhsHeader, lhsExtHeader);
+    readHeaders(rhsIs, rhsHeader, rhsExtHeader);
+
+    std::cout << "==================== HEADER ====================\n";
+    std::vector<HeaderDifference> headerDifferences;
+    diffMainHeader(lhsHeader, rhsHeader, headerDifferences);
+    if(lhsExtHeader != rhsExtHeader)
+    {
+        headerDifferences.push_back(HeaderDifference{"Extended header", "...", "..."});
+    }
+    printHeaderDifferences(std::cout, headerDifferences);
+
+    std::cout << "================== DATA BLOCK ==================\n";
+    DataDifference dataDifference;
+    const auto count = diffData(lhsIs, lhsHeader, rhsIs, rhsHeader, options.diffOptions, dataDifference);
+    if(count != getElementCount(lhsHeader) || count != getElementCount(rhsHeader))
+    {
+        std::cerr << "WARNING: Only " << count << " voxels could be compared\n";
+    }
+    printDataDifference(std::cout, dataDifference);
+
+    return headerDifferences.empty() && dataDifference.mismatchCount == 0 && count == getElementCount(lhsHeader);
+}
+
+static void convertAll(std::istream& is, const Options& options)
+{
+    MainHeader header;
+    std::string extHeader;
+    readHeaders(is, header, extHeader);
+
+    auto conversionOptions = options.conversionOptions;
+    if(getModeSize(conversionOptions.mode) == 0 || isPackedMode(conversionOptions.mode))
+    {
+        std::cerr << "Unsupported mode: " << static_cast<Word>(conversionOptions.mode) << std::endl;
+        std::terminate();
+    }
+    if(options.fit && !fitConversionRange(header, conversionOptions))
+    {
+        std::cerr << "Error fitting the range: the header's min (" << header.min << ") and max (" << header.max << ") are not finite or equal" << std::endl;
+        std::terminate();
+    }
+
+    //Only create the output once the conversion is known to be possible
+    std::ofstream os(options.output, std::ios_base::out | std::ios_base::binary);
+    if(!os)
+    {
+        std::cerr << "Error opening " << options.output << std::endl;
+        std::terminate();
+    }
+
+    //Write the headers. The statistics are not known until the data is converted
+    auto outHeader = makeConvertedHeader(header, conversionOptions);
+    const auto outExtHeader = makeConvertedExtendedHeader(header, extHeader);
+    if(writeMainHeader(os, outHeader) == 0 || writeExtendedHeader(os, outExtHeader) != outExtHeader.size())
+    {
+        std::cerr << "Error writing the headers of " << options.output << std::endl;
+        std::terminate();
+    }
+
+    //Convert the data block
+    auto statistics = makeStatistics();
+    const auto count = convertData(is, header, os, conversionOptions, statistics);
+    const auto expected = getElementCount(header) * getModeSize(conversionOptions.mode);
+    if(count != expected)
+    {
+        std::cerr << "Error converting the data block. Expected " << expected << "B. Wrote " << count << "B" << std::endl;
+        std::terminate();
+    }
+
+    //Rewrite the header with the updated statistics
+    updateHeaderStatistics(outHeader, statistics);
+    os.seekp(0);
+    if(writeMainHeader(os, outHeader) == 0 || !os.flush())
+    {
+        std::cerr << "Error writing the statistics of " << options.output << std::endl;
+        std::terminate();
+    }
+}
+
+static void binAll(std::istream& is, const Options& options)
+{
+    MainHeader header;
+    std::string extHeader;
+    readHeaders(is, header, extHeader);
+
+    std::ofstream os(options.output, std::ios_base::out | std::ios_base::binary);
+    if(!os)
+    {
+        std::cerr << "Error opening " << options.output << std::endl;
+        std::terminate();
+    }
+
+    //Write the headers. The statistics are not known until the data is binned
+    auto outHeader = makeBinnedHeader(header, options.binFactor);
+    const bool npy = isNpyPath(options.output);
+    const auto& dimensions = outHeader.dimensions;
+    const auto written = npy ? 
+        writeNpyHeader(os, outHeader, { dimensions[2], dimensions[1], dimensions[0] }) : 
+        writeMainHeader(os, outHeader);
+    if(written == 0)
+    {
+        std::cerr << "Error writing the headers of " << options.output << std::endl;
+        std::terminate();
+    }
+
+    //Bin the data block
+    auto statistics = makeStatistics();
+    const auto count = binData(is, header, options.binFactor, os, options.threadCount, statistics);
+    const auto expected = getDataSize(outHeader);
+    if(count != expected)
+    {
+        std::cerr << "Error binning the data block. Expected " << expected << "B. Wrote " << count << "B" << std::endl;
+        std::terminate();
+    }
+
+    //Rewrite the header with the updated statistics
+    if(!npy)
+    {
+        updateHeaderStatistics(outHeader, statistics);
+        os.seekp(0);
+        if(writeMainHeader(os, outHeader) == 0 || !os.flush())
+        {
+            std::cerr << "Error writing the statistics of " << options.output << std::endl;
+            std::terminate();
+        }
+    }
+    else if(!os.flush())
+    {
+        std::cerr << "Error writing " << options.output << std::endl;
+        std::terminate();
+    }
+}
+
+static void projectAll(std::istream& is, std::ostream& os, const Options& options)
+{
+    MainHeader header;
+    std::string extHeader;
+    readHeaders(is, header, extHeader);
+
+    //Project the data block
+    DataBlock projection = std::vector<float32>();
+    auto& values = std::get<std::vector<float32>>(projection);
+    const auto count = projectData(is, header, options.projectionOptions, values);
+    if(count != header.dimensions[2])
+    {
+        std::cerr << "Error projecting the data block. Expected " << header.dimensions[2] << " sections. Read " << count << std::endl;
+        std::terminate();
+    }
+
+    //Write it in the requested format
+    const auto dimensions = getProjectionDimensions(header, options.projectionOptions.axis);
+    const auto dataSize = values.size() * sizeof(float32);
+    bool success;
+    if(isPgmPath(options.output))
+    {
+        success = writePgm(os, values.data(), dimensions[0], dimensions[1]) != 0;
+    }
+    else if(isNpyPath(options.output))
+    {
+        success =   writeNpyHeader(os, Mode::float32, { dimensions[1], dimensions[0] }) != 0 &&
+                    writeData(os, projection) == dataSize;
+    }
+    else
+    {
+        auto outHeader = makeProjectionHeader(header, options.projectionOptions);
+        updateHeaderStatistics(outHeader, computeStatistics(projection, options.threadCount));
+        success =   writeMainHeader(os, outHeader) != 0 &&
+                    writeData(os, projection) == dataSize;
+    }
+
+    if(!success)
+    {
+        std::cerr << "Error writing the projection" << std::endl;
+        std::terminate();
+    }
+}
+
+static void compressAll(std::istream& is, std::ostream& os, const Options& options)
+{
+    if(!isCompressionSupported(options.codec))
+    {
+        std::cerr << "Error compressing: " << toString(options.codec) << " is not supported by this build" << std::endl;
+        std::terminate();
+    }
+
+    const auto level = options.level < 0 ? getDefaultCompressionLevel(options.codec) : options.level;
+    const auto count = writeSeekable(is, os, options.codec, level, options.threadCount);
+    if(count == 0)
+    {
+        std::cerr << "Error compressing the file" << std::endl;
+        std::terminate();
+    }
+
+    std::cerr << "Compressed " << count << "B into " << os.tellp() << "B\n";
+}
+
+static void printSection(std::istream& is, const Options& options)
+{
     MainHeader header;
     std::string extHeader;
+    readHeaders(is, header, extHeader);
+    if(options.section >= header.dimensions[2])
+    {
+        std::cerr << "Section " << options.section << " out of range. The file has " << header.dimensions[2] << " sections" << std::endl;
+        std::terminate();
+    }
+
+    //Skip the previous sections. Seekable containers only decompress the requested one
+    const auto offset = options.section * getSectionSize(header);
+    if(!is.seekg(offset, std::ios_base::cur))
+    {
+        is.clear();
+        is.ignore(offset);
+    }
+
     DataBlock data;
-    readAll(file, header, extHeader, data);
+    const auto count = readSections(is, header, 1, data);
+    if(count != getSectionSize(header))
+    {
+        std::cerr << "Error reading the section. Expected " << getSectionSize(header) << "B. Read " << count << "B" << std::endl;
+        std::terminate();
+    }
+
+    auto sectionHeader = header;
+    sectionHeader.dimensions[2] = 1;
+    printHeaders(std::cout, header, extHeader);
+    std::cout << "==================== SECTION ===================\n";
+    printData(std::cout, sectionHeader, data);
+}
 
-    //Print all to stdout
-    printAll(std::cout, header, extHeader, data);
+static void canonicalizeAll(MainHeader& header, std::string& extHeader, DataBlock& data, const Options& options)
+{
+    if(!isValidAxisMapping(header.axisMapping))
+    {
+        std::cerr << "WARNING: Invalid axis mapping. Assuming column=x, row=y, section=z\n";
+    }
+    else if(!isCanonicalAxisMapping(header.axisMapping))
+    {
+        DataBlock canonical;
+        transposeToCanonical(header, data, canonical, options.threadCount);
+        header = makeCanonicalHeader(header);
+        extHeader.resize(header.extHeaderLen);
+        data = std::move(canonical);
+    }
+}
+
+static void exportAll(std::ostream& os, const MainHeader& header, const std::string& extHeader, const DataBlock& data, const Options& options)
+{
+    if(isNpyPath(options.output))
+    {
+        const auto& dimensions = header.dimensions;
+        if(writeNpyHeader(os, header, { dimensions[2], dimensions[1], dimensions[0] }) == 0)
+        {
+            std::cerr << "Error exporting: " << toString(header.mode) << " can not be represented in NPY" << std::endl;
+            std::terminate();
+        }
+        writeData(os, data);
+    }
+    else
+    {
+        //The header is written with the native stamp, so the extended header follows it
+        writeMainHeader(os, header);
+        writeExtendedHeader(os, makeConvertedExtendedHeader(header, extHeader));
+        writeData(os, header, data);
+    }
+
+    os.flush();
+    if(!os)
+    {
+        std::cerr << "Error writing " << options.output << std::endl;
+        std::terminate();
+    }
+}
+
+static void buildBricksAll(std::istream& is, const char* path, const Options& options)
+{
+    MainHeader header;
+    std::string extHeader;
+    readHeaders(is, header, extHeader);
+
+    FileStamp stamp;
+    if(!getFileStamp(path, stamp))
+    {
+        std::cerr << "Error reading the modification time of " << path << std::endl;
+        std::terminate();
+    }
+
+    //Build it aside, so that readers never see a partial cache with a valid header
+    const auto cachePath = options.output ? std::string(options.output) : getBrickCachePath(path);
+    const auto tempPath = cachePath + ".tmp";
+    std::ofstream output(tempPath, std::ios_base::out | std::ios_base::binary);
+    const auto count = buildBrickCache(is, header, options.brickSize, stamp, output, options.threadCount);
+    output.close();
+    if(count != getDataSize(header) || !output)
+    {
+        std::remove(tempPath.c_str());
+        std::cerr << "Error building the brick cache. Expected " << getDataSize(header) << "B. Read " << count << "B" << std::endl;
+        std::terminate();
+    }
+    else if(std::rename(tempPath.c_str(), cachePath.c_str()) != 0)
+    {
+        std::remove(tempPath.c_str());
+        std::cerr << "Error moving the brick cache to " << cachePath << std::endl;
+        std::terminate();
+    }
+}
+
+static void regionAll(std::istream& is, const char* path, const Options& options)
+{
+    MainHeader header;
+    std::string extHeader;
+    readHeaders(is, header, extHeader);
+
+    const auto region = options.slice ? getSliceRegion(header, options.sliceAxis, options.sliceIndex) : options.region;
+    if(!isValidRegion(header, region))
+    {
+        std::cerr << "Region out of the bounds of the volume" << std::endl;
+        std::terminate();
+    }
+
+    //Prefer the brick cache when it is up to date
+    DataBlock data;
+    const auto count = readCachedRegion(path, is, header, region, data);
+    const auto expected = region.size[0] * region.size[1] * region.size[2] * getModeSize(header.mode);
+    if(count != expected)
+    {
+        std::cerr << "Error reading the region. Expected " << expected << "B. Read " << count << "B" << std::endl;
+        std::terminate();
+    }
+
+    auto regionHeader = makeRegionHeader(header, region);
+    if(options.output)
+    {
+        updateHeaderStatistics(regionHeader, computeStatistics(data, options.threadCount));
+        std::ofstream output(options.output, std::ios_base::out | std::ios_base::binary);
+        exportAll(output, regionHeader, std::string(), data, options);
+    }
+    else
+    {
+        printAll(std::cout, regionHeader, std::string(), data);
+    }
+}
+
+static void buildPyramidAll(std::istream& is, const char* path, const Options& options)
+{
+    MainHeader header;
+    std::string extHeader;
+    readHeaders(is, header, extHeader);
+
+    FileStamp stamp;
+    if(!getFileStamp(path, stamp))
+    {
+        std::cerr << "Error reading the modification time of " << path << std::endl;
+        std::terminate();
+    }
+
+    //Build it aside, so that readers never see a partial pyramid with a valid header
+    const auto pyramidPath = options.output ? std::string(options.output) : getPyramidPath(path);
+    const auto tempPath = pyramidPath + ".tmp";
+    std::ofstream output(tempPath, std::ios_base::out | std::ios_base::binary);
+    const auto count = buildPyramid(is, header, getPyramidFactors(options.levelCount), stamp, output, options.threadCount);
+    output.close();
+    if(count != header.dimensions[2] || !output)
+    {
+        std::remove(tempPath.c_str());
+        std::cerr << "Error building the pyramid. Expected " << header.dimensions[2] << " sections. Read " << count << std::endl;
+        std::terminate();
+    }
+    else if(std::rename(tempPath.c_str(), pyramidPath.c_str()) != 0)
+    {
+        std::remove(tempPath.c_str());
+        std::cerr << "Error moving the pyramid to " << pyramidPath << std::endl;
+        std::terminate();
+    }
+}
+
+static void overviewAll(std::istream& is, const char* path, const Options& options)
+{
+    MainHeader header;
+    std::string extHeader;
+    readHeaders(is, header, extHeader);
+
+    //Use the coarsest level that is fine enough, if the pyramid is up to date
+    DataBlock data;
+    size_t count = 0;
+    FileStamp stamp;
+    Pyramid pyramid;
+    std::ifstream pyramidFile(getPyramidPath(path), std::ios_base::in | std::ios_base::binary);
+    const bool validPyramid =   pyramidFile && getFileStamp(path, stamp) && 
+                                readPyramid(pyramidFile, pyramid) && isPyramidValid(pyramid, header, stamp);
+    const auto level = validPyramid ? selectPyramidLevel(pyramid, header, options.resolution) : pyramid.levels.size();
+    if(level < pyramid.levels.size())
+    {
+        std::cerr << "Using the pyramid level binned by " << pyramid.levels[level].factor << "\n";
+        header = pyramid.levels[level].header;
+        extHeader.clear();
+        count = readPyramidLevel(pyramidFile, pyramid.levels[level], data);
+    }
+    else
+    {
+        std::cerr << "Using the full resolution volume\n";
+        count = readData(is, header, data);
+    }
+
+    if(count != getDataSize(header))
+    {
+        std::cerr << "Error reading the data block. Expected " << getDataSize(header) << "B. Read " << count << "B" << std::endl;
+        std::terminate();
+    }
+
+    if(options.output)
+    {
+        std::ofstream output(options.output, std::ios_base::out | std::ios_base::binary);
+        exportAll(output, header, extHeader, data, options);
+    }
+    else
+    {
+        printAll(std::cout, header, extHeader, data);
+    }
+}
+
+static void indexAll(const Options& options)
+{
+    //Start from the previous catalog, if any
+    Catalog catalog;
+    std::ifstream previous(options.output, std::ios_base::in | std::ios_base::binary);
+    if(previous && !readCatalog(previous, catalog))
+    {
+        std::cerr << "WARNING: " << options.output << " is not a valid catalog. Rebuilding it\n";
+        catalog = Catalog();
+    }
+    previous.close();
+
+    const std::vector<std::string> paths(options.files.cbegin(), options.files.cend());
+    const auto count = refreshCatalog(catalog, paths, options.threadCount);
+
+    //Write it aside, so that an interrupted run keeps the previous catalog
+    //and queries never see a partial one
+    const auto tempPath = std::string(options.output) + ".tmp";
+    std::ofstream output(tempPath, std::ios_base::out | std::ios_base::binary);
+    const auto written = writeCatalog(output, catalog);
+    output.close();
+    if(written == 0 || !output)
+    {
+        std::remove(tempPath.c_str());
+        std::cerr << "Error writing the catalog" << std::endl;
+        std::terminate();
+    }
+    else if(std::rename(tempPath.c_str(), options.output) != 0)
+    {
+        std::remove(tempPath.c_str());
+        std::cerr << "Error moving the catalog to " << options.output << std::endl;
+        std::terminate();
+    }
+    std::cerr << "Cataloged " << catalog.paths.size() << " files. Read " << count << " headers\n";
+}
+
+static void queryAll(const Options& options)
+{
+    std::vector<CatalogCondition> conditions;
+    std::vector<size_t> fields;
+    for(size_t i = 1; i < options.files.size(); ++i)
+    {
+        CatalogCondition condition;
+        if(!parseCatalogCondition(options.files[i], condition))
+        {
+            std::cerr << "Invalid condition: " << options.files[i] << std::endl;
+            std::terminate();
+        }
+        conditions.push_back(condition);
+        fields.push_back(condition.field);
+    }
+
+    //Only the columns used by the conditions are read
+    Catalog catalog;
+    std::ifstream input(options.files.front(), std::ios_base::in | std::ios_base::binary);
+    if(!readCatalog(input, catalog, fields.empty() ? std::vector<size_t>{ 0 } : fields))
+    {
+        std::cerr << "Error reading the catalog " << options.files.front() << std::endl;
+        std::terminate();
+    }
+
+    for(const auto row : queryCatalog(catalog, conditions))
+    {
+        std::cout << catalog.paths[row] << '\n';
+    }
+}
+
+template<typename Writer>
+static void serializeFile(Writer& writer, const char* path, const MainHeader& header, const std::string& extHeader, const Statistics* statistics, bool valid)
+{
+    writer.beginObject();
+    writer.key("path");
+    writer.value(path);
+    if(!valid)
+    {
+        writer.key("error");
+        writer.value("unreadable or corrupt header, unsupported compression or truncated data block");
+    }
+    else
+    {
+        writer.key("header");
+        serializeHeader(writer, header);
+        writer.key("extendedHeader");
+        serializeExtendedHeader(writer, header, extHeader);
+        if(statistics)
+        {
+            writer.key("statistics");
+            serializeStatistics(writer, *statistics);
+        }
+    }
+    writer.endObject();
+}
+
+/**
+ * @brief Appends the description of a file to output, and returns false if 
+ * it can not be read. Headers are read without opening the data block
+ */
+static bool describeFile(const char* path, const Options& options, size_t threadCount, std::string& output)
+{
+    MainHeader header;
+    std::string extHeader;
+    auto statistics = makeStatistics();
+    bool result;
+    if(options.command == Command::stats)
+    {
+        MrcFile file;
+        auto fileReadOptions = options.fileReadOptions;
+        fileReadOptions.threadCount = threadCount;
+        result = file.open(path, threadCount);
+        if(result && usesFileReader(options) && file.getCompression() != Compression::none)
+        {
+            std::cerr << "WARNING: " << path << ": " << toString(file.getCompression()) << " compressed input. Using the stream reader\n";
+        }
+        result = result && (usesFileReader(options) ? file.computeStatistics(statistics, fileReadOptions) : file.computeStatistics(statistics));
+        header = file.getHeader();
+        extHeader = file.getExtendedHeader();
+    }
+    else
+    {
+        Compression compression;
+        const auto is = openInputFile(path, 1, compression);
+        result =    is && readMainHeader(*is, header) == sizeof(MainHeader) &&
+                    validateHeader(header, getValidationContext(*is)) != Validity::corrupt &&
+                    readExtendedHeader(*is, header, extHeader) == extHeader.size();
+    }
+
+    const auto* fileStatistics = options.command == Command::stats ? &statistics : nullptr;
+    if(options.format == OutputFormat::text)
+    {
+        if(result)
+        {
+            std::ostringstream os;
+            if(options.files.size() > 1)
+            {
+                os << path << ":\n";
+            }
+            if(fileStatistics)
+            {
+                printStatistics(os, statistics);
+            }
+            else
+            {
+                printHeaders(os, header, extHeader);
+            }
+            output += os.str();
+        }
+    }
+    else if(options.format == OutputFormat::json)
+    {
+        JsonWriter writer(output);
+        serializeFile(writer, path, header, extHeader, fileStatistics, result);
+        output.push_back('\n');
+    }
+    else
+    {
+        CborWriter writer(output);
+        serializeFile(writer, path, header, extHeader, fileStatistics, result);
+    }
+    return result;
+}
+
+/**
+ * @brief Prints the headers or statistics of each file. Batches of files are
+ * described in parallel, each into its own buffer, and written out in order
+ */
+static bool describeAll(const Options& options)
+{
+    constexpr size_t BATCH_SIZE = 256;
+
+    //Threads left over by the files go to reading each of them
+    const auto fileThreadCount = std::max<size_t>(options.threadCount / options.files.size(), 1);
+    std::vector<std::string> outputs(std::min(BATCH_SIZE, options.files.size()));
+    std::vector<uint8> described(outputs.size());
+    bool result = true;
+    for(size_t first = 0; first < options.files.size(); first += BATCH_SIZE)
+    {
+        const auto count = std::min(BATCH_SIZE, options.files.size() - first);
+        parallelFor(
+            count, options.threadCount,
+            [&options, &outputs, &described, first, fileThreadCount] (size_t i)
+            {
+                outputs[i].clear();
+                described[i] = describeFile(options.files[first + i], options, fileThreadCount, outputs[i]);
+            }
+        );
+
+        for(size_t i = 0; i < count; ++i)
+        {
+            result = result && described[i];
+            if(!described[i] && options.format == OutputFormat::text)
+            {
+                std::cout.flush();
+                std::cerr << "Error reading " << options.files[first + i] << ": unreadable or corrupt header, unsupported compression or truncated data block" << std::endl;
+            }
+            std::cout.write(outputs[i].data(), outputs[i].size());
+        }
+    }
+
+    std::cout.flush();
+    return result;
+}
+
+/**
+ * @brief Classifies each file from its main header alone, without reading
+ * the rest of it. False if any is unreadable or corrupt
+ */
+static bool validateAll(const Options& options)
+{
+    constexpr size_t FLUSH_SIZE = 1 << 16;
+
+    std::string buffer;
+    buffer.reserve(2*FLUSH_SIZE);
+    std::vector<const ValidationRule*> issues;
+    bool result = true;
+    for(const auto* path : options.files)
+    {
+        Compression compression;
+        MainHeader header;
+        const auto is = openInputFile(path, 1, compression);
+        const auto read = is && readMainHeader(*is, header) == sizeof(MainHeader);
+        issues.clear();
+        const auto validity = read ? validateHeader(header, getValidationContext(*is), &issues) : Validity::corrupt;
+        result = result && validity != Validity::corrupt;
+
+        if(options.format == OutputFormat::text)
+        {
+            if(!read)
+            {
+                std::cerr << "Error reading " << path << ": unreadable header or unsupported compression" << std::endl;
+                continue;
+            }
+
+            if(options.files.size() > 1)
+            {
+                std::cout << path << ":\n";
+            }
+            printValidation(std::cout, validity, issues);
+            continue;
+        }
+
+        const auto serialize = [&] (auto& writer)
+        {
+            writer.beginObject();
+            writer.key("path");
+            writer.value(path);
+            if(!read)
+            {
+                writer.key("error");
+                writer.value("unreadable header or unsupported compression");
+            }
+            else
+            {
+                writer.key("validation");
+                serializeValidation(writer, validity, issues);
+            }
+            writer.endObject();
+        };
+        if(options.format == OutputFormat::json)
+        {
+            JsonWriter writer(buffer);
+            serialize(writer);
+            buffer.push_back('\n');
+        }
+        else
+        {
+            CborWriter writer(buffer);
+            serialize(writer);
+        }
+
+        if(buffer.size() >= FLUSH_SIZE)
+        {
+            std::cout.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+
+    std::cout.write(buffer.data(), buffer.size());
+    std::cout.flush();
+    return result;
+}
+
+static void serveAll(const Options& options)
+{
+    const auto socketPath = options.files.front();
+    if(!runServer(socketPath, ServerOptions{options.cacheSize, options.threadCount}))
+    {
+        std::cerr << "Error listening on " << socketPath << ". Is it in use?" << std::endl;
+        std::terminate();
+    }
+}
+
+static bool requestAll(const Options& options)
+{
+    //The request is the rest of the arguments
+    std::string request;
+    for(size_t i = 1; i < options.files.size(); ++i)
+    {
+        request += (i > 1 ? " " : "");
+        request += options.files[i];
+    }
+
+    ServerResponse response;
+    if(!sendRequest(options.files.front(), request, response))
+    {
+        std::cerr << "Error sending the request to " << options.files.front() << std::endl;
+        std::terminate();
+    }
+
+    (response.success ? std::cout : std::cerr) << response.text;
+    if(!response.success)
+    {
+        std::cerr << std::endl;
+    }
+    return response.success;
+}
+
+static void followAll(const Options& options)
+{
+    const auto path = options.files.front();
+    const auto idleTimeout = options.idleTimeout < 0.0 ? -1 : static_cast<int>(options.idleTimeout * 1000.0);
+    auto state = makeFollowState();
+    const auto result = followFile(
+        path, FollowOptions{idleTimeout, options.threadCount}, state,
+        [] (size_t section, const Statistics& statistics)
+        {
+            printSectionStatistics(std::cout, section, statistics);
+            std::cout.flush();
+        }
+    );
+
+    if(!result)
+    {
+        std::cerr << "Error following " << path << ". It can not be watched or its layout changed" << std::endl;
+        std::terminate();
+    }
+    printFollowState(std::cout, state);
+}
+
+static void watchAll(const Options& options)
+{
+    const auto path = options.files.front();
+    const auto idleTimeout = options.idleTimeout < 0.0 ? -1 : static_cast<int>(options.idleTimeout * 1000.0);
+    const auto backlog = options.backlog ? options.backlog : options.threadCount * 4;
+
+    std::unique_ptr<RollingLog> log;
+    if(options.log)
+    {
+        log = std::make_unique<RollingLog>(options.log, options.logSize);
+    }
+    std::mutex mutex;
+
+    WatchSummary summary;
+    const auto result = watchDirectory(
+        path, WatchOptions{idleTimeout, options.threadCount, backlog},
+        [&log, &mutex] (const Inspection& inspection)
+        {
+            std::ostringstream line;
+            printInspection(line, inspection);
+            if(log)
+            {
+                log->write(line.str());
+            }
+            else
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                std::cout << line.str() << std::endl;
+            }
+        },
+        summary
+    );
+
+    if(!result)
+    {
+        std::cerr << "Error watching " << path << std::endl;
+        std::terminate();
+    }
+    if(summary.overflowCount)
+    {
+        std::cerr << "WARNING: notifications were dropped " << summary.overflowCount << " times. Some files were not inspected\n";
+    }
+}
+
+int main(int argc, const char* argv[]) {
+    const auto options = parseOptions(argc, argv);
+
+    if(options.command == Command::diff)
+    {
+        Compression lhsCompression, rhsCompression;
+        auto lhsFile = openInput(options.files[0], options, lhsCompression);
+        auto rhsFile = openInput(options.files[1], options, rhsCompression);
+        return diffAll(*lhsFile, *rhsFile, options) ? 0 : 1;
+    }
+
+    if(options.command == Command::index)
+    {
+        indexAll(options);
+        return 0;
+    }
+    else if(options.command == Command::query)
+    {
+        queryAll(options);
+        return 0;
+    }
+
+    if(options.command == Command::serve)
+    {
+        serveAll(options);
+        return 0;
+    }
+    else if(options.command == Command::request)
+    {
+        return requestAll(options) ? 0 : 1;
+    }
+    else if(options.command == Command::follow)
+    {
+        followAll(options);
+        return 0;
+    }
+    else if(options.command == Command::watch)
+    {
+        watchAll(options);
+        return 0;
+    }
+
+    else if(options.command == Command::header || options.command == Command::stats)
+    {
+        return describeAll(options) ? 0 : 1;
+    }
+    else if(options.command == Command::validate)
+    {
+        return validateAll(options) ? 0 : 1;
+    }
+    else if(options.command == Command::checksum)
+    {
+        return checksumAll(options) ? 0 : 1;
+    }
+
+    // Open input file. Compressed files are decompressed transparently
+    Compression compression;
+    auto input = openInput(options.files.front(), options, compression);
+    auto& file = *input;
+
+    if(options.command == Command::dump && options.section != std::numeric_limits<size_t>::max())
+    {
+        printSection(file, options);
+        return 0;
+    }
+    else if(options.command == Command::convert)
+    {
+        convertAll(file, options);
+        return 0;
+    }
+    else if(options.command == Command::bin)
+    {
+        binAll(file, options);
+        return 0;
+    }
+    else if(options.command == Command::bricks)
+    {
+        buildBricksAll(file, options.files.front(), options);
+        return 0;
+    }
+    else if(options.command == Command::region)
+    {
+        regionAll(file, options.files.front(), options);
+        return 0;
+    }
+    else if(options.command == Command::pyramid)
+    {
+        buildPyramidAll(file, options.files.front(), options);
+        return 0;
+    }
+    else if(options.command == Command::overview)
+    {
+        overviewAll(file, options.files.front(), options);
+        return 0;
+    }
+    else if(options.command == Command::compress)
+    {
+        std::ofstream output(options.output, std::ios_base::out | std::ios_base::binary);
+        compressAll(file, output, options);
+        return 0;
+    }
+    else if(options.command == Command::project)
+    {
+        std::ofstream output(options.output, std::ios_base::out | std::ios_base::binary);
+        projectAll(file, output, options);
+        return 0;
+    }
+
+    //Read from file
+    MainHeader header;
+    std::string extHeader;
+    DataBlock data;
+    readAll(file, options.files.front(), compression, header, extHeader, data, options);
+
+    //Permute the axes if requested
+    if(options.canonical)
+    {
+        canonicalizeAll(header, extHeader, data, options);
+    }
+
+    if(options.output)
+    {
+        //Export the (permuted) data
+        std::ofstream output(options.output, std::ios_base::out | std::ios_base::binary);
+        exportAll(output, header, extHeader, data, options);
+    }
+    else
+    {
+        //Print all to stdout
+        printAll(std::cout, header, extHeader, data);
+    }
 
     return 0;
 }
\ No newline at end of file